@@ -0,0 +1,172 @@
+#include <Arduino.h>
+#include "audio_looper.h"
+#include "ima_adpcm.h"
+
+// 立体声一块：L 一个 ADPCM 块，R 一个
+constexpr int kAudioLoopChannelBytes = adpcmBlockBytes(kBlockFrames);
+constexpr int kAudioLoopBlockBytes   = 2 * kAudioLoopChannelBytes;
+constexpr int kAudioLoopMaxBlocks =
+    (int)(kAudioLoopMaxSeconds * kMaxSampleRate / kBlockFrames);
+
+static_assert(kBlockFrames % 2 == 0, "ADPCM packs two samples per byte");
+
+static uint8_t       *gBuf       = nullptr;   // PSRAM
+static int            gLength    = 0;         // loop 长度（块），录完第一遍才有
+static int            gPos       = 0;         // 下一块读写的位置
+static int            gSampleRate = kSampleRate;
+static float          gLevel     = kAudioLoopLevel;
+static AudioLoopState gState     = AUDIO_LOOP_OFF;
+static AdpcmState     gEnc[2];
+static uint32_t       gLastCycles = 0;        // 最近一块 编码 / 解码 的开销
+static bool           gHeld      = false;
+static float          gOldL[kBlockFrames];
+static float          gOldR[kBlockFrames];
+
+static const char *kStateName[] = { "off", "empty", "recording", "playing", "overdub", "stopped" };
+
+bool audioLoopBegin() {
+  if (gBuf == nullptr && psramFound()) {
+    gBuf = (uint8_t *)ps_malloc((size_t)kAudioLoopMaxBlocks * kAudioLoopBlockBytes);
+  }
+  if (gBuf == nullptr) {
+    gState = AUDIO_LOOP_OFF;
+    Serial.println("[AudioLoop] no PSRAM, audio looper disabled");
+    return false;
+  }
+  gState = AUDIO_LOOP_EMPTY;
+  audioLoopClear();
+  return true;
+}
+
+void audioLoopSetRate(int sampleRate) {
+  gSampleRate = sampleRate;
+  audioLoopClear();
+}
+
+void audioLoopHold(bool hold) {
+  gHeld = hold;
+}
+
+static void finishRecording() {
+  gLength = gPos;
+  gPos    = 0;
+  gState  = (gLength > 0) ? AUDIO_LOOP_PLAYING : AUDIO_LOOP_EMPTY;
+}
+
+void audioLoopTap() {
+  switch (gState) {
+    case AUDIO_LOOP_OFF:
+      break;
+    case AUDIO_LOOP_EMPTY:
+      gPos = 0;
+      adpcmReset(gEnc[0]);
+      adpcmReset(gEnc[1]);
+      gState = AUDIO_LOOP_RECORDING;
+      break;
+    case AUDIO_LOOP_RECORDING:
+      finishRecording();
+      break;
+    case AUDIO_LOOP_PLAYING:
+      gState = AUDIO_LOOP_OVERDUB;
+      break;
+    case AUDIO_LOOP_OVERDUB:
+      gState = AUDIO_LOOP_PLAYING;
+      break;
+    case AUDIO_LOOP_STOPPED:
+      audioLoopPlay();
+      break;
+  }
+}
+
+void audioLoopPlay() {
+  if (gState == AUDIO_LOOP_RECORDING) {
+    finishRecording();
+    return;
+  }
+  if (gState == AUDIO_LOOP_OFF || gLength == 0) return;
+  gPos   = 0;
+  gState = AUDIO_LOOP_PLAYING;
+}
+
+void audioLoopStop() {
+  if (gState == AUDIO_LOOP_RECORDING) finishRecording();
+  if (gLength > 0) gState = AUDIO_LOOP_STOPPED;
+}
+
+void audioLoopClear() {
+  gLength = 0;
+  gPos    = 0;
+  if (gState != AUDIO_LOOP_OFF) gState = AUDIO_LOOP_EMPTY;
+}
+
+void audioLoopSetLevel(float level) {
+  gLevel = constrain(level, 0.0f, 1.0f);
+}
+
+AudioLoopState audioLoopState() {
+  return gState;
+}
+
+// 回放叠到现场上；总线已经限过幅，这里只防相加溢出 int16
+static inline float clampUnit(float v) {
+  return fminf(fmaxf(v, -1.0f), 1.0f);
+}
+
+void audioLoopProcess(float *left, float *right, int frames) {
+  if (gHeld) return;
+  if (gState < AUDIO_LOOP_RECORDING || gState == AUDIO_LOOP_STOPPED) return;
+  if (frames != kBlockFrames) return;
+
+  uint32_t t0  = ESP.getCycleCount();
+  uint8_t  *blk = gBuf + (size_t)gPos * kAudioLoopBlockBytes;
+
+  if (gState == AUDIO_LOOP_RECORDING) {
+    adpcmEncodeBlock(left,  frames, gEnc[0], blk);
+    adpcmEncodeBlock(right, frames, gEnc[1], blk + kAudioLoopChannelBytes);
+    gLastCycles = ESP.getCycleCount() - t0;
+    if (++gPos >= kAudioLoopMaxBlocks) finishRecording();   // 录满自动开始播放
+    return;
+  }
+
+  adpcmDecodeBlock(blk,                          frames, gOldL);
+  adpcmDecodeBlock(blk + kAudioLoopChannelBytes, frames, gOldR);
+
+  if (gState == AUDIO_LOOP_OVERDUB) {
+    // 新内容 = 旧 + 现场；输出仍按回放电平
+    for (int i = 0; i < frames; ++i) {
+      float l = left[i], r = right[i];
+      left[i]  = clampUnit(l + gLevel * gOldL[i]);
+      right[i] = clampUnit(r + gLevel * gOldR[i]);
+      gOldL[i] = clampUnit(gOldL[i] + l);
+      gOldR[i] = clampUnit(gOldR[i] + r);
+    }
+    adpcmEncodeBlock(gOldL, frames, gEnc[0], blk);
+    adpcmEncodeBlock(gOldR, frames, gEnc[1], blk + kAudioLoopChannelBytes);
+  } else {
+    for (int i = 0; i < frames; ++i) {
+      left[i]  = clampUnit(left[i]  + gLevel * gOldL[i]);
+      right[i] = clampUnit(right[i] + gLevel * gOldR[i]);
+    }
+  }
+  gLastCycles = ESP.getCycleCount() - t0;
+
+  if (++gPos >= gLength) gPos = 0;
+}
+
+size_t audioLoopMemoryBytes() {
+  return gBuf ? (size_t)kAudioLoopMaxBlocks * kAudioLoopBlockBytes : 0;
+}
+
+void audioLoopPrintStatus() {
+  float blockSec = (float)kBlockFrames / (float)gSampleRate;
+  Serial.print("AudioLoop: ");  Serial.print(kStateName[gState]);
+  Serial.print(", loop ");      Serial.print(gLength * blockSec, 2);
+  Serial.print(" / ");          Serial.print(kAudioLoopMaxBlocks * blockSec, 1);
+  Serial.print(" s, level ");   Serial.println(gLevel, 2);
+  Serial.print("  PSRAM ");     Serial.print((int)audioLoopMemoryBytes());
+  Serial.print(" B (");         Serial.print(kAudioLoopBlockBytes);
+  Serial.print(" B/block vs "); Serial.print(kBlockFrames * 4);
+  Serial.print(" B 16-bit), last block ");
+  Serial.print(gLastCycles);
+  Serial.println(" cycles");
+}
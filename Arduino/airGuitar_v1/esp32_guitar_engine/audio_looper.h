@@ -0,0 +1,52 @@
+#pragma once
+//
+// audio_looper.h
+// ==============================
+// 音频循环录音：录的是总线输出（masterBusProcess 之后，含切音“啪”、音量变化、效果器），
+// 每块编成 IMA-ADPCM 存在 PSRAM，回放时解码叠到现场演奏上。
+//
+//  - 和 event_looper.h 互补：那边录事件（几 KB，可以换音色重放），这边录声音本身
+//  - 按块录：loop 长度是 kBlockFrames 的整数倍，踩一下在下一块生效
+//  - 叠录：本块 = 旧内容 + 现场，重新编码写回原位（每叠一遍多一点 ADPCM 量化噪声）
+//  - 缓冲按 kMaxSampleRate × kAudioLoopMaxSeconds 开机一次性 ps_malloc，
+//    没有 PSRAM 时整个模块关闭
+//  - 编解码开销：bench adpcm；audio loop 命令打印最近一块的 cycles
+//
+// 踩一下（audioLoopTap）：空 → 录音 → 播放 → 叠录 → 播放 → 叠录 ……
+//
+
+#include <stddef.h>
+#include <stdint.h>
+#include "guitar_params.h"
+
+enum AudioLoopState : uint8_t {
+  AUDIO_LOOP_OFF       = 0,   // 没有 PSRAM
+  AUDIO_LOOP_EMPTY     = 1,
+  AUDIO_LOOP_RECORDING = 2,
+  AUDIO_LOOP_PLAYING   = 3,
+  AUDIO_LOOP_OVERDUB   = 4,
+  AUDIO_LOOP_STOPPED   = 5
+};
+
+// 分配 PSRAM 缓冲；没有 PSRAM 返回 false
+bool audioLoopBegin();
+
+// 采样率变了：录下的内容按旧采样率，清空
+void audioLoopSetRate(int sampleRate);
+
+// bench / soak 期间暂停：不录、不放，放开后从原来的块接着走（内容不动）
+void audioLoopHold(bool hold);
+
+void audioLoopTap();
+void audioLoopPlay();
+void audioLoopStop();
+void audioLoopClear();
+void audioLoopSetLevel(float level);
+AudioLoopState audioLoopState();
+
+// 每块一次，放在 masterBusProcess 之后：录 / 叠录 left / right，并把回放加进去。
+// frames 必须等于 kBlockFrames，否则跳过
+void audioLoopProcess(float *left, float *right, int frames);
+
+void   audioLoopPrintStatus();
+size_t audioLoopMemoryBytes();
@@ -0,0 +1,241 @@
+#include "body_convolver.h"
+#include <esp_partition.h>
+
+// 与 partitions.csv 中的 bodyir 分区保持一致
+static const char                   *kIrPartitionLabel   = "bodyir";
+static const esp_partition_subtype_t kIrPartitionSubtype = (esp_partition_subtype_t)0x41;
+static const uint32_t                kIrMagic            = 0x52494741;  // "AGIR"
+
+struct Complex {
+  float re;
+  float im;
+};
+
+// ---- FFT 表（N = kBodyFftSize，第一次 load 时生成） ----
+static Complex  gTwiddle[kBodyFftSize / 2];
+static uint16_t gBitRev[kBodyFftSize];
+static bool     gTablesReady = false;
+
+// ---- 卷积状态 ----
+// H 存满 N 个 bin（立体声要用到 N/2 以上的共轭部分）
+static Complex gIrSpectra[kBodyMaxPartitions][kBodyFftSize];
+static Complex gFdl[kBodyMaxPartitions][kBodyFftSize];  // 频域延迟线（环形）
+static float   gInputL[kBodyFftSize];                   // 上一块 + 当前块
+static float   gInputR[kBodyFftSize];
+static Complex gWork[kBodyFftSize];
+static int     gPartitions = 0;
+static int     gFdlHead    = 0;
+
+static void buildTables() {
+  int bits = 0;
+  while ((1 << bits) < kBodyFftSize) bits++;
+  for (int i = 0; i < kBodyFftSize; ++i) {
+    int r = 0;
+    for (int b = 0; b < bits; ++b) {
+      if (i & (1 << b)) r |= 1 << (bits - 1 - b);
+    }
+    gBitRev[i] = (uint16_t)r;
+  }
+  for (int k = 0; k < kBodyFftSize / 2; ++k) {
+    float a = -2.0f * (float)M_PI * (float)k / (float)kBodyFftSize;
+    gTwiddle[k].re = cosf(a);
+    gTwiddle[k].im = sinf(a);
+  }
+  gTablesReady = true;
+}
+
+// 原地基 2 FFT；inverse 时用共轭旋转因子（不做 1/N，调用方处理）
+static void fft(Complex *x, bool inverse) {
+  for (int i = 0; i < kBodyFftSize; ++i) {
+    int j = gBitRev[i];
+    if (j > i) {
+      Complex t = x[i];
+      x[i] = x[j];
+      x[j] = t;
+    }
+  }
+  for (int len = 2; len <= kBodyFftSize; len <<= 1) {
+    int half   = len >> 1;
+    int stride = kBodyFftSize / len;
+    for (int start = 0; start < kBodyFftSize; start += len) {
+      for (int k = 0; k < half; ++k) {
+        Complex w = gTwiddle[k * stride];
+        if (inverse) w.im = -w.im;
+        Complex &a = x[start + k];
+        Complex &b = x[start + k + half];
+        float tr = b.re * w.re - b.im * w.im;
+        float ti = b.re * w.im + b.im * w.re;
+        b.re = a.re - tr;
+        b.im = a.im - ti;
+        a.re += tr;
+        a.im += ti;
+      }
+    }
+  }
+}
+
+// re + j·im（im 可为 nullptr）→ out 的 N 个 bin
+static void forward(const float *re, const float *im, Complex *out) {
+  for (int i = 0; i < kBodyFftSize; ++i) {
+    out[i].re = re[i];
+    out[i].im = (im != nullptr) ? im[i] : 0.0f;
+  }
+  fft(out, false);
+}
+
+bool bodyConvLoad(int sampleRate) {
+  gPartitions = 0;
+  if (!gTablesReady) buildTables();
+
+  const esp_partition_t *part = esp_partition_find_first(
+      ESP_PARTITION_TYPE_DATA, kIrPartitionSubtype, kIrPartitionLabel);
+  if (part == nullptr) return false;
+
+  // 表头：magic(4) version(2) rate(2) length(4) scale(float 4)，之后 int16
+  uint8_t hdr[16];
+  if (esp_partition_read(part, 0, hdr, sizeof(hdr)) != ESP_OK) return false;
+
+  uint32_t magic, irLen;
+  uint16_t version, irRate;
+  float    scale;
+  memcpy(&magic,   hdr + 0, 4);
+  memcpy(&version, hdr + 4, 2);
+  memcpy(&irRate,  hdr + 6, 2);
+  memcpy(&irLen,   hdr + 8, 4);
+  memcpy(&scale,   hdr + 12, 4);
+  if (magic != kIrMagic || version != 1 || irRate == 0 || irLen == 0 ||
+      sizeof(hdr) + irLen * sizeof(int16_t) > part->size) {
+    Serial.println("[Body] bad IR header, flash data with tools/render_body_ir.py");
+    return false;
+  }
+
+  // 目标长度：kBodyIrMs 或 IR 本身，取短的
+  float    ratio  = (float)irRate / (float)sampleRate;
+  uint32_t outLen = (uint32_t)((float)irLen / ratio);
+  uint32_t maxLen = (uint32_t)(kBodyIrMs * (float)sampleRate / 1000.0f);
+  if (outLen > maxLen) outLen = maxLen;
+  int parts = (int)((outLen + kBlockFrames - 1) / kBlockFrames);
+  if (parts > kBodyMaxPartitions) parts = kBodyMaxPartitions;
+
+  // 逐段：从 flash 读需要的原始 sample 重采样，补零做 FFT。
+  // 降采样时对源 sample 做宽度 ratio 的盒式积分（顺带抗混叠，直达声不会被放大），
+  // 升采样时线性插值再乘 ratio，两种情况低频增益都和原 IR 一致。
+  // 复用 gInputL 当临时 buffer（load 时不在渲染）
+  for (int p = 0; p < parts; ++p) {
+    for (int i = 0; i < kBodyFftSize; ++i) gInputL[i] = 0.0f;
+
+    for (int i = 0; i < kBlockFrames; ++i) {
+      uint32_t n = (uint32_t)(p * kBlockFrames + i);
+      if (n >= outLen) break;
+      float src = (float)n * ratio;
+      float v   = 0.0f;
+
+      if (ratio > 1.0f) {
+        float lo = src - 0.5f * ratio;
+        float hi = src + 0.5f * ratio;
+        int   j0 = (int)floorf(lo + 0.5f);
+        int   j1 = (int)floorf(hi + 0.5f);
+        for (int j = j0; j <= j1; ++j) {
+          if (j < 0 || (uint32_t)j >= irLen) continue;
+          float w = fminf(hi, (float)j + 0.5f) - fmaxf(lo, (float)j - 0.5f);
+          if (w <= 0.0f) continue;
+          int16_t s;
+          esp_partition_read(part, sizeof(hdr) + (uint32_t)j * sizeof(int16_t), &s, sizeof(s));
+          v += w * (float)s;
+        }
+      } else {
+        uint32_t s0 = (uint32_t)src;
+        if (s0 + 1 >= irLen) break;
+        int16_t pair[2];
+        esp_partition_read(part, sizeof(hdr) + s0 * sizeof(int16_t), pair, sizeof(pair));
+        float frac = src - (float)s0;
+        v = ((float)pair[0] + ((float)pair[1] - (float)pair[0]) * frac) * ratio;
+      }
+      gInputL[i] = v * scale;
+    }
+    forward(gInputL, nullptr, gIrSpectra[p]);
+  }
+
+  gPartitions = parts;
+  bodyConvReset();
+  return true;
+}
+
+bool bodyConvReady() {
+  return gPartitions > 0;
+}
+
+int bodyConvPartitions() {
+  return gPartitions;
+}
+
+void bodyConvReset() {
+  for (int i = 0; i < kBodyFftSize; ++i) {
+    gInputL[i] = 0.0f;
+    gInputR[i] = 0.0f;
+  }
+  for (int p = 0; p < kBodyMaxPartitions; ++p) {
+    for (int k = 0; k < kBodyFftSize; ++k) {
+      gFdl[p][k].re = 0.0f;
+      gFdl[p][k].im = 0.0f;
+    }
+  }
+  gFdlHead = 0;
+}
+
+void bodyConvProcess(float *left, float *right) {
+  if (gPartitions == 0) return;
+  const bool stereo = (right != nullptr);
+  const int  bins   = stereo ? kBodyFftSize : kBodyBins;
+
+  // 1) 输入窗口左移一块，放入当前块
+  for (int i = 0; i < kBlockFrames; ++i) {
+    gInputL[i]                = gInputL[i + kBlockFrames];
+    gInputL[i + kBlockFrames] = left[i];
+  }
+  if (stereo) {
+    for (int i = 0; i < kBlockFrames; ++i) {
+      gInputR[i]                = gInputR[i + kBlockFrames];
+      gInputR[i + kBlockFrames] = right[i];
+    }
+  }
+
+  // 2) FFT 放进 FDL 头部（立体声：l + j·r）
+  gFdlHead = (gFdlHead == 0) ? gPartitions - 1 : gFdlHead - 1;
+  forward(gInputL, stereo ? gInputR : nullptr, gFdl[gFdlHead]);
+
+  // 3) 频域乘加：Y = Σ X_{k-p} · H_p
+  for (int k = 0; k < bins; ++k) {
+    gWork[k].re = 0.0f;
+    gWork[k].im = 0.0f;
+  }
+  int slot = gFdlHead;
+  for (int p = 0; p < gPartitions; ++p) {
+    const Complex *x = gFdl[slot];
+    const Complex *h = gIrSpectra[p];
+    for (int k = 0; k < bins; ++k) {
+      gWork[k].re += x[k].re * h[k].re - x[k].im * h[k].im;
+      gWork[k].im += x[k].re * h[k].im + x[k].im * h[k].re;
+    }
+    slot = (slot + 1 == gPartitions) ? 0 : slot + 1;
+  }
+
+  // 4) 单声道按共轭对称补全；IFFT，取后半块（overlap-save）
+  if (!stereo) {
+    for (int k = kBodyBins; k < kBodyFftSize; ++k) {
+      gWork[k].re =  gWork[kBodyFftSize - k].re;
+      gWork[k].im = -gWork[kBodyFftSize - k].im;
+    }
+  }
+  fft(gWork, true);
+
+  const float invN = 1.0f / (float)kBodyFftSize;
+  for (int i = 0; i < kBlockFrames; ++i) {
+    left[i] = gWork[i + kBlockFrames].re * invN;
+  }
+  if (stereo) {
+    for (int i = 0; i < kBlockFrames; ++i) {
+      right[i] = gWork[i + kBlockFrames].im * invN;
+    }
+  }
+}
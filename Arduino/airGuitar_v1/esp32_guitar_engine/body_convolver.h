@@ -0,0 +1,43 @@
+#pragma once
+//
+// body_convolver.h
+// ==============================
+// 琴箱卷积：均匀分块（uniformly partitioned）overlap-save FFT 卷积，
+// 用一段几十 ms 的琴箱脉冲响应（IR）代替两个一阶 ToneState 滤波。
+//
+//  - 块长 B = kBlockFrames，FFT 长 N = 2B
+//  - IR 切成 P = ceil(L / B) 段，每段预先做好 FFT（H_p）
+//  - 每块：输入 FFT 一次放进频域延迟线（FDL），Y = Σ X_{k-p}·H_p，IFFT 一次
+//  - 立体声：IR 是实数，把 L / R 当成一个复信号 l + j·r 的实部 / 虚部，
+//    一次复数 FFT / IFFT 同时算两路（输出实部 = l*h，虚部 = r*h），
+//    代价是频域乘加要算满 N 个 bin，而不是单声道的 N/2+1 个
+//
+// IR 存在 flash 的 "bodyir" 数据分区（tools/render_body_ir.py 生成），
+// 加载时重采样到当前采样率。没有数据时 bodyConvReady() = false，
+// 引擎退回原来的 ToneState 滤波。
+//
+// 每块开销（B = 64, N = 128）：
+//   FFT + IFFT：2 × (7 级 × 64 蝶形) = 896 个复数蝶形
+//   频域乘加  ：P × 65 个复数 MAC（单声道），P × 128（立体声）
+//   P 随采样率：kBodyIrMs = 30ms → 16k: 8 段，22.05k: 11，44.1k: 21，48k: 23
+// 实测值用串口 bench body；超出 kBodyConvMaxLoad 时引擎自动退回 ToneState。
+//
+
+#include <Arduino.h>
+#include "guitar_params.h"
+
+constexpr int kBodyFftSize = 2 * kBlockFrames;
+constexpr int kBodyBins    = kBodyFftSize / 2 + 1;  // 实信号只存 0..N/2
+constexpr int kBodyMaxPartitions =
+    ((int)(kBodyIrMs * kMaxSampleRate / 1000.0f) + kBlockFrames - 1) / kBlockFrames;
+
+// 读 IR、重采样到 sampleRate、计算每段频谱；失败返回 false
+bool bodyConvLoad(int sampleRate);
+bool bodyConvReady();
+int  bodyConvPartitions();
+
+// 清空输入历史和 FDL（切换采样率 / 重新启用时）
+void bodyConvReset();
+
+// 原地处理一块，长度必须是 kBlockFrames；right = nullptr 时只算单声道 left
+void bodyConvProcess(float *left, float *right);
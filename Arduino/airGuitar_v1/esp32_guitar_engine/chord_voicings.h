@@ -0,0 +1,195 @@
+#pragma once
+//
+// chord_voicings.h
+// ==============================
+// 和弦库：每个和弦是一个真实的吉他指法（六根弦各自的品位，或者不弹），
+// 编译期按标准调弦（kStringOpenNotes）换算成每根弦的 MIDI note。
+//
+//   指法字符串从 6 弦（最低音 E，stringIndex 0）写到 1 弦，和吉他谱一样：
+//     'x'        这根弦不弹：扫弦不排队、不起音，voice 保持 inactive，混音直接跳过
+//     '0'..'9'   品位，'a'..'f' = 10..15 品
+//   例：C = "x32010" → - C3 E3 G3 C4 E4
+//
+//  - 以前每个和弦只存 3 个音，按 root-12 / fifth-12 / root / third / fifth / root+12
+//    拼六根弦：属七的“fifth”其实是 b7，Cmaj7 也被拼掉了特色；现在是什么指法就弹什么音
+//  - kChordVoicings 的顺序就是和弦索引，和 guitar_params.h 的 CH_* 对上
+//  - 音高表 kNoteHz 也是编译期算的（连乘 2^(1/12)），起音不再调 powf
+//  - 最低的指法音在最高采样率下要放得进 kMaxKsDelay，编译期检查
+//
+
+#include <stdint.h>
+#include "guitar_params.h"
+
+struct ChordShape {
+  const char *name;    // "C", "Am", "G7", "Dsus4" ...
+  const char *frets;   // 6 弦 → 1 弦，见上
+};
+
+// 顺序要与 guitar_params.h 中的注释 / CH_* 保持一致
+constexpr ChordShape kChordShapes[] = {
+  // Major triads 0..5
+  { "C",     "x32010" },   // 0
+  { "G",     "320003" },   // 1
+  { "D",     "xx0232" },   // 2
+  { "A",     "x02220" },   // 3
+  { "E",     "022100" },   // 4
+  { "F",     "133211" },   // 5
+
+  // Dominant 7ths 6..11
+  { "C7",    "x32310" },   // 6
+  { "G7",    "320001" },   // 7
+  { "D7",    "xx0212" },   // 8
+  { "A7",    "x02020" },   // 9
+  { "E7",    "020100" },   // 10
+  { "B7",    "x21202" },   // 11
+
+  // Minor triads 12..17
+  { "Am",    "x02210" },   // 12
+  { "Em",    "022000" },   // 13
+  { "Dm",    "xx0231" },   // 14
+  { "Bm",    "x24432" },   // 15
+  { "F#m",   "244222" },   // 16
+  { "Gm",    "355333" },   // 17
+
+  // Sus & dim 18..23
+  { "Dsus4", "xx0233" },   // 18
+  { "Gsus4", "330013" },   // 19
+  { "Asus4", "x02230" },   // 20
+  { "Esus4", "022200" },   // 21
+  { "Bdim",  "x2343x" },   // 22
+  { "F#dim", "2342xx" },   // 23
+
+  // 24：Cmaj7
+  { "Cmaj7", "x32000" },   // 24
+
+  // 扩展和弦 25..35（ATmega ALT 组）
+  { "Gmaj7", "320002" },   // 25
+  { "Dmaj7", "xx0222" },   // 26
+  { "Fmaj7", "xx3210" },   // 27
+  { "Am7",   "x02010" },   // 28
+  { "Em7",   "022030" },   // 29
+  { "Dm7",   "xx0211" },   // 30
+  { "Bm7",   "x20202" },   // 31
+  { "Cadd9", "x32033" },   // 32
+  { "Dsus2", "xx0230" },   // 33
+  { "Asus2", "x02200" },   // 34
+  { "E9",    "020102" },   // 35
+};
+static_assert(sizeof(kChordShapes) / sizeof(kChordShapes[0]) == kNumChordIndices,
+              "kChordShapes out of sync with CH_* in guitar_params.h");
+
+// notes[] 里的“不弹”（MIDI note 0 不是吉他能弹的音）
+constexpr uint8_t kMutedString = 0;
+
+struct ChordVoicing {
+  const char *name;
+  uint8_t     notes[kNumStrings];       // 每根弦的 MIDI note，kMutedString = 不弹
+  uint8_t     pickString[kNumStrings];  // 节奏型单拨第 i 根弦时实际拨哪根（不弹的弦换成最近的响弦）
+};
+
+// 'x' → -1，不认识的字符 → -2
+constexpr int chordShapeFret(char c) {
+  return (c == 'x' || c == 'X')  ? -1
+       : (c >= '0' && c <= '9')  ? c - '0'
+       : (c >= 'a' && c <= 'f')  ? c - 'a' + 10
+       : -2;
+}
+
+// 六个字符都认识、至少一根弦响
+constexpr bool chordShapeValid(const char *frets) {
+  int sounding = 0;
+  for (int s = 0; s < kNumStrings; ++s) {
+    if (frets[s] == '\0') return false;
+    int f = chordShapeFret(frets[s]);
+    if (f == -2) return false;
+    if (f >= 0) sounding++;
+  }
+  return frets[kNumStrings] == '\0' && sounding > 0;
+}
+
+constexpr bool chordShapesValid() {
+  for (const ChordShape &shape : kChordShapes) {
+    if (!chordShapeValid(shape.frets)) return false;
+  }
+  return true;
+}
+static_assert(chordShapesValid(), "kChordShapes: bad fret string (6 chars of x / 0-9 / a-f)");
+
+constexpr ChordVoicing buildChordVoicing(const ChordShape &shape) {
+  ChordVoicing v{};
+  v.name = shape.name;
+  for (int s = 0; s < kNumStrings; ++s) {
+    int f = chordShapeFret(shape.frets[s]);
+    v.notes[s] = (f < 0) ? kMutedString : (uint8_t)(kStringOpenNotes[s] + f);
+  }
+  // 不弹的弦：往高音方向找最近的响弦，先找到哪边用哪边（低音弦没按的和弦，拨低音落在根音上）
+  for (int s = 0; s < kNumStrings; ++s) {
+    v.pickString[s] = (uint8_t)s;
+    if (v.notes[s] != kMutedString) continue;
+    for (int d = 1; d < kNumStrings; ++d) {
+      if (s + d < kNumStrings && v.notes[s + d] != kMutedString) {
+        v.pickString[s] = (uint8_t)(s + d);
+        break;
+      }
+      if (s - d >= 0 && v.notes[s - d] != kMutedString) {
+        v.pickString[s] = (uint8_t)(s - d);
+        break;
+      }
+    }
+  }
+  return v;
+}
+
+struct ChordVoicingTable {
+  ChordVoicing chord[kNumChordIndices];
+
+  constexpr const ChordVoicing &operator[](int i) const { return chord[i]; }
+};
+
+constexpr ChordVoicingTable buildChordVoicings() {
+  ChordVoicingTable t{};
+  for (int i = 0; i < kNumChordIndices; ++i) {
+    t.chord[i] = buildChordVoicing(kChordShapes[i]);
+  }
+  return t;
+}
+
+constexpr ChordVoicingTable kChordVoicings = buildChordVoicings();
+
+// MIDI note → Hz（A4 = 440，十二平均律）
+struct NoteHzTable {
+  float hz[128];
+
+  constexpr float operator[](uint8_t note) const { return hz[note & 0x7F]; }
+};
+
+constexpr NoteHzTable buildNoteHzTable() {
+  constexpr double kSemitone = 1.0594630943592953;   // 2^(1/12)
+  NoteHzTable t{};
+  double f = 440.0;
+  for (int n = 69; n < 128; ++n) {
+    t.hz[n] = (float)f;
+    f *= kSemitone;
+  }
+  f = 440.0;
+  for (int n = 68; n >= 0; --n) {
+    f /= kSemitone;
+    t.hz[n] = (float)f;
+  }
+  return t;
+}
+
+constexpr NoteHzTable kNoteHz = buildNoteHzTable();
+
+// 最低的指法音：KS 延迟线（kMaxKsDelay 按 kLowestNoteHz、最高采样率算）要放得下
+constexpr float chordVoicingLowestHz() {
+  float lowest = kNoteHz[127];
+  for (const ChordVoicing &v : kChordVoicings.chord) {
+    for (uint8_t note : v.notes) {
+      if (note != kMutedString && kNoteHz[note] < lowest) lowest = kNoteHz[note];
+    }
+  }
+  return lowest;
+}
+static_assert(chordVoicingLowestHz() >= kLowestNoteHz,
+              "a chord voicing goes below kLowestNoteHz: raise kMaxKsDelay");
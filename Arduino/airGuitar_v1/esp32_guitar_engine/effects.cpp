@@ -0,0 +1,103 @@
+#include <Arduino.h>
+#include "effects.h"
+#include "rate_params.h"
+
+// ============================================================
+// Chorus
+// ============================================================
+
+void Chorus::reset(int sampleRate) {
+  for (int i = 0; i < kChorusLineSamples; ++i) {
+    lineL[i] = 0.0f;
+    lineR[i] = 0.0f;
+  }
+  writePos  = 0;
+  phase     = 0.0f;
+  phaseInc  = kChorusRateHz * (float)kBlockFrames / (float)sampleRate;
+  baseDelay = kChorusDelayMs * 0.001f * (float)sampleRate;
+  depth     = kChorusDepthMs * 0.001f * (float)sampleRate;
+}
+
+// 从环形延迟线读 delay 个 sample 之前的值（线性插值）
+static inline float readFrac(const float *line, int writePos, float delay) {
+  float rp = (float)writePos - delay;
+  if (rp < 0.0f) rp += (float)kChorusLineSamples;
+  int   i0 = (int)rp;
+  float f  = rp - (float)i0;
+  int   i1 = (i0 + 1 == kChorusLineSamples) ? 0 : i0 + 1;
+  return line[i0] + (line[i1] - line[i0]) * f;
+}
+
+void Chorus::process(const float *inL, const float *inR, float *outL, float *outR, int frames) {
+  // LFO 只在块两端算 sin，块内线性插值（0.8 Hz 的 LFO 一块内几乎是直线）
+  const float twoPi = 2.0f * (float)M_PI;
+  float nextPhase = phase + phaseInc;
+  if (nextPhase >= 1.0f) nextPhase -= 1.0f;
+
+  float dL0 = baseDelay + depth * sinf(twoPi * phase);
+  float dL1 = baseDelay + depth * sinf(twoPi * nextPhase);
+  float dR0 = baseDelay + depth * cosf(twoPi * phase);
+  float dR1 = baseDelay + depth * cosf(twoPi * nextPhase);
+  float stepL = (dL1 - dL0) / (float)frames;
+  float stepR = (dR1 - dR0) / (float)frames;
+  phase = nextPhase;
+
+  for (int i = 0; i < frames; ++i) {
+    lineL[writePos] = inL[i];
+    lineR[writePos] = inR[i];
+    float t = (float)(i + 1);
+    outL[i] += kChorusMix * readFrac(lineL, writePos, dL0 + stepL * t);
+    outR[i] += kChorusMix * readFrac(lineR, writePos, dR0 + stepR * t);
+    if (++writePos == kChorusLineSamples) writePos = 0;
+  }
+}
+
+// ============================================================
+// FdnReverb
+// ============================================================
+
+void FdnReverb::reset(int sampleRate) {
+  for (int l = 0; l < kFdnLines; ++l) {
+    int len = (int)(kReverbLineMs[l] * 0.001f * (float)sampleRate);
+    if (len > kFdnLineSamples) len = kFdnLineSamples;
+    length[l] = len;
+    pos[l]    = 0;
+    damp[l]   = 0.0f;
+    // 每绕一圈衰减：-60 dB / T60 → g = 10^(-3·len / (T60·fs))
+    gain[l]   = powf(10.0f, -3.0f * (float)len / (kReverbT60Sec * (float)sampleRate));
+    for (int i = 0; i < kFdnLineSamples; ++i) line[l][i] = 0.0f;
+  }
+  dampAlpha = onePoleAlpha(kReverbDampHz, sampleRate);
+}
+
+void FdnReverb::process(const float *inL, const float *inR, float *outL, float *outR, int frames) {
+  for (int i = 0; i < frames; ++i) {
+    float in = 0.5f * (inL[i] + inR[i]);
+
+    // 1) 读四条线的输出，过阻尼低通，乘衰减
+    float y[kFdnLines];
+    for (int l = 0; l < kFdnLines; ++l) {
+      float v = line[l][pos[l]];
+      damp[l] += dampAlpha * (v - damp[l]);
+      // 输入停了以后整个网络靠 damp 收尾：它归零，线里写回的也就是 0
+      if (fabsf(damp[l]) < kStateFlushFloor) damp[l] = 0.0f;
+      y[l] = damp[l] * gain[l];
+    }
+
+    // 2) 4×4 Hadamard（/2 保持能量），加输入写回
+    float a = y[0] + y[1], b = y[0] - y[1];
+    float c = y[2] + y[3], d = y[2] - y[3];
+    line[0][pos[0]] = 0.5f * (a + c) + in;
+    line[1][pos[1]] = 0.5f * (b + d) - in;
+    line[2][pos[2]] = 0.5f * (a - c) + in;
+    line[3][pos[3]] = 0.5f * (b - d) - in;
+
+    for (int l = 0; l < kFdnLines; ++l) {
+      if (++pos[l] == length[l]) pos[l] = 0;
+    }
+
+    // 3) 不同线组合成 L / R，去相关
+    outL[i] += kReverbMix * (y[0] + y[2]);
+    outR[i] += kReverbMix * (y[1] + y[3]);
+  }
+}
@@ -0,0 +1,60 @@
+#pragma once
+//
+// effects.h
+// ==============================
+// 块处理效果器，给 effects_chain.h 的 EffectsChain<...> 组合用。
+//
+// 约定（每个效果器都一样）：
+//   static constexpr const char *kName;
+//   void reset(int sampleRate);      // 清状态、按采样率重算系数
+//   void process(const float *inL, const float *inR,
+//                float *outL, float *outR, int frames);
+//     —— 读同一路送出信号（send），把自己的湿声“加”到 out 上，
+//        干声不经过这里（干声在渲染核直接出）
+//
+// 延迟线按 kMaxSampleRate 静态分配，换采样率不需要重新分配内存。
+//
+
+#include "guitar_params.h"
+
+// -----------------------------------------------------------------------------
+// Chorus：L / R 各一条调制延迟，LFO 按块算端点、块内线性插值
+// -----------------------------------------------------------------------------
+
+constexpr int kChorusLineSamples = (int)(kChorusMaxMs * kMaxSampleRate / 1000.0f) + 2;
+
+struct Chorus {
+  static constexpr const char *kName = "chorus";
+
+  float lineL[kChorusLineSamples];
+  float lineR[kChorusLineSamples];
+  int   writePos;
+  float phase;        // 0..1
+  float phaseInc;     // 每块
+  float baseDelay;    // samples
+  float depth;        // samples
+
+  void reset(int sampleRate);
+  void process(const float *inL, const float *inR, float *outL, float *outR, int frames);
+};
+
+// -----------------------------------------------------------------------------
+// FdnReverb：4 线反馈延迟网络，Hadamard 混合，每条线一阶低通阻尼
+// -----------------------------------------------------------------------------
+
+constexpr int kFdnLines       = 4;
+constexpr int kFdnLineSamples = (int)(kReverbMaxLineMs * kMaxSampleRate / 1000.0f) + 1;
+
+struct FdnReverb {
+  static constexpr const char *kName = "reverb";
+
+  float line[kFdnLines][kFdnLineSamples];
+  int   length[kFdnLines];
+  int   pos[kFdnLines];
+  float gain[kFdnLines];      // 每条线绕一圈的衰减，由 RT60 算出
+  float damp[kFdnLines];      // 阻尼低通状态
+  float dampAlpha;
+
+  void reset(int sampleRate);
+  void process(const float *inL, const float *inR, float *outL, float *outR, int frames);
+};
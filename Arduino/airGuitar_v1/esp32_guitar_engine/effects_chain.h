@@ -0,0 +1,106 @@
+#pragma once
+//
+// effects_chain.h
+// ==============================
+// 效果器链的两个积木（header-only）：
+//
+//  - StereoBlock / BlockRing<Depth>：单生产者单消费者的无锁块环形缓冲，
+//    渲染核写、效果核读（或反过来）。只用两个原子下标，不加锁、不等待，
+//    满了 push 返回 false，空了 pop 返回 false，由调用方计数。
+//
+//  - EffectsChain<Effects...>：编译期组合的效果器链（和 KSVoice<Features...>
+//    一样用多继承把各效果器的状态拼在一个对象里）。process() 依次调用
+//    每个效果器（约定见 effects.h），并分别记下每个效果器的 cycle 开销。
+//
+// 用法：
+//   using EngineFx = EffectsChain<Chorus, FdnReverb>;
+//
+
+#include <Arduino.h>
+#include <atomic>
+#include "guitar_params.h"
+
+struct StereoBlock {
+  uint32_t stamp;                 // 送出时的 sample 计数，用来算延迟
+  float    left[kBlockFrames];
+  float    right[kBlockFrames];
+};
+
+template <int Depth>
+struct BlockRing {
+  static_assert((Depth & (Depth - 1)) == 0, "BlockRing depth must be a power of two");
+
+  StereoBlock           slots[Depth];
+  std::atomic<uint32_t> head{0};  // 只有生产者写
+  std::atomic<uint32_t> tail{0};  // 只有消费者写
+
+  void clear() {
+    head.store(0, std::memory_order_relaxed);
+    tail.store(0, std::memory_order_relaxed);
+  }
+
+  int count() const {
+    return (int)(head.load(std::memory_order_acquire) - tail.load(std::memory_order_acquire));
+  }
+
+  // 生产者：拿到下一个空位，填好后 commit()
+  StereoBlock *beginPush() {
+    uint32_t h = head.load(std::memory_order_relaxed);
+    if (h - tail.load(std::memory_order_acquire) >= (uint32_t)Depth) return nullptr;
+    return &slots[h & (Depth - 1)];
+  }
+  void commitPush() {
+    head.store(head.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+  }
+
+  // 消费者：看最早的一块，用完后 release()
+  const StereoBlock *peek() {
+    uint32_t t = tail.load(std::memory_order_relaxed);
+    if (head.load(std::memory_order_acquire) == t) return nullptr;
+    return &slots[t & (Depth - 1)];
+  }
+  void releasePop() {
+    tail.store(tail.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+  }
+};
+
+template <typename... Effects>
+struct EffectsChain : Effects... {
+  static constexpr int kCount = sizeof...(Effects);
+
+  uint32_t lastCycles[kCount];    // 最近一块每个效果器的 cycle
+  float    avgCycles[kCount];     // 平滑后的 cycle/块
+
+  static const char *name(int i) {
+    static const char *const kNames[] = { Effects::kName... };
+    return kNames[i];
+  }
+
+  void reset(int sampleRate) {
+    (Effects::reset(sampleRate), ...);
+    for (int i = 0; i < kCount; ++i) {
+      lastCycles[i] = 0;
+      avgCycles[i]  = 0.0f;
+    }
+  }
+
+  // out 先清零，各效果器把湿声累加进去
+  void process(const float *inL, const float *inR, float *outL, float *outR, int frames) {
+    for (int i = 0; i < frames; ++i) {
+      outL[i] = 0.0f;
+      outR[i] = 0.0f;
+    }
+    int idx = 0;
+    (runOne<Effects>(idx++, inL, inR, outL, outR, frames), ...);
+  }
+
+ private:
+  template <typename E>
+  void runOne(int idx, const float *inL, const float *inR, float *outL, float *outR, int frames) {
+    uint32_t t0 = ESP.getCycleCount();
+    E::process(inL, inR, outL, outR, frames);
+    uint32_t c = ESP.getCycleCount() - t0;
+    lastCycles[idx] = c;
+    avgCycles[idx] += 0.05f * ((float)c - avgCycles[idx]);
+  }
+};
@@ -0,0 +1,158 @@
+#include <Arduino.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include "effects_task.h"
+#include "rate_params.h"
+
+static const int kFxTaskCore     = 0;
+static const int kFxTaskPriority = 2;      // 比 loopTask（1）高，块处理不被饿死
+static const int kFxTaskStack    = 4096;
+
+struct FxStats {
+  uint32_t sent;
+  uint32_t dropped;        // send ring 满
+  uint32_t returned;
+  uint32_t underruns;      // 该加湿声时 return ring 是空的
+  uint32_t latency;        // 最近一块的延迟（samples）
+  uint32_t latencyMax;
+  float    taskCycles;     // 效果核每块平均 cycle（整条链）
+};
+
+static EngineFx                  gFx;
+static BlockRing<kFxRingBlocks>  gSendRing;
+static BlockRing<kFxRingBlocks>  gReturnRing;
+static TaskHandle_t              gFxTask    = nullptr;
+static std::atomic<bool>         gFxRun{false};
+static std::atomic<bool>         gFxBusy{false};
+static bool                      gFxEnabled = kFxEnabledDefault;
+static FxStats                   gFxStats;
+
+static void fxTask(void *) {
+  for (;;) {
+    // 渲染核每送一块通知一次；超时只是为了暂停时能及时让出
+    ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(10));
+
+    gFxBusy = true;
+    if (!gFxRun) {
+      gFxBusy = false;
+      continue;
+    }
+
+    const StereoBlock *in;
+    while ((in = gSendRing.peek()) != nullptr) {
+      StereoBlock *out = gReturnRing.beginPush();
+      if (out == nullptr) break;   // 渲染核还没取走，下次再处理
+
+      uint32_t t0 = ESP.getCycleCount();
+      out->stamp = in->stamp;
+      gFx.process(in->left, in->right, out->left, out->right, kBlockFrames);
+      gFxStats.taskCycles += 0.05f * ((float)(ESP.getCycleCount() - t0) - gFxStats.taskCycles);
+
+      gReturnRing.commitPush();
+      gSendRing.releasePop();
+    }
+    gFxBusy = false;
+  }
+}
+
+void fxPause() {
+  gFxRun = false;
+  while (gFxBusy) {
+    delay(1);
+  }
+}
+
+void fxReconfigure(int sampleRate) {
+  fxPause();
+  gFx.reset(sampleRate);
+  gSendRing.clear();
+  gReturnRing.clear();
+  memset(&gFxStats, 0, sizeof(gFxStats));
+  gFxRun = gFxEnabled;
+}
+
+void fxBegin(int sampleRate) {
+  fxReconfigure(sampleRate);
+  if (gFxTask == nullptr) {
+    xTaskCreatePinnedToCore(fxTask, "fx", kFxTaskStack, nullptr,
+                            kFxTaskPriority, &gFxTask, kFxTaskCore);
+  }
+}
+
+void fxSetEnabled(bool on) {
+  gFxEnabled = on;
+  fxReconfigure(gRate.sampleRate);   // 打开时从干净的状态开始，不带旧的混响尾巴
+}
+
+bool fxEnabled() {
+  return gFxEnabled;
+}
+
+void fxSend(const float *left, const float *right, uint32_t stamp) {
+  if (!gFxEnabled) return;
+
+  StereoBlock *blk = gSendRing.beginPush();
+  if (blk == nullptr) {
+    gFxStats.dropped++;
+    return;
+  }
+  blk->stamp = stamp;
+  memcpy(blk->left,  left,  sizeof(blk->left));
+  memcpy(blk->right, right, sizeof(blk->right));
+  gSendRing.commitPush();
+  gFxStats.sent++;
+
+  if (gFxTask != nullptr) xTaskNotifyGive(gFxTask);
+}
+
+void fxMixReturn(float *left, float *right, uint32_t now) {
+  if (!gFxEnabled) return;
+
+  // 每块最多加一块湿声，延迟保持稳定
+  const StereoBlock *wet = gReturnRing.peek();
+  if (wet == nullptr) {
+    if (gFxStats.sent > 0) gFxStats.underruns++;
+    return;
+  }
+  for (int i = 0; i < kBlockFrames; ++i) {
+    left[i]  += wet->left[i];
+    right[i] += wet->right[i];
+  }
+  gFxStats.latency = now - wet->stamp;
+  if (gFxStats.latency > gFxStats.latencyMax) gFxStats.latencyMax = gFxStats.latency;
+  gFxStats.returned++;
+  gReturnRing.releasePop();
+}
+
+void fxPrintStats() {
+  float cpuHz  = (float)ESP.getCpuFreqMHz() * 1e6f;
+  float budget = cpuHz * (float)kBlockFrames / (float)gRate.sampleRate;
+
+  Serial.print("Fx: ");
+  Serial.print(gFxEnabled ? "on" : "off");
+  Serial.print(" (core ");       Serial.print(kFxTaskCore);
+  Serial.print("), latency ");   Serial.print((float)gFxStats.latency / gRate.samplesPerMs, 1);
+  Serial.print(" ms (max ");     Serial.print((float)gFxStats.latencyMax / gRate.samplesPerMs, 1);
+  Serial.println(" ms)");
+  Serial.print("  blocks sent ");  Serial.print(gFxStats.sent);
+  Serial.print(", returned ");     Serial.print(gFxStats.returned);
+  Serial.print(", dropped ");      Serial.print(gFxStats.dropped);
+  Serial.print(", underruns ");    Serial.println(gFxStats.underruns);
+  for (int i = 0; i < EngineFx::kCount; ++i) {
+    Serial.print("  ");            Serial.print(EngineFx::name(i));
+    Serial.print(": ");            Serial.print(gFx.avgCycles[i], 0);
+    Serial.print(" cyc/block (");  Serial.print(100.0f * gFx.avgCycles[i] / budget, 1);
+    Serial.println("% of core 0)");
+  }
+  Serial.print("  chain total: ");  Serial.print(gFxStats.taskCycles, 0);
+  Serial.print(" cyc/block (");     Serial.print(100.0f * gFxStats.taskCycles / budget, 1);
+  Serial.println("%)");
+}
+
+EngineFx &fxChain() {
+  return gFx;
+}
+
+size_t fxMemoryBytes() {
+  return sizeof(gFx) + sizeof(gSendRing) + sizeof(gReturnRing);
+}
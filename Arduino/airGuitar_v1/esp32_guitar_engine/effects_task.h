@@ -0,0 +1,41 @@
+#pragma once
+//
+// effects_task.h
+// ==============================
+// 效果器链跑在另一个核（core 0，Arduino loop 在 core 1）：
+//
+//   渲染核（loop）                         效果核（fxTask）
+//   renderBlock → 琴箱后 ──send ring──▶  EffectsChain<Chorus, FdnReverb>
+//        ▲                                       │
+//        └──── 湿声加回，进总线 ◀──return ring───┘
+//
+//  - 两个 BlockRing 都是单生产者单消费者，渲染核从不等待效果核：
+//    send 满了丢块（计数），return 空了这块不加湿声（计数）
+//  - 湿声比干声晚 1~2 块（stamp 记录送出时刻，stats 报实际延迟）
+//  - 改采样率 / 开关时先让效果核停在块边界，再清状态
+//
+
+#include "effects.h"
+#include "effects_chain.h"
+
+using EngineFx = EffectsChain<Chorus, FdnReverb>;
+
+// 建任务（只建一次）并按 sampleRate 初始化
+void fxBegin(int sampleRate);
+
+// 暂停效果核、清空效果器和两个 ring、按新采样率重算，再继续
+void fxReconfigure(int sampleRate);
+
+void fxSetEnabled(bool on);
+bool fxEnabled();
+
+// 渲染核每块调用：送出干声 / 把已处理好的湿声加回（stamp = 当前 sample 计数）
+void fxSend(const float *left, const float *right, uint32_t stamp);
+void fxMixReturn(float *left, float *right, uint32_t now);
+
+void fxPrintStats();
+
+// bench 用：暂停效果核后直接在调用核上跑链，测完调用 fxReconfigure 恢复
+void      fxPause();
+EngineFx &fxChain();
+size_t    fxMemoryBytes();
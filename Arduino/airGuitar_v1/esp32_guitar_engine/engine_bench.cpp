@@ -0,0 +1,626 @@
+#include <Arduino.h>
+#include <new>
+#include "engine_bench.h"
+#include "guitar_params.h"
+#include "rate_params.h"
+#include "ks_voice.h"
+#include "wavetable_voice.h"
+#include "body_convolver.h"
+#include "master_bus.h"
+#include "effects_task.h"
+#include "noise_gen.h"
+#include "ima_adpcm.h"
+#include "audio_looper.h"
+#include "param_store.h"
+#include "chord_voicings.h"
+
+// 每项测试渲染的 sample 数（16k 下约 1 秒音频）
+static const int kBenchSamples = 16000;
+
+// 防止编译器把测试循环优化掉
+static volatile float gBenchSink = 0.0f;
+
+// 测试输入（块 / 激励）用自己的噪声源；弦起音（KSVoice::excite）照样取 gNoise，
+// 所以 runBenchmarks 测完把 gNoise 恢复原样
+static NoiseGen gBenchNoise = { 0x12345678u };
+
+struct BenchEntry {
+  const char *name;
+  const char *desc;
+  void      (*fn)();
+};
+
+static void printCost(const char *label, uint32_t cycles, uint32_t samples) {
+  float perSample = (float)cycles / (float)samples;
+  float cpuPct    = perSample * (float)gRate.sampleRate
+                    / ((float)ESP.getCpuFreqMHz() * 1e6f) * 100.0f;
+  Serial.printf("  %-28s %9.1f cyc/sample  %6.2f %% CPU @ %d Hz\n",
+                label, perSample, cpuPct, gRate.sampleRate);
+}
+
+static void printFootprint(const char *label, size_t ramBytes, size_t flashBytes) {
+  Serial.printf("  %-28s RAM %7u B   flash data %8u B\n",
+                label, (unsigned)ramBytes, (unsigned)flashBytes);
+}
+
+// -----------------------------------------------------------------------------
+// voice：KS vs wavetable 单 voice 开销 & 占用
+// -----------------------------------------------------------------------------
+
+static KSString       gBenchKs;
+static WavetableVoice gBenchWt;
+
+static void benchVoices() {
+  const float   kFreq = 110.0f;  // A2，接近最长的延迟线
+  const uint8_t kNote = 45;
+  const float   kVel  = 0.8f;
+
+  // ---- KS ----
+  uint32_t t0 = ESP.getCycleCount();
+  for (int i = 0; i < 16; ++i) {
+    gBenchKs.pluck(kFreq, kKsDecayMax, kBaseNoiseTargetRms);
+  }
+  uint32_t ksPluck = (ESP.getCycleCount() - t0) / 16;
+
+  // 还在响的弦再拨，音高在 A2 / E4 之间来回换：只动新长度那么多点
+  t0 = ESP.getCycleCount();
+  for (int i = 0; i < 16; ++i) {
+    gBenchKs.repluck((i & 1) ? kFreq : 3.0f * kFreq, kKsDecayMax, kBaseNoiseTargetRms,
+                     1.0f, kRepluckKeep);
+  }
+  uint32_t ksRepluck = (ESP.getCycleCount() - t0) / 16;
+
+  float acc = 0.0f;
+  t0 = ESP.getCycleCount();
+  for (int i = 0; i < kBenchSamples; ++i) {
+    acc += gBenchKs.process();
+  }
+  uint32_t ksCycles = ESP.getCycleCount() - t0;
+  gBenchSink = acc;
+
+  printCost("KS voice", ksCycles, kBenchSamples);
+  Serial.printf("  %-28s %9u cyc/pluck\n", "KS pluck (init)", (unsigned)ksPluck);
+  Serial.printf("  %-28s %9u cyc/pluck\n", "KS repluck (A2 / E4 mix)", (unsigned)ksRepluck);
+  printFootprint("KS backend", sizeof(KSString) * kNumStrings, 0);
+
+  // ---- Wavetable ----
+  if (!wavetableReady() && !wavetableBegin()) {
+    Serial.println("  wavetable: no data partition, skipped");
+    return;
+  }
+
+  t0 = ESP.getCycleCount();
+  for (int i = 0; i < 16; ++i) {
+    initWavetableVoice(gBenchWt, kNote, 0.0f, kVel);
+  }
+  uint32_t wtPluck = (ESP.getCycleCount() - t0) / 16;
+
+  // 音色比测试短时重新起音（起音里含一次 flash 读取），计入总开销
+  acc = 0.0f;
+  t0 = ESP.getCycleCount();
+  for (int i = 0; i < kBenchSamples; ++i) {
+    if (!gBenchWt.active) {
+      initWavetableVoice(gBenchWt, kNote, 0.0f, kVel);
+    }
+    acc += processWavetableVoice(gBenchWt);
+  }
+  uint32_t wtCycles = ESP.getCycleCount() - t0;
+  gBenchSink = acc;
+
+  printCost("wavetable voice", wtCycles, kBenchSamples);
+  Serial.printf("  %-28s %9u cyc/pluck\n", "wavetable pluck (init)", (unsigned)wtPluck);
+  printFootprint("wavetable backend",
+                 sizeof(WavetableVoice) * kNumStrings + wavetableIndexBytes(),
+                 wavetableFlashBytes());
+}
+
+// -----------------------------------------------------------------------------
+// ksfeat：KSVoice<Features...> 各特性组合的每 sample 开销
+// -----------------------------------------------------------------------------
+
+using KSAllFeatures = KSVoice<KSPickPosition, KSBrightness, KSStiffness, KSFractionalTuning>;
+
+// 所有组合共用一块内存（placement new），不为每个组合各占 3KB
+alignas(KSAllFeatures) static uint8_t gBenchVoiceMem[sizeof(KSAllFeatures)];
+
+template <typename V>
+static void benchKsCombo(const char *label) {
+  V *v = new (gBenchVoiceMem) V();
+
+  uint32_t t0 = ESP.getCycleCount();
+  for (int i = 0; i < 16; ++i) {
+    v->pluck(110.0f, kKsDecayMax, kBaseNoiseTargetRms, 0.8f);
+  }
+  uint32_t pluckCycles = (ESP.getCycleCount() - t0) / 16;
+
+  float acc = 0.0f;
+  t0 = ESP.getCycleCount();
+  for (int i = 0; i < kBenchSamples; ++i) {
+    acc += v->process();
+  }
+  uint32_t cycles = ESP.getCycleCount() - t0;
+  gBenchSink = acc;
+
+  printCost(label, cycles, kBenchSamples);
+  Serial.printf("  %-28s %9u cyc/pluck  %u B\n", "", (unsigned)pluckCycles,
+                (unsigned)sizeof(V));
+}
+
+static void benchKsFeatures() {
+  benchKsCombo<KSVoice<>>("KSVoice<> (plain)");
+  benchKsCombo<KSVoice<KSPickPosition>>("+PickPosition");
+  benchKsCombo<KSVoice<KSBrightness>>("+Brightness");
+  benchKsCombo<KSVoice<KSStiffness>>("+Stiffness");
+  benchKsCombo<KSVoice<KSFractionalTuning>>("+FractionalTuning");
+  benchKsCombo<GuitarKSVoice>("engine (Pick+Bright+Frac)");
+  benchKsCombo<KSAllFeatures>("all four");
+}
+
+// -----------------------------------------------------------------------------
+// rates：整条渲染链在各采样率下的 CPU 余量表
+// -----------------------------------------------------------------------------
+//
+// 每个采样率渲染 1 秒，每 1/4 秒重新满力度扫一次 C，保持 6 根弦都在响
+// （最坏情况）。load = 渲染一块的时间 / 一块的播放时长。
+//
+
+static float gBenchL[kBlockFrames];
+static float gBenchR[kBlockFrames];
+
+static void benchRates() {
+  int   saved = engineSampleRate();
+  float cpuHz = (float)ESP.getCpuFreqMHz() * 1e6f;
+
+  Serial.println("     rate  cyc/sample  avg load  peak load  headroom");
+  for (int r = 0; r < kNumSupportedRates; ++r) {
+    int rate = kSupportedRates[r];
+    engineSetSampleRate(rate);
+
+    int      blocks = rate / kBlockFrames;
+    uint64_t total  = 0;
+    uint32_t peak   = 0;
+    for (int b = 0; b < blocks; ++b) {
+      if (b % (blocks / 4) == 0) engineStrumNow(0, 127);
+      uint32_t t0 = ESP.getCycleCount();
+      engineRenderBlock(gBenchL, gBenchR, kBlockFrames);
+      uint32_t c = ESP.getCycleCount() - t0;
+      total += c;
+      if (c > peak) peak = c;
+    }
+
+    float budget = cpuHz * (float)kBlockFrames / (float)rate;
+    float avg    = (float)total / (float)blocks;
+    Serial.printf("  %7d  %10.1f  %7.1f%%  %8.1f%%  %7.1f%%\n",
+                  rate, avg / kBlockFrames, 100.0f * avg / budget,
+                  100.0f * peak / budget, 100.0f - 100.0f * peak / budget);
+  }
+
+  engineStopAll();
+  engineSetSampleRate(saved);
+}
+
+// -----------------------------------------------------------------------------
+// body：琴箱 IR 分块卷积在各采样率下每块的开销
+// -----------------------------------------------------------------------------
+//
+// 只测卷积本身（输入为噪声），和 body_convolver.h 里的理论开销对照。
+// mono = 只算 L（N/2+1 个 bin），stereo = L / R 一次复数 FFT（N 个 bin）。
+// 测完按当前采样率重新加载 IR。
+//
+
+static void fillBenchNoise(float scale) {
+  for (int i = 0; i < kBlockFrames; ++i) {
+    gBenchL[i] = (float)(int16_t)(noiseNext(gBenchNoise) >> 16) * scale;
+    gBenchR[i] = (float)(int16_t)(noiseNext(gBenchNoise) >> 16) * scale;
+  }
+}
+
+static void benchBody() {
+  int   saved = engineSampleRate();
+  float cpuHz = (float)ESP.getCpuFreqMHz() * 1e6f;
+  const int kBlocks = 256;
+
+  if (!bodyConvLoad(saved)) {
+    Serial.println("  body: no IR partition, skipped");
+    return;
+  }
+
+  Serial.println("     rate  parts  mono cyc/block  stereo cyc/block  stereo load");
+  for (int r = 0; r < kNumSupportedRates; ++r) {
+    int rate = kSupportedRates[r];
+    bodyConvLoad(rate);
+
+    uint64_t mono = 0, stereo = 0;
+    for (int b = 0; b < kBlocks; ++b) {
+      fillBenchNoise(1.0f / 32768.0f);
+      uint32_t t0 = ESP.getCycleCount();
+      bodyConvProcess(gBenchL, nullptr);
+      uint32_t t1 = ESP.getCycleCount();
+      bodyConvProcess(gBenchL, gBenchR);
+      uint32_t t2 = ESP.getCycleCount();
+      mono   += t1 - t0;
+      stereo += t2 - t1;
+    }
+    gBenchSink = gBenchL[0] + gBenchR[0];
+
+    float budget = cpuHz * (float)kBlockFrames / (float)rate;
+    Serial.printf("  %7d  %5d  %14.0f  %16.0f  %10.1f%%\n",
+                  rate, bodyConvPartitions(), (float)mono / kBlocks,
+                  (float)stereo / kBlocks, 100.0f * stereo / kBlocks / budget);
+  }
+
+  size_t ram = sizeof(float) * 2 * kBodyFftSize * kBodyMaxPartitions * 2  // H + FDL
+               + sizeof(float) * kBodyFftSize * 4;                         // 输入 L/R + 工作区
+  printFootprint("body convolver", ram, 0);
+
+  bodyConvLoad(saved);
+}
+
+// -----------------------------------------------------------------------------
+// master：总线（归一 + 总增益 + 限幅）每块开销
+// -----------------------------------------------------------------------------
+//
+// 输入是满幅噪声，限幅一直在工作；每块换一次目标增益，斜坡也一直在走。
+// 对照行是原来逐 sample 的 “乘增益 + 分支削波”。
+//
+
+static void benchMasterBus() {
+  const int kBlocks = 512;
+  uint64_t  normCycles = 0, busCycles = 0, clipCycles = 0;
+
+  for (int b = 0; b < kBlocks; ++b) {
+    fillBenchNoise(1.0f / 8192.0f);
+    uint32_t t0 = ESP.getCycleCount();
+    masterBusNormalize(gBenchL, gBenchR, kBlockFrames, 1 + (b % kNumStrings));
+    uint32_t t1 = ESP.getCycleCount();
+    masterBusProcess(gBenchL, gBenchR, kBlockFrames, (b & 1) ? kOutputGain : 0.5f * kOutputGain);
+    uint32_t t2 = ESP.getCycleCount();
+    normCycles += t1 - t0;
+    busCycles  += t2 - t1;
+
+    // 旧做法：单声道逐 sample 乘增益 + 分支削波
+    t0 = ESP.getCycleCount();
+    for (int i = 0; i < kBlockFrames; ++i) {
+      float v = gBenchL[i] * kOutputGain;
+      if (v > 1.0f)  v = 1.0f;
+      if (v < -1.0f) v = -1.0f;
+      gBenchL[i] = v;
+    }
+    clipCycles += ESP.getCycleCount() - t0;
+  }
+  gBenchSink = gBenchL[0];
+  masterBusReset();
+
+  uint32_t samples = (uint32_t)kBlocks * kBlockFrames;
+  printCost("voice normalize (L+R)", (uint32_t)normCycles, samples);
+  printCost("gain ramp + limiter (L+R)", (uint32_t)busCycles, samples);
+  printCost("old mono gain + hard clip", (uint32_t)clipCycles, samples);
+  Serial.printf("  %-28s %9.0f cyc/block\n", "bus total",
+                (float)(normCycles + busCycles) / kBlocks);
+}
+
+// -----------------------------------------------------------------------------
+// stereo：立体声相对单声道多出来的开销
+// -----------------------------------------------------------------------------
+//
+//  - 混音：六弦直接相加 vs 每弦乘 pan 增益分到 L / R（弦本身的开销两者一样，不计）
+//  - 输出：旧的 “每 sample 拆字节、4 次 write(uint8_t)” vs 打包成 32-bit 帧、每块 1 次 write
+//    （这里只测 CPU 部分，不真的写 I2S）
+//  - 琴箱 / 总线的立体声开销见 bench body / bench master
+//
+
+static void benchStereo() {
+  const int kBlocks = 256;
+  float panL[kNumStrings], panR[kNumStrings], voice[kNumStrings];
+  for (int i = 0; i < kNumStrings; ++i) {
+    float a = (kStringPan[i] + 1.0f) * 0.25f * (float)M_PI;
+    panL[i] = cosf(a);
+    panR[i] = sinf(a);
+  }
+
+  uint64_t monoMix = 0, stereoMix = 0, bytePack = 0, framePack = 0;
+  static uint8_t  bytes[kBlockFrames * 4];
+  static uint32_t frames[kBlockFrames];
+
+  for (int b = 0; b < kBlocks; ++b) {
+    for (int i = 0; i < kNumStrings; ++i) {
+      voice[i] = noiseFloat(gBenchNoise);
+    }
+
+    uint32_t t0 = ESP.getCycleCount();
+    for (int n = 0; n < kBlockFrames; ++n) {
+      float m = 0.0f;
+      for (int i = 0; i < kNumStrings; ++i) m += voice[i];
+      gBenchL[n] = m;
+    }
+    uint32_t t1 = ESP.getCycleCount();
+    for (int n = 0; n < kBlockFrames; ++n) {
+      float l = 0.0f, r = 0.0f;
+      for (int i = 0; i < kNumStrings; ++i) {
+        l += voice[i] * panL[i];
+        r += voice[i] * panR[i];
+      }
+      gBenchL[n] = l * 0.1f;
+      gBenchR[n] = r * 0.1f;
+    }
+    uint32_t t2 = ESP.getCycleCount();
+    monoMix   += t1 - t0;
+    stereoMix += t2 - t1;
+
+    t0 = ESP.getCycleCount();
+    for (int n = 0; n < kBlockFrames; ++n) {
+      int16_t v  = (int16_t)(gBenchL[n] * 32760.0f);
+      uint8_t lo = v & 0xFF;
+      uint8_t hi = (v >> 8) & 0xFF;
+      bytes[4 * n + 0] = lo; bytes[4 * n + 1] = hi;
+      bytes[4 * n + 2] = lo; bytes[4 * n + 3] = hi;
+    }
+    t1 = ESP.getCycleCount();
+    for (int n = 0; n < kBlockFrames; ++n) {
+      int16_t l = (int16_t)(gBenchL[n] * 32760.0f);
+      int16_t r = (int16_t)(gBenchR[n] * 32760.0f);
+      frames[n] = (uint32_t)(uint16_t)l | ((uint32_t)(uint16_t)r << 16);
+    }
+    t2 = ESP.getCycleCount();
+    bytePack  += t1 - t0;
+    framePack += t2 - t1;
+  }
+  gBenchSink = (float)(bytes[0] + frames[0]);
+
+  uint32_t samples = (uint32_t)kBlocks * kBlockFrames;
+  printCost("mix 6 strings mono", (uint32_t)monoMix, samples);
+  printCost("mix 6 strings panned L/R", (uint32_t)stereoMix, samples);
+  printCost("old mono byte split", (uint32_t)bytePack, samples);
+  Serial.printf("  %-28s %9d write calls/block\n", "", 4 * kBlockFrames);
+  printCost("stereo 32-bit frame pack", (uint32_t)framePack, samples);
+  Serial.printf("  %-28s %9d write calls/block\n", "", 1);
+}
+
+// -----------------------------------------------------------------------------
+// fx：效果器链里每个效果器的开销
+// -----------------------------------------------------------------------------
+//
+// 先让效果核停下，在当前核上直接跑链（两个核同频，cycle 数可比），
+// 测完按当前采样率重置效果器并恢复。
+//
+
+static void benchFx() {
+  const int kBlocks = 256;
+  static float wetL[kBlockFrames], wetR[kBlockFrames];
+  float cpuHz  = (float)ESP.getCpuFreqMHz() * 1e6f;
+  float budget = cpuHz * (float)kBlockFrames / (float)gRate.sampleRate;
+
+  fxPause();
+  EngineFx &fx = fxChain();
+  fx.reset(gRate.sampleRate);
+
+  uint64_t total[EngineFx::kCount] = {};
+  for (int b = 0; b < kBlocks; ++b) {
+    fillBenchNoise(1.0f / 32768.0f);
+    fx.process(gBenchL, gBenchR, wetL, wetR, kBlockFrames);
+    for (int i = 0; i < EngineFx::kCount; ++i) total[i] += fx.lastCycles[i];
+  }
+  gBenchSink = wetL[0] + wetR[0];
+
+  uint32_t samples = (uint32_t)kBlocks * kBlockFrames;
+  uint64_t sum     = 0;
+  for (int i = 0; i < EngineFx::kCount; ++i) {
+    printCost(EngineFx::name(i), (uint32_t)total[i], samples);
+    sum += total[i];
+  }
+  Serial.printf("  %-28s %9.0f cyc/block  %5.1f %% of core 0\n", "chain total",
+                (float)sum / kBlocks, 100.0f * sum / kBlocks / budget);
+  Serial.printf("  %-28s %9.2f ms (1 block) .. %.2f ms (ring full)\n", "wet latency",
+                kBlockFrames / gRate.samplesPerMs,
+                kBlockFrames * kFxRingBlocks / gRate.samplesPerMs);
+  printFootprint("effects (chain + rings)", fxMemoryBytes(), 0);
+
+  fxReconfigure(gRate.sampleRate);
+}
+
+// -----------------------------------------------------------------------------
+// noise：Arduino random() vs xorshift 噪声源
+// -----------------------------------------------------------------------------
+//
+// 三种写法都产生同样量化（16 位）的 [-1, 1) 噪声：
+//   random()     原来拨弦 / 切音里的写法，逐 sample 调用
+//   noiseFloat() 逐 sample 调用
+//   noiseFill()  一次填一整块（拨弦激励、切音都用这个）
+//
+
+static void benchNoise() {
+  const int kBlocks = 256;
+  NoiseGen  g;
+  noiseSeed(g, 1);
+
+  uint32_t t0 = ESP.getCycleCount();
+  for (int b = 0; b < kBlocks; ++b) {
+    for (int i = 0; i < kBlockFrames; ++i) {
+      gBenchL[i] = (float)random(-32768, 32767) / 32768.0f;
+    }
+  }
+  uint32_t cRandom = ESP.getCycleCount() - t0;
+  gBenchSink = gBenchL[0];
+
+  t0 = ESP.getCycleCount();
+  for (int b = 0; b < kBlocks; ++b) {
+    for (int i = 0; i < kBlockFrames; ++i) {
+      gBenchL[i] = noiseFloat(g);
+    }
+  }
+  uint32_t cFloat = ESP.getCycleCount() - t0;
+  gBenchSink = gBenchL[0];
+
+  t0 = ESP.getCycleCount();
+  for (int b = 0; b < kBlocks; ++b) {
+    noiseFill(g, gBenchL, kBlockFrames);
+  }
+  uint32_t cFill = ESP.getCycleCount() - t0;
+  gBenchSink = gBenchL[0];
+
+  uint32_t samples = (uint32_t)kBlocks * kBlockFrames;
+  printCost("random(-32768, 32767)", cRandom, samples);
+  printCost("noiseFloat()", cFloat, samples);
+  printCost("noiseFill() per block", cFill, samples);
+  Serial.printf("  %-28s %9.1fx\n", "speedup (fill vs random)",
+                (float)cRandom / (float)(cFill ? cFill : 1));
+
+  // 同一种子的前几个值，主机 / 板子上应该完全一样
+  noiseSeed(g, 1234);
+  uint32_t w[4];
+  for (int i = 0; i < 4; ++i) w[i] = noiseNext(g);
+  Serial.printf("  %-28s %08x %08x %08x %08x\n", "seed 1234 first words",
+                (unsigned)w[0], (unsigned)w[1], (unsigned)w[2], (unsigned)w[3]);
+}
+
+// -----------------------------------------------------------------------------
+// adpcm：音频 looper 每块的 IMA-ADPCM 编 / 解码开销
+// -----------------------------------------------------------------------------
+//
+// 输入是一根弦的 KS 输出（和真实信号一样有衰减，ADPCM 步长会跟着变），L / R 同一路。
+// 录音 = 编码 L+R；回放 = 解码 L+R；叠录 = 解码 + 编码。
+// SNR 是一遍编解码之后的（叠录每多一遍再加一次量化噪声）。
+//
+
+static void benchAdpcm() {
+  const int kBlocks = 512;
+  static uint8_t blk[2 * adpcmBlockBytes(kBlockFrames)];
+  static float   dec[kBlockFrames];
+  AdpcmState st[2];
+  adpcmReset(st[0]);
+  adpcmReset(st[1]);
+
+  uint64_t encCycles = 0, decCycles = 0;
+  double   sig = 0.0, err = 0.0;
+  for (int b = 0; b < kBlocks; ++b) {
+    if (b % 128 == 0) gBenchKs.pluck(110.0f, kKsDecayMax, kBaseNoiseTargetRms);
+    for (int i = 0; i < kBlockFrames; ++i) {
+      gBenchL[i] = 0.5f * gBenchKs.process();
+      gBenchR[i] = gBenchL[i];
+    }
+
+    uint32_t t0 = ESP.getCycleCount();
+    adpcmEncodeBlock(gBenchL, kBlockFrames, st[0], blk);
+    adpcmEncodeBlock(gBenchR, kBlockFrames, st[1], blk + adpcmBlockBytes(kBlockFrames));
+    uint32_t t1 = ESP.getCycleCount();
+    adpcmDecodeBlock(blk, kBlockFrames, dec);
+    adpcmDecodeBlock(blk + adpcmBlockBytes(kBlockFrames), kBlockFrames, gBenchR);
+    uint32_t t2 = ESP.getCycleCount();
+    encCycles += t1 - t0;
+    decCycles += t2 - t1;
+
+    for (int i = 0; i < kBlockFrames; ++i) {
+      float e = dec[i] - gBenchL[i];
+      sig += (double)gBenchL[i] * gBenchL[i];
+      err += (double)e * e;
+    }
+  }
+  gBenchSink = dec[0] + gBenchR[0];
+
+  float cpuHz  = (float)ESP.getCpuFreqMHz() * 1e6f;
+  float budget = cpuHz * (float)kBlockFrames / (float)gRate.sampleRate;
+  uint32_t samples = (uint32_t)kBlocks * kBlockFrames;
+  printCost("encode L+R (record)", (uint32_t)encCycles, samples);
+  printCost("decode L+R (play)", (uint32_t)decCycles, samples);
+  printCost("decode + encode (overdub)", (uint32_t)(encCycles + decCycles), samples);
+  Serial.printf("  %-28s %9.0f cyc/block  %5.1f %% of block budget\n", "overdub per block",
+                (float)(encCycles + decCycles) / kBlocks,
+                100.0f * (encCycles + decCycles) / kBlocks / budget);
+  Serial.printf("  %-28s %9.1f dB\n", "SNR (one pass)",
+                10.0 * log10(sig / (err > 0.0 ? err : 1e-30)));
+  Serial.printf("  %-28s %9d B/block  (16-bit: %d B)\n", "stereo block",
+                2 * adpcmBlockBytes(kBlockFrames), kBlockFrames * 4);
+  Serial.printf("  %-28s %9.1f KB/s @ %d Hz\n", "record rate",
+                2.0f * adpcmBlockBytes(kBlockFrames) * gRate.sampleRate / kBlockFrames / 1024.0f,
+                gRate.sampleRate);
+  printFootprint("audio looper (PSRAM)", audioLoopMemoryBytes(), 0);
+}
+
+// -----------------------------------------------------------------------------
+// symp：共鸣（琴桥耦合）相对普通引擎（symp = 0）多出来的开销
+// -----------------------------------------------------------------------------
+//
+// 同一个和弦分别在 symp = 0 和当前 symp 下扫一次、渲染 1 秒，整条渲染链计时。
+// E 六弦全响（没有共鸣弦，只有琴桥求和 + 带通），C 一根共鸣弦，D 两根：
+// 多出来的开销应该是一个常数加上每根共鸣弦一份，而不是随弦数平方长。
+//
+
+static void benchSympathetic() {
+  const int kChords[] = { CH_E, CH_C, CH_D };
+  float saved = gTone->sympGain;
+  float gain  = (saved > 0.0f) ? saved : kSympGain;
+  int   blocks = gRate.sampleRate / kBlockFrames;
+
+  Serial.printf("  symp %.4f, %d blocks per run\n", gain, blocks);
+  Serial.println("  chord  resonating  plain cyc/block  symp cyc/block  extra cyc/block");
+  for (int chord : kChords) {
+    uint64_t total[2] = {};
+    int      resonating = 0;
+    for (int pass = 0; pass < 2; ++pass) {
+      engineStopAll();
+      paramsSet("symp", 0, pass ? gain : 0.0f);   // 下一块开头换上
+      engineStrumNow(chord, 100);
+      for (int b = 0; b < blocks; ++b) {
+        uint32_t t0 = ESP.getCycleCount();
+        engineRenderBlock(gBenchL, gBenchR, kBlockFrames);
+        total[pass] += ESP.getCycleCount() - t0;
+        if (pass && b == blocks / 2) resonating = engineResonatingVoices();
+      }
+    }
+    float plain = (float)total[0] / blocks;
+    float symp  = (float)total[1] / blocks;
+    Serial.printf("  %-5s  %10d  %15.0f  %14.0f  %15.0f\n", kChordVoicings[chord].name,
+                  resonating, plain, symp, symp - plain);
+  }
+
+  engineStopAll();
+  paramsSet("symp", 0, saved);
+  printFootprint("symp state", sizeof(float) * (kBlockFrames + kNumStrings + 2) + 2 * kNumStrings, 0);
+}
+
+// -----------------------------------------------------------------------------
+// 测试表 & 入口
+// -----------------------------------------------------------------------------
+
+static const BenchEntry kBenches[] = {
+  { "voice", "KS vs wavetable: cost per voice, RAM / flash footprint", benchVoices },
+  { "ksfeat", "KSVoice<Features...>: per-sample cost of each feature combination", benchKsFeatures },
+  { "rates", "full render path: CPU headroom at 16k / 22.05k / 44.1k / 48k", benchRates },
+  { "body", "body IR partitioned convolution: cost per block at each rate", benchBody },
+  { "master", "master bus: voice normalize, gain ramp, look-ahead limiter", benchMasterBus },
+  { "stereo", "stereo vs mono: panned mix and 32-bit frame packing", benchStereo },
+  { "fx", "effects chain: per-effect cost, wet latency, memory", benchFx },
+  { "noise", "noise source: Arduino random() vs xorshift (per sample / block fill)", benchNoise },
+  { "adpcm", "audio looper: IMA-ADPCM encode / decode per block, SNR, PSRAM", benchAdpcm },
+  { "symp", "sympathetic resonance: full render cost vs symp = 0, by resonating strings", benchSympathetic },
+};
+
+static const int kNumBenches = sizeof(kBenches) / sizeof(kBenches[0]);
+
+void runBenchmarks(const char *name) {
+  if (name != nullptr && strcmp(name, "list") == 0) {
+    for (int i = 0; i < kNumBenches; ++i) {
+      Serial.printf("  %-10s %s\n", kBenches[i].name, kBenches[i].desc);
+    }
+    return;
+  }
+
+  bool all = (name == nullptr || name[0] == '\0');
+  bool ran = false;
+  // 测试会扫弦、临时换采样率：looper 先停住，不录进用户的 loop，也不把 loop 放进测试里
+  // 起音会取 gNoise：测完恢复，seed 命令设的序列不被打乱
+  engineHoldLoopers(true);
+  NoiseGen savedNoise = gNoise;
+  for (int i = 0; i < kNumBenches; ++i) {
+    if (!all && strcmp(name, kBenches[i].name) != 0) continue;
+    Serial.printf("[Bench] %s\n", kBenches[i].name);
+    kBenches[i].fn();
+    ran = true;
+  }
+  gNoise = savedNoise;
+  engineHoldLoopers(false);
+  if (!ran) {
+    Serial.print("Unknown bench: ");
+    Serial.println(name);
+  }
+}
@@ -0,0 +1,27 @@
+#pragma once
+//
+// engine_bench.h
+// ==============================
+// 目标板上的性能测试（串口命令 bench）。
+//  - 用 ESP.getCycleCount() 计时，结果以 cycles/sample 和
+//    “占一个核的百分比（按当前采样率实时播放）”给出
+//  - 同时报告各后端的 RAM / flash 占用
+//  - 测试期间 loop() 不送 I2S，音频会短暂中断
+//  - 事件 / 音频 looper 测试期间暂停（不录、不放），测完接着原来的 loop，内容不清
+//
+// 用法：
+//   bench         跑全部
+//   bench list    列出所有测试
+//   bench voice   只跑名为 voice 的测试
+//
+
+void runBenchmarks(const char *name);
+
+// ---- 由 esp32_guitar_engine.ino 提供：整条渲染链的测试入口 ----
+int  engineSampleRate();
+bool engineSetSampleRate(int rate);   // 只换参数，不动 I2S
+void engineStrumNow(int chordIndex, int velocity);   // 排一次下扫，不进 looper、不打 trace
+void engineRenderBlock(float *left, float *right, int frames);
+void engineStopAll();
+void engineHoldLoopers(bool hold);    // looper 暂停 / 放开（looperHold + audioLoopHold）
+int  engineResonatingVoices();        // 共鸣弦数（发声但没弹的弦）
@@ -0,0 +1,199 @@
+#include <Arduino.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include "engine_soak.h"
+#include "engine_bench.h"
+#include "guitar_params.h"
+#include "noise_gen.h"
+
+// 一个报告区间（kSoakReportSec 模拟秒）的统计
+struct SoakWindow {
+  uint32_t        blocks;
+  uint64_t        cycles;
+  uint32_t        maxCycles;
+  uint32_t        overruns;      // 渲染时间超过一块的播放时长
+  uint32_t        voiceSum;      // 每块正在响的弦数之和
+  EngineStateScan out;           // 输出 sample
+};
+
+struct SoakEvents {
+  uint32_t strums;
+  uint32_t chokes;
+  uint32_t palms;
+  uint32_t volumes;
+  uint32_t rests;
+};
+
+static float gSoakL[kBlockFrames];
+static float gSoakR[kBlockFrames];
+
+static uint32_t soakRand(NoiseGen &g, uint32_t n) {
+  return noiseNext(g) % n;
+}
+
+static void printSimTime(uint64_t samples, int rate) {
+  uint32_t sec = (uint32_t)(samples / (uint64_t)rate);
+  Serial.printf("%4u:%02u", (unsigned)(sec / 60), (unsigned)(sec % 60));
+}
+
+// 触发一个随机事件，返回到下一个事件的 sample 数
+static uint32_t soakEvent(NoiseGen &g, int rate, SoakEvents &ev) {
+  uint32_t gapMs = kSoakGapMsMin + soakRand(g, kSoakGapMsMax - kSoakGapMsMin + 1);
+  uint32_t r     = soakRand(g, 100);
+
+  if (r < kSoakChokePct) {
+    engineChoke();
+    ev.chokes++;
+  } else if ((r -= kSoakChokePct) < kSoakPalmPct) {
+    enginePalmMute();
+    ev.palms++;
+  } else if ((r -= kSoakPalmPct) < kSoakVolumePct) {
+    engineSetVolume(0.2f + 0.8f * (float)soakRand(g, 101) / 100.0f);
+    ev.volumes++;
+  } else if ((r -= kSoakVolumePct) < kSoakRestPct) {
+    // 长时间不弹：尾音一路衰减到底，检验弦能自己停、状态不会掉进非正规数
+    gapMs = 1000u * (kSoakRestSecMin + soakRand(g, kSoakRestSecMax - kSoakRestSecMin + 1));
+    ev.rests++;
+  } else {
+    engineStrumNow((int)soakRand(g, engineNumChords()), 20 + (int)soakRand(g, 108));
+    ev.strums++;
+  }
+  return (uint32_t)((uint64_t)gapMs * rate / 1000u);
+}
+
+void runSoak(float minutes, uint32_t seed) {
+  const int      rate         = engineSampleRate();
+  const float    budget       = (float)ESP.getCpuFreqMHz() * 1e6f
+                                * (float)kBlockFrames / (float)rate;
+  const uint64_t totalBlocks  = (uint64_t)(minutes * 60.0f * (float)rate) / kBlockFrames;
+  const uint32_t reportBlocks = (uint32_t)kSoakReportSec * rate / kBlockFrames;
+  const uint32_t secBlocks    = (uint32_t)rate / kBlockFrames;
+
+  if (totalBlocks == 0) {
+    Serial.println("Usage: soak <minutes> [seed]");
+    return;
+  }
+
+  NoiseGen rng;
+  noiseSeed(rng, seed);
+
+  Serial.printf("[Soak] %.1f min simulated @ %d Hz, seed %u, report every %d s "
+                "(any key aborts)\n", minutes, rate, (unsigned)seed, kSoakReportSec);
+  Serial.println("     time  load avg / max   over  voices   free heap (min)"
+                 "   out nan denorm   state nan denorm");
+
+  // 用户的 loop 不受影响；噪声源按种子从头来，测完恢复（seed 命令设的序列不被打乱）
+  engineHoldLoopers(true);
+  NoiseGen savedNoise = gNoise;
+  engineResetState(seed);
+  float savedVolume = engineSetVolume(1.0f);
+
+  SoakWindow      win        = {};
+  SoakEvents      events     = {};
+  EngineStateScan state      = {};
+  EngineStateScan totalOut   = {};
+  EngineStateScan totalState = {};
+  uint32_t totalOverruns = 0;
+  uint32_t worstCycles   = 0;
+  uint64_t worstAt       = 0;
+  float    firstLoad     = -1.0f;
+  float    lastLoad      = 0.0f;
+  uint32_t heapStart     = ESP.getFreeHeap();
+  uint32_t realStart     = millis();
+  uint64_t nextEvent     = 0;
+  uint64_t b             = 0;
+  bool     aborted       = false;
+
+  for (; b < totalBlocks; ++b) {
+    uint64_t now = b * kBlockFrames;
+    while (nextEvent <= now) {
+      nextEvent += soakEvent(rng, rate, events);
+    }
+
+    uint32_t t0 = ESP.getCycleCount();
+    engineRenderBlock(gSoakL, gSoakR, kBlockFrames);
+    uint32_t c = ESP.getCycleCount() - t0;
+
+    win.blocks++;
+    win.cycles += c;
+    if (c > win.maxCycles) win.maxCycles = c;
+    if ((float)c > budget) win.overruns++;
+    if (c > worstCycles) {
+      worstCycles = c;
+      worstAt     = now;
+    }
+    win.voiceSum += engineActiveVoices();
+    for (int i = 0; i < kBlockFrames; ++i) {
+      soakClassify(gSoakL[i], win.out);
+      soakClassify(gSoakR[i], win.out);
+    }
+
+    bool last = (b + 1 == totalBlocks);
+    if (win.blocks == reportBlocks || last) {
+      engineScanState(state);
+      float avgLoad = 100.0f * (float)win.cycles / (float)win.blocks / budget;
+      if (firstLoad < 0.0f) firstLoad = avgLoad;
+      lastLoad = avgLoad;
+
+      Serial.print("  ");
+      printSimTime(now + kBlockFrames, rate);
+      Serial.printf("  %6.1f%% %6.1f%%  %5u  %6.2f  %7u (%7u)  %7d %6d  %9d %6d\n",
+                    avgLoad, 100.0f * (float)win.maxCycles / budget,
+                    (unsigned)win.overruns, (float)win.voiceSum / (float)win.blocks,
+                    (unsigned)ESP.getFreeHeap(), (unsigned)ESP.getMinFreeHeap(),
+                    win.out.nonFinite, win.out.denormal, state.nonFinite, state.denormal);
+
+      totalOverruns        += win.overruns;
+      totalOut.nonFinite   += win.out.nonFinite;
+      totalOut.denormal    += win.out.denormal;
+      totalState.nonFinite += state.nonFinite;
+      totalState.denormal  += state.denormal;
+      win = {};
+    }
+
+    // 每模拟一秒让一下 core 1 的 idle 任务，顺便看要不要提前结束
+    if ((b + 1) % secBlocks == 0) {
+      vTaskDelay(1);
+      if (Serial.available()) {
+        while (Serial.available()) Serial.read();
+        aborted = true;
+        ++b;
+        break;
+      }
+    }
+  }
+
+  engineStopAll();
+  engineSetVolume(savedVolume);
+  gNoise = savedNoise;
+  engineHoldLoopers(false);
+
+  uint64_t simSamples = b * kBlockFrames;
+  float    realSec    = (float)(millis() - realStart) / 1000.0f;
+  float    simSec     = (float)simSamples / (float)rate;
+  uint32_t heapEnd    = ESP.getFreeHeap();
+  bool     fail       = totalOut.nonFinite > 0 || totalState.nonFinite > 0 || totalOverruns > 0;
+
+  Serial.print(aborted ? "[Soak] aborted at " : "[Soak] done: ");
+  printSimTime(simSamples, rate);
+  Serial.printf(" simulated in %.1f s (%.1fx realtime)\n",
+                realSec, realSec > 0.0f ? simSec / realSec : 0.0f);
+  Serial.printf("  worst block   %u cyc (%.1f %% of budget) at ",
+                (unsigned)worstCycles, 100.0f * (float)worstCycles / budget);
+  printSimTime(worstAt, rate);
+  Serial.println();
+  Serial.printf("  load drift    %.1f %% -> %.1f %% (first / last report)\n",
+                firstLoad < 0.0f ? 0.0f : firstLoad, lastLoad);
+  Serial.printf("  free heap     %u -> %u B (%+d), min %u B\n",
+                (unsigned)heapStart, (unsigned)heapEnd, (int)(heapEnd - heapStart),
+                (unsigned)ESP.getMinFreeHeap());
+  Serial.printf("  events        %u strums, %u chokes, %u palm mutes, %u volume, %u rests\n",
+                (unsigned)events.strums, (unsigned)events.chokes, (unsigned)events.palms,
+                (unsigned)events.volumes, (unsigned)events.rests);
+  Serial.printf("  output        %d nan/inf, %d denormal samples\n",
+                totalOut.nonFinite, totalOut.denormal);
+  Serial.printf("  engine state  %d nan/inf, %d denormal (summed over reports)\n",
+                totalState.nonFinite, totalState.denormal);
+  Serial.printf("  overruns      %u blocks\n", (unsigned)totalOverruns);
+  Serial.println(fail ? "[Soak] FAIL" : "[Soak] PASS");
+}
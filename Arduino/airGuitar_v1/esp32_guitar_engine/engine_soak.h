@@ -0,0 +1,57 @@
+#pragma once
+//
+// engine_soak.h
+// ==============================
+// 长时间稳定性测试（串口命令 soak）：不送 I2S，按模拟时间尽快渲染，
+// 用随机扫弦 / 切音 / 闷音 / 改音量 / 长时间不弹 驱动整条渲染链。
+//
+// 每 kSoakReportSec（模拟时间）报告一行：
+//  - 每块渲染时间：平均 / 最大 cycles 换算成实时负载 %，超过一块时长的块数
+//  - 堆：当前空闲 / 开机以来最低
+//  - 输出里的 NaN / Inf / 非正规数，引擎状态（弦延迟线、音色滤波）里的同样三类
+// 最后汇总：最坏的一块、负载漂移（第一段 vs 最后一段）、堆变化；
+// 出现 NaN / Inf 或有块超时判 FAIL。
+//
+//  - 输出经过总线限幅（fminf / fmaxf 会把 NaN 吃掉），所以 NaN 主要看状态扫描
+//  - 串口收到任意字符提前结束；期间没有音频，结束时停掉所有声音
+//  - 开始时 looper 暂停（不录、不放），引擎噪声源按种子重置、滤波 / 琴箱 / 效果器状态清空，
+//    结束后放开 looper、噪声源恢复成测试前的状态
+//  - 同一种子、同一采样率：事件序列一样，干声渲染结果也一样；效果器（fx on）在 core 0 上
+//    异步算，湿声回来晚几块取决于两个核的时序，不保证逐 sample 一样
+//
+// 用法：
+//   soak 30          模拟 30 分钟（SRS-06）
+//   soak 240 7       模拟 4 小时，种子 7
+//
+
+#include <math.h>
+#include <float.h>
+#include <stdint.h>
+
+struct EngineStateScan {
+  int nonFinite;   // NaN / Inf
+  int denormal;
+};
+
+inline bool soakIsDenormal(float x) {
+  return x != 0.0f && fabsf(x) < FLT_MIN;
+}
+
+inline void soakClassify(float x, EngineStateScan &scan) {
+  if (!isfinite(x)) {
+    scan.nonFinite++;
+  } else if (soakIsDenormal(x)) {
+    scan.denormal++;
+  }
+}
+
+void runSoak(float minutes, uint32_t seed);
+
+// ---- 由 esp32_guitar_engine.ino 提供（另见 engine_bench.h 的渲染链入口） ----
+int   engineNumChords();
+void  engineResetState(uint32_t seed);   // 噪声源按 seed 重来，滤波 / 琴箱 / 效果器状态清空
+void  engineChoke();                  // 切音 + 啪（不进 looper）
+void  enginePalmMute();
+float engineSetVolume(float volume);  // 主音量 0..1，返回原来的
+int   engineActiveVoices();
+void  engineScanState(EngineStateScan &scan);
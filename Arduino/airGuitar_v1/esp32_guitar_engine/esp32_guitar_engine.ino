@@ -2,13 +2,32 @@
 //
 // Karplus–Strong 六弦 + AutoKey（晴天）+ 切音“啪” + 主音量控制。
 // 输入：ATmega UART（实战） / USB Serial（调试）
-// 输出：I2S → 扬声器
+// 输出：I2S（立体声，每根弦有自己的声像）→ 扬声器
 
 #include <Arduino.h>
 #include <ESP_I2S.h>
 #include <math.h>
 #include "esp32_uart.h"       // ATmega UART 协议解析（带 volume 0..127）
 #include "guitar_params.h"    // 所有可调参数
+#include "rate_params.h"      // 由采样率推出的运行时参数
+#include "param_store.h"      // 串口可调的音色 / 手感参数（NVS，双缓冲系数）
+#include "chord_voicings.h"   // 和弦库：六弦指法 → 每根弦的 MIDI note（编译期）
+#include "ks_voice.h"         // Karplus–Strong 单弦（KSVoice<Features...>）
+#include "wavetable_voice.h"  // flash wavetable 单音
+#include "voice_mod.h"        // 每弦调制：闷音 / 踏板 / 渐强
+#include "noise_gen.h"        // 可设种子的白噪声（激励 + 切音）
+#include "song_library.h"     // AutoKey 歌曲库（LittleFS + 后台预取）
+#include "pattern_seq.h"      // AutoKey 节奏型 / 分解和弦音序器
+#include "midi_input.h"       // USB 串口 MIDI 字节流解析
+#include "event_looper.h"     // 事件循环录音（录扫弦事件，不录音频）
+#include "audio_looper.h"     // 音频循环录音（总线输出 → ADPCM → PSRAM）
+#include "pcm_tap.h"          // 调试：送进 I2S 的 PCM 从 USB 串口发出去
+#include "trace.h"            // 渲染循环里的调试输出（二进制记录，后台打印）
+#include "body_convolver.h"   // 琴箱 IR 分块卷积
+#include "master_bus.h"       // 归一 / 总增益 / 限幅
+#include "effects_task.h"     // 合唱 / 混响（另一个核）
+#include "engine_bench.h"     // bench 命令：各模块 CPU / 内存开销
+#include "engine_soak.h"      // soak 命令：随机演奏跑几个小时（模拟时间），看负载 / 堆 / NaN
 
 // ============ I2S 硬件引脚（根据实际连线调整） ============
 #define I2S_LRC  17
@@ -19,20 +38,6 @@
 // 1. 类型定义 & 全局结构
 // ============================================================
 
-struct KSString {
-  float buffer[kMaxKsDelay];
-  int   length;
-  int   index;
-  float decay;
-  bool  active;
-};
-
-struct MidiChord {
-  const char   *name;    // "C", "Am", "G7", "Dsus4" ...
-  const uint8_t *notes;  // 3 个 MIDI note
-  size_t        count;
-};
-
 enum StrumDirection {
   STRUM_DOWN = 0,  // 低音 → 高音
   STRUM_UP   = 1   // 高音 → 低音
@@ -44,6 +49,7 @@ struct ScheduledPluck {
   int      chordIndex;
   int      stringIndex;   // 0..kNumStrings-1
   float    velocityNorm;  // 0~1
+  uint8_t  midiNote;      // 非 0：直接弹这个音（MIDI 单音），不按和弦算
 };
 
 struct ToneState {
@@ -51,14 +57,23 @@ struct ToneState {
   float lpBody;
 };
 
-struct AutoKeyState {
-  int seqIndex;     // 0..kAutoKeySeqLength-1
-  int repeatCount;  // 0..kAutoKeyRepeatsPerChord-1
-};
-
 enum InputMode {
   INPUT_MODE_ATMEGA = 0,
-  INPUT_MODE_SERIAL = 1
+  INPUT_MODE_SERIAL = 1,
+  INPUT_MODE_MIDI   = 2    // USB 串口收 MIDI 字节流（midi_input.h）
+};
+
+// 琴箱处理：IR 卷积 / 两个一阶滤波
+enum BodyMode {
+  BODY_TONE = 0,
+  BODY_CONV = 1
+};
+
+struct BodyState {
+  BodyMode requested;    // 用户选择
+  BodyMode active;       // 实际在用（IR 缺失或超预算时退回 TONE）
+  int      overBlocks;   // 连续超出 kBodyConvMaxLoad 的块数
+  uint32_t lastCycles;   // 最近一块卷积的 cycle
 };
 
 // 切音噪声状态
@@ -68,94 +83,65 @@ struct ChokeState {
   float env;
 };
 
+// 调制来源（输入侧只改这里，每块换算成每根弦的 VoiceMod.target）
+struct ModSources {
+  bool     palmMute;
+  bool     palmLatched;     // 串口 palm on：一直闷，直到 palm off
+  uint32_t palmMuteUntil;   // 手势闷音保持到哪个 sample
+  bool     pedal;           // 延音踏板
+  float    swellMs;         // 0 = 关
+  float    brightMul;       // MIDI CC1：环路亮度乘数
+};
+
+// MIDI 输入统计（解析 + 分发的 cycle 数按消息平均）
+struct MidiStats {
+  uint32_t bytes;
+  uint32_t messages;
+  uint32_t cycles;
+  uint32_t maxCycles;
+};
+
+// 共鸣（琴桥耦合，guitar_params.h 第 5.5 节）
+struct SympState {
+  bool    resonating[kNumStrings];  // true = 没弹，只靠琴桥激励
+  float   feed[kNumStrings];        // 送进琴桥的比例：弹响的弦 1，共鸣弦 0（不回送，没有回路）
+  uint8_t note[kNumStrings];        // 停了以后按这个音共鸣（按着的音；不弹的弦 = 空弦）
+  float   highLp;                   // 琴桥带通状态
+  float   lowLp;
+  float   bridge[kBlockFrames];     // 本块弹响的弦之和 → 带通后的琴桥信号
+};
+
+// 渲染预算统计（每块更新一次）
+struct RenderStats {
+  uint32_t blocks;
+  uint32_t overruns;       // 渲染时间超过块时长的块数
+  uint32_t lastCycles;
+  float    loadAvg;        // 平滑后的 CPU 占用（0~1 = 块时长的比例）
+  float    loadPeak;
+  int      voiceBudget;    // 当前允许同时发声的弦数
+  int      calmBlocks;     // 连续低负载块数
+};
+
 // ============================================================
 // 2. 和弦库定义 & 名字 ↔ 索引映射
 // ============================================================
 
-// ----- Major triads -----
-const uint8_t CmajNotes[] = { 60, 64, 67 }; // C4 E4 G4
-const uint8_t GmajNotes[] = { 55, 59, 62 }; // G3 B3 D4
-const uint8_t DmajNotes[] = { 62, 66, 69 }; // D4 F#4 A4
-const uint8_t AmajNotes[] = { 57, 61, 64 }; // A3 C#4 E4
-const uint8_t EmajNotes[] = { 52, 56, 59 }; // E3 G#3 B3
-const uint8_t FmajNotes[] = { 53, 57, 60 }; // F3 A3 C4
-
-// ----- Minor triads -----
-const uint8_t AminNotes[]   = { 57, 60, 64 }; // A3 C4 E4
-const uint8_t EminNotes[]   = { 52, 55, 59 }; // E3 G3 B3
-const uint8_t DminNotes[]   = { 50, 53, 57 }; // D3 F3 A3
-const uint8_t BminNotes[]   = { 59, 62, 66 }; // B3 D4 F#4
-const uint8_t FsminNotes[]  = { 54, 57, 61 }; // F#3 A3 C#4
-const uint8_t GminNotes[]   = { 55, 58, 62 }; // G3 Bb3 D4
-
-// ----- Dominant 7ths（R, 3rd, b7）-----
-const uint8_t C7Notes[] = { 48, 52, 58 }; // C3 E3 Bb3
-const uint8_t G7Notes[] = { 55, 59, 65 }; // G3 B3 F4
-const uint8_t D7Notes[] = { 50, 54, 60 }; // D3 F#3 C4
-const uint8_t A7Notes[] = { 57, 61, 67 }; // A3 C#4 G4
-const uint8_t E7Notes[] = { 52, 56, 62 }; // E3 G#3 D4
-const uint8_t B7Notes[] = { 59, 63, 69 }; // B3 D#4 A4
-
-// ----- Sus & dim -----
-const uint8_t Dsus4Notes[] = { 50, 55, 57 }; // D3 G3 A3
-const uint8_t Gsus4Notes[] = { 55, 60, 62 }; // G3 C4 D4
-const uint8_t Asus4Notes[] = { 57, 62, 64 }; // A3 D4 E4
-const uint8_t Esus4Notes[] = { 52, 57, 59 }; // E3 A3 B3
-const uint8_t BdimNotes[]  = { 59, 62, 65 }; // B3 D4 F4
-const uint8_t FsDimNotes[] = { 54, 57, 60 }; // F#3 A3 C4
-
-// ----- Cmaj7（新增）-----
-// 用 C4 E4 B4（root、3rd、maj7），没有 5th 问题不大
-const uint8_t Cmaj7Notes[] = { 60, 64, 71 }; // C4 E4 B4
-
-// chords[] 顺序要与 guitar_params.h 中的注释保持一致：
-//  0:C,  1:G,  2:D,   3:A,   4:E,   5:F,
-//  6:C7, 7:G7, 8:D7,  9:A7, 10:E7, 11:B7,
-//  12:Am,13:Em,14:Dm,15:Bm,16:F#m,17:Gm,
-//  18:Dsus4,19:Gsus4,20:Asus4,21:Esus4,22:Bdim,23:F#dim,
-//  24:Cmaj7
-MidiChord chords[] = {
-  // Major triads 0..5
-  { "C",     CmajNotes,    sizeof(CmajNotes)    / sizeof(uint8_t) }, // 0
-  { "G",     GmajNotes,    sizeof(GmajNotes)    / sizeof(uint8_t) }, // 1
-  { "D",     DmajNotes,    sizeof(DmajNotes)    / sizeof(uint8_t) }, // 2
-  { "A",     AmajNotes,    sizeof(AmajNotes)    / sizeof(uint8_t) }, // 3
-  { "E",     EmajNotes,    sizeof(EmajNotes)    / sizeof(uint8_t) }, // 4
-  { "F",     FmajNotes,    sizeof(FmajNotes)    / sizeof(uint8_t) }, // 5
-
-  // Dominant 7ths 6..11
-  { "C7",    C7Notes,      sizeof(C7Notes)      / sizeof(uint8_t) }, // 6
-  { "G7",    G7Notes,      sizeof(G7Notes)      / sizeof(uint8_t) }, // 7
-  { "D7",    D7Notes,      sizeof(D7Notes)      / sizeof(uint8_t) }, // 8
-  { "A7",    A7Notes,      sizeof(A7Notes)      / sizeof(uint8_t) }, // 9
-  { "E7",    E7Notes,      sizeof(E7Notes)      / sizeof(uint8_t) }, // 10
-  { "B7",    B7Notes,      sizeof(B7Notes)      / sizeof(uint8_t) }, // 11
-
-  // Minor triads 12..17
-  { "Am",    AminNotes,    sizeof(AminNotes)    / sizeof(uint8_t) }, // 12
-  { "Em",    EminNotes,    sizeof(EminNotes)    / sizeof(uint8_t) }, // 13
-  { "Dm",    DminNotes,    sizeof(DminNotes)    / sizeof(uint8_t) }, // 14
-  { "Bm",    BminNotes,    sizeof(BminNotes)    / sizeof(uint8_t) }, // 15
-  { "F#m",   FsminNotes,   sizeof(FsminNotes)   / sizeof(uint8_t) }, // 16
-  { "Gm",    GminNotes,    sizeof(GminNotes)    / sizeof(uint8_t) }, // 17
-
-  // Sus & dim 18..23
-  { "Dsus4", Dsus4Notes,   sizeof(Dsus4Notes)   / sizeof(uint8_t) }, // 18
-  { "Gsus4", Gsus4Notes,   sizeof(Gsus4Notes)   / sizeof(uint8_t) }, // 19
-  { "Asus4", Asus4Notes,   sizeof(Asus4Notes)   / sizeof(uint8_t) }, // 20
-  { "Esus4", Esus4Notes,   sizeof(Esus4Notes)   / sizeof(uint8_t) }, // 21
-  { "Bdim",  BdimNotes,    sizeof(BdimNotes)    / sizeof(uint8_t) }, // 22
-  { "F#dim", FsDimNotes,   sizeof(FsDimNotes)   / sizeof(uint8_t) }, // 23
-
-  // 24：新增 Cmaj7
-  { "Cmaj7", Cmaj7Notes,   sizeof(Cmaj7Notes)   / sizeof(uint8_t) }  // 24
-};
-
-const int NUM_CHORDS = sizeof(chords) / sizeof(chords[0]);
+// 六弦指法表在 chord_voicings.h（编译期算好每根弦的 MIDI note）
+const int NUM_CHORDS = kNumChordIndices;
 
 int chordNameToIndex(const String &name) {
   for (int i = 0; i < NUM_CHORDS; ++i) {
-    if (name.equalsIgnoreCase(chords[i].name)) {
+    if (name.equalsIgnoreCase(kChordVoicings[i].name)) {
+      return i;
+    }
+  }
+  return -1;
+}
+
+// 歌曲库编译谱子时用（在加载任务里调用，只读 kChordVoicings）
+int chordIndexByName(const char *name) {
+  for (int i = 0; i < NUM_CHORDS; ++i) {
+    if (strcasecmp(name, kChordVoicings[i].name) == 0) {
       return i;
     }
   }
@@ -166,13 +152,44 @@ int chordNameToIndex(const String &name) {
 // 3. 全局状态 & I2S 实例
 // ============================================================
 
-KSString       gStrings[kNumStrings];
+#if GUITAR_VOICE_BACKEND == GUITAR_VOICE_WAVETABLE
+WavetableVoice gStrings[kNumStrings];
+#else
+GuitarKSVoice  gStrings[kNumStrings];
+#endif
+float          gKsExcitation[kMaxKsDelay];   // KSVoice::repluck() 的激励暂存区（bench 也用）
 ScheduledPluck gPlucks[kMaxScheduledPlucks];
-ToneState      gToneState = {0.0f, 0.0f};
-AutoKeyState   gAutoKey   = {0, 0};
+ToneState      gToneState[2];   // 0 = L, 1 = R
+SongCursor     gAutoKey;               // AutoKey 在 kAutoKeySong 里的位置
 ChokeState     gChoke     = {false, 0, 0.0f};
 uint32_t       gSampleCounter = 0;
 InputMode      gInputMode     = INPUT_MODE_ATMEGA;
+RateParams     gRate          = computeRateParams(kSampleRate);
+RenderStats    gRenderStats   = {0, 0, 0, 0.0f, 0.0f, kNumStrings, 0};
+BodyState      gBody          = {BODY_CONV, BODY_TONE, 0, 0};
+ModSources     gModSources    = {false, false, 0, false, kSwellDefaultMs, 1.0f};
+MidiParser     gMidiParser;
+MidiStats      gMidiStats;
+VoiceMod       gVoiceMod[kNumStrings];
+NoiseGen       gNoise;
+uint32_t       gNoiseSeed     = kNoiseSeed;
+SympState      gSymp;
+
+// 每块算好的每弦增益 = pan × 调制增益（混音时每 sample 只乘一次）
+float          gVoiceGainL[kNumStrings];
+float          gVoiceGainR[kNumStrings];
+
+// 每根弦最近一次起音的 sample 时间，预算不够时先停最早的
+uint32_t       gVoiceStartSample[kNumStrings];
+
+// 当前渲染块（L / R 分开存，块处理好向量化），以及打包好的 I2S 帧
+float          gBlockL[kBlockFrames];
+float          gBlockR[kBlockFrames];
+uint32_t       gI2sFrames[kBlockFrames];   // 低 16 位 = L，高 16 位 = R
+
+// 每根弦的等功率 pan 增益（由 kStringPan 在 setup 里算好）
+float          gPanL[kNumStrings];
+float          gPanR[kNumStrings];
 
 // 主音量控制（0.0~1.0），由 ATmega 的 volume(0..127) 或 Serial vol 命令设置
 float          gMasterVolume  = 1.0f;
@@ -183,31 +200,47 @@ I2SClass i2s;
 // 4. 工具函数：MIDI ↔ 频率、AutoKey 状态管理、切音
 // ============================================================
 
+// 查编译期音高表（chord_voicings.h）
 float midiToFreq(uint8_t midi) {
-  return 440.0f * powf(2.0f, ((int)midi - 69) / 12.0f);
+  return kNoteHz[midi];
 }
 
 void autoKeyReset() {
-  gAutoKey.seqIndex    = 0;
-  gAutoKey.repeatCount = 0;
+  songCursorReset(gAutoKey, songLibActiveCode());
 }
 
 int autoKeyNextChordIndex() {
-  int chordIndex = kAutoKeySeq[gAutoKey.seqIndex];
+  return songNextChord(gAutoKey);
+}
 
-  gAutoKey.repeatCount++;
-  if (gAutoKey.repeatCount >= kAutoKeyRepeatsPerChord) {
-    gAutoKey.repeatCount = 0;
-    gAutoKey.seqIndex++;
-    if (gAutoKey.seqIndex >= kAutoKeySeqLength) {
-      gAutoKey.seqIndex = 0;
-    }
+// 换歌：已在 RAM 里就立刻从头播，否则等 songLibPoll
+void selectSong(int index) {
+  if (songLibSelect(index)) {
+    autoKeyReset();
+  } else if (index >= 0 && index < songLibCount()) {
+    TRACE(TR_SONG_LOADING, index);
   }
-  return chordIndex;
+}
+
+void printSongStatus() {
+  songLibPrintStatus();
+  Serial.print("  built-in: ");
+  Serial.print(kAutoKeySongBytes);
+  Serial.print(" B code (expanded int array ");
+  Serial.print(kAutoKeyExpandedBytes);
+  Serial.print(" B), ");
+  Serial.print(kAutoKeySongStrums);
+  Serial.println(" strums");
+  Serial.print("  at byte ");   Serial.print(gAutoKey.pos);
+  Serial.print(", section x");  Serial.print(gAutoKey.sectionLeft);
+  Serial.print(" left, ");
+  Serial.print(kChordVoicings[gAutoKey.chord].name);
+  Serial.print(" x");           Serial.print(gAutoKey.runLeft);
+  Serial.println(" left");
 }
 
 // 切音：立即停掉所有弦，并开启短噪声“啪”
-void triggerChoke() {
+void chokeNow() {
   // 停掉所有弦的声音
   for (int i = 0; i < kNumStrings; ++i) {
     gStrings[i].active = false;
@@ -215,113 +248,302 @@ void triggerChoke() {
 
   // 开启一个短噪声包络
   gChoke.active           = true;
-  gChoke.remainingSamples = kChokeLengthSamples;
+  gChoke.remainingSamples = gTone->chokeLengthSamples;
   gChoke.env              = 1.0f;
-
-  Serial.println("[Choke] CUT + smack");
 }
 
-// ============================================================
-// 5. Karplus–Strong 引擎：初始化 & 每 sample 更新
-// ============================================================
+void triggerChoke() {
+  chokeNow();
+  looperRecord(LOOP_EV_CHOKE, 0, 0, 0, 0.0f, 0, gSampleCounter);
+  TRACE(TR_CHOKE);
+}
 
-void initKSString(KSString &s, float freq, float decay, float targetRms) {
-  if (freq <= 0.0f) {
-    s.active = false;
-    return;
+// ---- 每弦调制（voice_mod.h） ----
+
+// 调制来源 → 一根弦的目标
+VoiceModParams modTargetFromSources() {
+  VoiceModParams t = kVoiceModNeutral;
+  if (gModSources.palmMute) {
+    t.decayMul  = kPalmMuteDecayMul;
+    t.brightMul = kPalmMuteBrightMul;
+    t.gain      = kPalmMuteGain;
+  } else if (gModSources.pedal) {
+    t.decayMul  = kPedalDecayMul;
   }
-  int len = (int)((float)kSampleRate / freq + 0.5f);
-  if (len < 2)           len = 2;
-  if (len > kMaxKsDelay) len = kMaxKsDelay;
-
-  s.length = len;
-  s.index  = 0;
-  s.decay  = decay;
-  s.active = true;
+  t.brightMul *= gModSources.brightMul;
+  return t;
+}
 
-  float prev  = 0.0f;
-  float sumSq = 0.0f;
+// 起音时：音色类调制直接到位（闷音扫弦一开始就是闷的），增益按 swell 从 0 开始
+void startVoiceMod(int s) {
+  VoiceMod &m = gVoiceMod[s];
+  m.target          = modTargetFromSources();
+  m.current         = m.target;
+  m.toneAlpha       = gRate.modToneAlpha;
+  m.damping         = false;
+  if (gModSources.swellMs > 0.0f) {
+    m.current.gain = 0.0f;
+    m.gainAlpha    = voiceModAlpha(gModSources.swellMs, gRate.samplesPerMs);
+  } else {
+    m.gainAlpha    = gRate.modGainAlpha;
+  }
+  gVoiceGainL[s] = gPanL[s] * m.current.gain;   // 块中间起音也立刻生效
+  gVoiceGainR[s] = gPanR[s] * m.current.gain;
+}
 
-  for (int i = 0; i < len; ++i) {
-    int r      = random(-32768, 32767);
-    float val  = (float)r / 32768.0f;
+// 止音：还在响的弦（弹响的或共鸣的）增益在 kStringDampMs 内滑到 0 再停掉，不硬切
+void dampString(int s) {
+  if (!gStrings[s].active) return;
+  VoiceMod &m = gVoiceMod[s];
+  m.damping   = true;
+  m.gainAlpha = gRate.stringDampAlpha;
+}
 
-    // 稍微做一点低通，避免太“沙”
-    val  = 0.4f * val + 0.6f * prev;
-    prev = val;
+// 止音结束（或 voice 已被别处停掉）：调制回到正常，下次起音 / 共鸣从这里开始
+void endStringDamp(int s) {
+  VoiceMod &m = gVoiceMod[s];
+  m.damping   = false;
+  m.gainAlpha = gRate.modGainAlpha;
+  m.target    = modTargetFromSources();
+  m.current   = m.target;
+}
 
-    s.buffer[i] = val;
-    sumSq      += val * val;
+// 每块开头一次：更新目标、平滑、交给 voice，并算好混音用的每弦增益
+void updateVoiceModulation() {
+  if (gModSources.palmMute && !gModSources.palmLatched &&
+      (int32_t)(gSampleCounter - gModSources.palmMuteUntil) >= 0) {
+    gModSources.palmMute = false;
   }
 
-  // 剩余 buffer 清零
-  for (int i = len; i < kMaxKsDelay; ++i) {
-    s.buffer[i] = 0.0f;
-  }
+  VoiceModParams target = modTargetFromSources();
+  for (int i = 0; i < kNumStrings; ++i) {
+    VoiceMod &m = gVoiceMod[i];
+    if (m.damping && !gStrings[i].active) endStringDamp(i);   // 切音 / 抢占已经停了
 
-  // 归一化 RMS
-  if (sumSq > 1e-6f) {
-    float rms   = sqrtf(sumSq / (float)len);
-    float scale = targetRms / rms;
-    for (int i = 0; i < len; ++i) {
-      s.buffer[i] *= scale;
+    if (m.damping) {
+      m.target.decayMul  = kStringDampDecayMul;
+      m.target.brightMul = target.brightMul;
+      m.target.gain      = 0.0f;
+    } else {
+      m.target.decayMul  = target.decayMul;
+      m.target.brightMul = target.brightMul;
+      m.target.gain      = target.gain;
+      if (m.gainAlpha != gRate.modGainAlpha && m.current.gain >= 0.99f * m.target.gain) {
+        m.gainAlpha = gRate.modGainAlpha;   // swell 结束后，增益恢复正常平滑速度
+      }
+    }
+
+    bool toneChanged = voiceModStep(m);
+    if (m.damping && m.current.gain < kStringDampOffGain) {
+      gStrings[i].active = false;        // 止音结束：停掉，sympProcess 之后可以按空弦唤起共鸣
+      endStringDamp(i);
+    }
+    if (gStrings[i].active) {
+#if GUITAR_VOICE_BACKEND == GUITAR_VOICE_WAVETABLE
+      modulateWavetableVoice(gStrings[i], m.current.decayMul);
+#else
+      if (toneChanged) gStrings[i].modulate(m.current.decayMul, m.current.brightMul);
+#endif
     }
+    gVoiceGainL[i] = gPanL[i] * m.current.gain;
+    gVoiceGainR[i] = gPanR[i] * m.current.gain;
   }
 }
 
-float processKSString(KSString &s) {
-  if (!s.active) return 0.0f;
-
-  int i0 = s.index;
-  int i1 = (s.index + 1);
-  if (i1 >= s.length) i1 = 0;
+// 闷音：手势是一次性事件，保持 kPalmMuteHoldMs
+void palmMuteAt(uint32_t atSample) {
+  gModSources.palmMute      = true;
+  gModSources.palmMuteUntil = atSample + gRate.palmMuteHoldSamples;
+}
 
-  float y = 0.5f * (s.buffer[i0] + s.buffer[i1]);
-  y *= s.decay;
+void triggerPalmMute() {
+  palmMuteAt(gSampleCounter);
+  looperRecord(LOOP_EV_PALM, 0, 0, 0, 0.0f, 0, gSampleCounter);
+  TRACE(TR_PALM_MUTE);
+}
 
-  s.buffer[i0] = y;
-  s.index      = i1;
+void setPedal(bool on) {
+  gModSources.pedal = on;
+  Serial.print("[Mod] pedal ");
+  Serial.println(on ? "down" : "up");
+}
 
-  return y;
+void setSwell(float ms) {
+  gModSources.swellMs = (ms > 0.0f) ? ms : 0.0f;
+  Serial.print("[Mod] swell ");
+  Serial.print(gModSources.swellMs, 0);
+  Serial.println(" ms");
 }
 
 // ============================================================
-// 6. 拨弦调度：六弦铺和弦 + 按时间触发 pluck + 扫弦封装
+// 5. 拨弦调度：六弦铺和弦 + 按时间触发 pluck + 扫弦封装
 // ============================================================
 
-void startPluck(int chordIndex, int stringIndex, float velocityNorm) {
-  if (chordIndex < 0 || chordIndex >= NUM_CHORDS) return;
-  if (stringIndex < 0 || stringIndex >= kNumStrings) return;
+int countActiveVoices() {
+  int n = 0;
+  for (int i = 0; i < kNumStrings; ++i) {
+    if (gStrings[i].active) n++;
+  }
+  return n;
+}
 
-  MidiChord &ch = chords[chordIndex];
-  if (ch.count < 3) return;
+// 弹响的弦（不含共鸣弦）：多弦归一按这个数，共鸣弦起落不改电平
+int countSoundingVoices() {
+  int n = 0;
+  for (int i = 0; i < kNumStrings; ++i) {
+    if (gStrings[i].active && !gSymp.resonating[i]) n++;
+  }
+  return n;
+}
 
-  uint8_t root  = ch.notes[0];
-  uint8_t third = ch.notes[1];
-  uint8_t fifth = ch.notes[2];
+// ---- 共鸣（琴桥耦合）----
 
-  uint8_t noteMidi;
-  switch (stringIndex) {
-    case 0: noteMidi = root  - 12; break;
-    case 1: noteMidi = fifth - 12; break;
-    case 2: noteMidi = root;       break;
-    case 3: noteMidi = third;      break;
-    case 4: noteMidi = fifth;      break;
-    default: noteMidi = root + 12; break;
+void sympReset() {
+  for (int i = 0; i < kNumStrings; ++i) {
+    gSymp.resonating[i] = false;
+    gSymp.feed[i]       = 1.0f;
+    gSymp.note[i]       = kStringOpenNotes[i];
   }
+  gSymp.highLp = 0.0f;
+  gSymp.lowLp  = 0.0f;
+}
 
-  float freq = midiToFreq(noteMidi);
+// 没在响的弦变成共鸣弦：按 gSymp.note 调好音，延迟线从静音开始
+void sympArm(int s) {
+#if GUITAR_VOICE_BACKEND != GUITAR_VOICE_WAVETABLE
+  const ToneCoefs &tc = *gTone;
+  float freq = midiToFreq(gSymp.note[s]) * tc.detuneRatio[s];
+  gStrings[s].resonate(freq, tc.ksDecayMin + tc.ksDecaySpan, tc.loopBrightnessMin);
+  gStrings[s].modulate(gVoiceMod[s].current.decayMul, gVoiceMod[s].current.brightMul);
+  gSymp.resonating[s] = true;
+  gSymp.feed[s]       = 0.0f;
+#else
+  (void)s;
+#endif
+}
 
-  float detune_cents = kDetuneCents[stringIndex];
-  float detune       = powf(2.0f, detune_cents / 1200.0f);
-  freq *= detune;
+// 本块弹响的弦之和过一次琴桥带通（所有弦共用），再加进每根共鸣弦的延迟线：
+// 每 sample 一个带通 + 每根共鸣弦一次乘加。琴桥有能量时，没在响的弦（预算内）唤起来共鸣。
+// 这里本身很便宜：贵的是唤起来的共鸣弦，每根都是一根逐 sample 渲染的完整 KS voice
+void sympProcess(int frames) {
+#if GUITAR_VOICE_BACKEND != GUITAR_VOICE_WAVETABLE
+  const float gain = gTone->sympGain;
+  if (gain <= 0.0f) return;
+
+  const float highAlpha = gRate.sympHighAlpha;
+  const float lowAlpha  = gRate.sympLowAlpha;
+  float hi = gSymp.highLp, lo = gSymp.lowLp, peak = 0.0f;
+  for (int i = 0; i < frames; ++i) {
+    hi += highAlpha * (gSymp.bridge[i] - hi);
+    lo += lowAlpha * (hi - lo);
+    float y = hi - lo;
+    gSymp.bridge[i] = y;
+    peak = fmaxf(peak, fabsf(y));
+  }
+  // 弦都停了以后输入是 0，和音色滤波一样别让状态衰减进非正规数
+  if (fabsf(hi) < kStateFlushFloor) hi = 0.0f;
+  if (fabsf(lo) < kStateFlushFloor) lo = 0.0f;
+  gSymp.highLp = hi;
+  gSymp.lowLp  = lo;
+
+  bool arm    = peak * gain >= kSympArmFloor;
+  int  voices = countActiveVoices();
+  for (int s = 0; s < kNumStrings; ++s) {
+    if (!gStrings[s].active) {
+      if (!arm || voices >= gRenderStats.voiceBudget) continue;
+      sympArm(s);
+      voices++;
+    } else if (!gSymp.resonating[s]) {
+      continue;
+    }
+    gStrings[s].inject(gSymp.bridge, frames, gain);
+  }
+#else
+  (void)frames;
+#endif
+}
 
-  float v        = constrain(velocityNorm, 0.0f, 1.0f);
-  float velScale = kVelRmsScaleMin + (kVelRmsScaleMax - kVelRmsScaleMin) * v;
-  float targetRms = kBaseNoiseTargetRms * velScale;
-  float decay     = kKsDecayMin + (kKsDecayMax - kKsDecayMin) * v;
+// 停掉最早起音的弦（exclude 除外），返回被停的弦号，没有返回 -1
+int stealOldestVoice(int exclude) {
+  // 共鸣弦最轻，先停
+  for (int i = 0; i < kNumStrings; ++i) {
+    if (i != exclude && gStrings[i].active && gSymp.resonating[i]) {
+      gStrings[i].active = false;
+      return i;
+    }
+  }
 
-  initKSString(gStrings[stringIndex], freq, decay, targetRms);
+  int      oldest = -1;
+  uint32_t bestAge = 0;
+  for (int i = 0; i < kNumStrings; ++i) {
+    if (i == exclude || !gStrings[i].active) continue;
+    uint32_t age = gSampleCounter - gVoiceStartSample[i];
+    if (oldest < 0 || age > bestAge) {
+      oldest  = i;
+      bestAge = age;
+    }
+  }
+  if (oldest >= 0) gStrings[oldest].active = false;
+  return oldest;
+}
+
+// 在 stringIndex 这根弦上弹 noteMidi
+void startNote(uint8_t noteMidi, int stringIndex, float velocityNorm);
+
+void startPluck(int chordIndex, int stringIndex, float velocityNorm) {
+  if (chordIndex < 0 || chordIndex >= NUM_CHORDS) return;
+  if (stringIndex < 0 || stringIndex >= kNumStrings) return;
+
+  // 扫弦不会排到不弹的弦；节奏型单拨到不弹的弦时换成最近的响弦
+  const ChordVoicing &cv = kChordVoicings[chordIndex];
+  int s = cv.pickString[stringIndex];
+  startNote(cv.notes[s], s, velocityNorm);
+}
+
+void startNote(uint8_t noteMidi, int stringIndex, float velocityNorm) {
+  if (stringIndex < 0 || stringIndex >= kNumStrings) return;
+
+  const ToneCoefs &tc = *gTone;
+  float v             = constrain(velocityNorm, 0.0f, 1.0f);
+
+  // 超出渲染预算时，新起音顶掉最早的一根弦
+  if (!gStrings[stringIndex].active &&
+      countActiveVoices() >= gRenderStats.voiceBudget) {
+    stealOldestVoice(stringIndex);
+  }
+  // 正在止音的弦不算还在响：整条重填，不把剩下的一点又拉回原音量
+  bool ringing = gStrings[stringIndex].active && !gVoiceMod[stringIndex].damping;
+  gVoiceStartSample[stringIndex] = gSampleCounter;
+  startVoiceMod(stringIndex);
+
+  // 弹响了：送进琴桥；停了以后按这个音共鸣
+  gSymp.resonating[stringIndex] = false;
+  gSymp.feed[stringIndex]       = 1.0f;
+  gSymp.note[stringIndex]       = noteMidi;
+
+#if GUITAR_VOICE_BACKEND == GUITAR_VOICE_WAVETABLE
+  // 预渲染音色已经包含力度层的衰减 / 亮度，只需要音高和力度
+  initWavetableVoice(gStrings[stringIndex], noteMidi, tc.detuneCents[stringIndex], v);
+  modulateWavetableVoice(gStrings[stringIndex], gVoiceMod[stringIndex].current.decayMul);
+  (void)ringing;
+#else
+  // detune 的 powf 在改参数时算好了
+  float freq = midiToFreq(noteMidi) * tc.detuneRatio[stringIndex];
+
+  float velScale  = tc.velRmsScaleMin + tc.velRmsScaleSpan * v;
+  float targetRms = tc.baseNoiseTargetRms * velScale;
+  float decay     = tc.ksDecayMin + tc.ksDecaySpan * v;
+  float bright    = tc.loopBrightnessMin + tc.loopBrightnessSpan * v;
+
+  // 还在响：新激励叠加进去（只动新长度那么多点），否则整条重填
+  if (ringing && tc.repluckKeep > 0.0f) {
+    gStrings[stringIndex].repluck(freq, decay, targetRms, bright, tc.repluckKeep);
+  } else {
+    gStrings[stringIndex].pluck(freq, decay, targetRms, bright);
+  }
+  gStrings[stringIndex].modulate(gVoiceMod[stringIndex].current.decayMul,
+                                 gVoiceMod[stringIndex].current.brightMul);
+#endif
 }
 
 void handleScheduledPlucks() {
@@ -329,68 +551,313 @@ void handleScheduledPlucks() {
     ScheduledPluck &sp = gPlucks[i];
     if (!sp.active) continue;
     if (gSampleCounter >= sp.triggerSample) {
-      startPluck(sp.chordIndex, sp.stringIndex, sp.velocityNorm);
+      if (sp.midiNote != 0) {
+        startNote(sp.midiNote, sp.stringIndex, sp.velocityNorm);
+      } else {
+        startPluck(sp.chordIndex, sp.stringIndex, sp.velocityNorm);
+      }
       sp.active = false;
     }
   }
 }
 
-void scheduleStrum(StrumDirection dir, int chordIndex, int velocity) {
-  if (chordIndex < 0 || chordIndex >= NUM_CHORDS) return;
-  if (velocity < 0)   velocity = 0;
-  if (velocity > 127) velocity = 127;
+// 距离下一个待触发 pluck 还有多少 sample（没有则返回 maxSamples）
+int samplesUntilNextPluck(int maxSamples) {
+  int n = maxSamples;
+  for (int i = 0; i < kMaxScheduledPlucks; ++i) {
+    const ScheduledPluck &sp = gPlucks[i];
+    if (!sp.active) continue;
+    int32_t d = (int32_t)(sp.triggerSample - gSampleCounter);
+    if (d < n) n = (d < 0) ? 0 : d;
+  }
+  return n;
+}
+
+// 排一个 pluck（midiNote = 0 按和弦算音高）；队列满了就丢掉
+void queueNote(uint32_t trigSample, int chordIndex, int stringIndex, float vNorm,
+               uint8_t midiNote) {
+  for (int i = 0; i < kMaxScheduledPlucks; ++i) {
+    if (!gPlucks[i].active) {
+      gPlucks[i].active        = true;
+      gPlucks[i].triggerSample = trigSample;
+      gPlucks[i].chordIndex    = chordIndex;
+      gPlucks[i].stringIndex   = stringIndex;
+      gPlucks[i].velocityNorm  = vNorm;
+      gPlucks[i].midiNote      = midiNote;
+      return;
+    }
+  }
+}
 
-  float vNorm = (float)velocity / 127.0f;
-  vNorm = 0.1f + 0.9f * vNorm;  // 保证最弱扫也有一点能量
+void queuePluck(uint32_t trigSample, int chordIndex, int stringIndex, float vNorm) {
+  queueNote(trigSample, chordIndex, stringIndex, vNorm, 0);
+}
 
-  float interDelayMs = kInterDelayMsSlow
-                       - vNorm * (kInterDelayMsSlow - kInterDelayMsFast);
-  if (interDelayMs < kInterDelayMsFast) interDelayMs = kInterDelayMsFast;
+// 一次扫弦：从 startSample 开始，弦与弦间隔 spreadSamples
+// 指法里不弹的弦不排队（也就不起音、不渲染）；第一根响弦在 startSample，
+// 中间夹着的不弹的弦照样占一个间隔（拨片还是要划过去）
+void queueStrum(StrumDirection dir, int chordIndex, float vNorm,
+                uint32_t startSample, uint32_t spreadSamples) {
+  if (chordIndex < 0 || chordIndex >= NUM_CHORDS) return;
 
-  Serial.print("Strum: ");
-  Serial.print((dir == STRUM_DOWN) ? "DOWN " : "UP   ");
-  Serial.print("Chord=");
-  Serial.print(chords[chordIndex].name);
-  Serial.print("  v=");
-  Serial.print(velocity);
-  Serial.print("  interDelayMs=");
-  Serial.println(interDelayMs);
+  // 闷音保持期间扫弦：继续闷（连续闷音扫弦）
+  if (gModSources.palmMute && !gModSources.palmLatched) {
+    gModSources.palmMuteUntil = startSample + gRate.palmMuteHoldSamples;
+  }
 
+  const ChordVoicing &cv = kChordVoicings[chordIndex];
+  int first = -1;
   for (int localIdx = 0; localIdx < kNumStrings; ++localIdx) {
     int stringIndex = (dir == STRUM_DOWN)
                         ? localIdx
                         : (kNumStrings - 1 - localIdx);
-
-    float offsetMs       = interDelayMs * localIdx;
-    uint32_t offsetSamples = (uint32_t)(offsetMs * 0.001f * (float)kSampleRate);
-    uint32_t trigSample    = gSampleCounter + offsetSamples;
-
-    for (int i = 0; i < kMaxScheduledPlucks; ++i) {
-      if (!gPlucks[i].active) {
-        gPlucks[i].active        = true;
-        gPlucks[i].triggerSample = trigSample;
-        gPlucks[i].chordIndex    = chordIndex;
-        gPlucks[i].stringIndex   = stringIndex;
-        gPlucks[i].velocityNorm  = vNorm;
-        break;
+    if (cv.notes[stringIndex] == kMutedString) {
+      // 没按：上一个和弦在这根弦上的音（弹响的，或按旧音共鸣的）止住，停了以后
+      // sympProcess 按空弦重新唤起；已经按空弦在共鸣的接着响
+      if (!gSymp.resonating[stringIndex] ||
+          gSymp.note[stringIndex] != kStringOpenNotes[stringIndex]) {
+        dampString(stringIndex);
       }
+      gSymp.note[stringIndex] = kStringOpenNotes[stringIndex];
+      continue;
     }
+    if (first < 0) first = localIdx;
+    queuePluck(startSample + spreadSamples * (localIdx - first), chordIndex, stringIndex, vNorm);
+  }
+}
+
+// 力度 0..127 → 0.1~1（保证最弱扫也有一点能量）
+float strumVelocityNorm(int velocity) {
+  if (velocity < 0)   velocity = 0;
+  if (velocity > 127) velocity = 127;
+  return 0.1f + 0.9f * ((float)velocity / 127.0f);
+}
+
+// 力度越大扫得越快
+float strumInterDelayMs(float vNorm) {
+  const ToneCoefs &tc = *gTone;
+  float interDelayMs = tc.interDelayMsSlow
+                       - vNorm * (tc.interDelayMsSlow - tc.interDelayMsFast);
+  if (interDelayMs < tc.interDelayMsFast) interDelayMs = tc.interDelayMsFast;
+  return interDelayMs;
+}
+
+void scheduleStrum(StrumDirection dir, int chordIndex, int velocity) {
+  if (chordIndex < 0 || chordIndex >= NUM_CHORDS) return;
+  if (velocity < 0)   velocity = 0;
+  if (velocity > 127) velocity = 127;
+
+  float vNorm        = strumVelocityNorm(velocity);
+  float interDelayMs = strumInterDelayMs(vNorm);
+
+  TRACE(TR_STRUM, (dir == STRUM_DOWN) ? "DOWN" : "UP  ", kChordVoicings[chordIndex].name,
+        velocity, interDelayMs);
+
+  uint32_t spread = (uint32_t)(interDelayMs * gRate.samplesPerMs);
+  queueStrum(dir, chordIndex, vNorm, gSampleCounter, spread);
+  looperRecord(dir == STRUM_UP ? LOOP_EV_STRUM_UP : LOOP_EV_STRUM_DOWN,
+               chordIndex, 0, 0, vNorm, spread, gSampleCounter);
+}
+
+// AutoKey 手势：选了节奏型就交给音序器弹一小节，否则扫一次下一个和弦
+void autoKeyStrum(StrumDirection dir, int velocity) {
+  if (seqPattern() >= 0) {
+    float vNorm = strumVelocityNorm(velocity);
+    // 定速播放时和弦由音序器按小节取，手势只改力度
+    int chordIndex = seqRunning() ? -1 : autoKeyNextChordIndex();
+    seqTrigger(gSampleCounter, chordIndex, vNorm);
+    return;
+  }
+  scheduleStrum(dir, autoKeyNextChordIndex(), velocity);
+}
+
+// ---- 音序器回调（pattern_seq.h）：时刻已经是 sample，直接进队列 ----
+void schedulePatternStrum(bool up, int chordIndex, float velocityNorm,
+                          uint32_t startSample, uint32_t spreadSamples) {
+  if (chordIndex < 0 || chordIndex >= NUM_CHORDS) return;
+  queueStrum(up ? STRUM_UP : STRUM_DOWN, chordIndex, velocityNorm,
+             startSample, spreadSamples);
+  looperRecord(up ? LOOP_EV_STRUM_UP : LOOP_EV_STRUM_DOWN,
+               chordIndex, 0, 0, velocityNorm, spreadSamples, startSample);
+}
+
+void schedulePatternPick(int chordIndex, int stringIndex, float velocityNorm,
+                         uint32_t triggerSample) {
+  if (chordIndex < 0 || chordIndex >= NUM_CHORDS) return;
+  queuePluck(triggerSample, chordIndex, stringIndex, velocityNorm);
+  looperRecord(LOOP_EV_PICK, chordIndex, (uint8_t)stringIndex, 0,
+               velocityNorm, 0, triggerSample);
+}
+
+// ---- looper 回放（event_looper.h）：和现场一样进队列，只是不再录一遍 ----
+void looperPlayEvent(const LoopEvent &e, uint32_t atSample) {
+  float vNorm = e.velocity / 255.0f;
+  switch (e.kind) {
+    case LOOP_EV_STRUM_DOWN:
+    case LOOP_EV_STRUM_UP:
+      queueStrum(e.kind == LOOP_EV_STRUM_UP ? STRUM_UP : STRUM_DOWN,
+                 e.chordIndex, vNorm, atSample, e.spread);
+      break;
+    case LOOP_EV_PICK:
+      queuePluck(atSample, e.chordIndex, e.arg, vNorm);
+      break;
+    case LOOP_EV_NOTE:
+      queueNote(atSample, 0, e.arg, vNorm, e.note);
+      break;
+    case LOOP_EV_CHOKE:
+      chokeNow();                 // 切音 / 闷音按块生效（最多早一块）
+      break;
+    case LOOP_EV_PALM:
+      palmMuteAt(atSample);
+      break;
   }
 }
 
+
 // ============================================================
-// 7. 输入处理：串口命令 / ATmega（含 AUTOKEY + 切音 + 主音量）
+// 6. 输入处理：串口命令 / ATmega（含 AUTOKEY + 切音 + 主音量）
 // ============================================================
 
 static const int CMD_BUF_SIZE = 64;
 char cmdBuf[CMD_BUF_SIZE];
 int  cmdLen = 0;
 
+void printMidiStats();
+
 void setInputMode(InputMode mode) {
   if (gInputMode == mode) return;
+  // 可能是 MIDI 里的退出 SysEx 调过来的（渲染循环里）：统计走 TRACE
+  if (gInputMode == INPUT_MODE_MIDI && gMidiStats.bytes > 0) {
+    float cpuMHz = (float)ESP.getCpuFreqMHz();
+    TRACE(TR_MIDI_STATS, gMidiStats.bytes, gMidiStats.messages,
+          gMidiStats.messages ? (float)gMidiStats.cycles / gMidiStats.messages / cpuMHz : 0.0f,
+          (float)gMidiStats.maxCycles / cpuMHz);
+  }
   gInputMode = mode;
-  Serial.print("Mode: ");
-  Serial.println((mode == INPUT_MODE_SERIAL) ? "Serial" : "ATmega");
+  TRACE(TR_MODE, (mode == INPUT_MODE_SERIAL) ? "Serial"
+                 : (mode == INPUT_MODE_MIDI) ? "MIDI (send F0 7D 7F F7 to leave)"
+                                             : "ATmega");
+  if (mode == INPUT_MODE_MIDI) {
+    midiParserReset(gMidiParser);
+    memset(&gMidiStats, 0, sizeof(gMidiStats));
+  }
+}
+
+void stopAllVoices() {
+  for (int i = 0; i < kNumStrings; ++i) {
+    gStrings[i].active = false;
+  }
+  for (int i = 0; i < kMaxScheduledPlucks; ++i) {
+    gPlucks[i].active = false;
+  }
+  gChoke.active = false;
+  seqStop();
+}
+
+void resetToneState() {
+  for (int c = 0; c < 2; ++c) {
+    gToneState[c].lpTone = 0.0f;
+    gToneState[c].lpBody = 0.0f;
+  }
+}
+
+// 等功率 pan：pan -1..1 → 角度 0..π/2，L = cos，R = sin
+void initPanGains() {
+  for (int i = 0; i < kNumStrings; ++i) {
+    float a  = (kStringPan[i] + 1.0f) * 0.25f * (float)M_PI;
+    gPanL[i] = cosf(a);
+    gPanR[i] = sinf(a);
+  }
+}
+
+// 选择琴箱处理；CONV 需要 IR 能按当前采样率加载，否则退回 TONE
+void setBodyMode(BodyMode mode) {
+  gBody.requested  = mode;
+  gBody.active     = BODY_TONE;
+  gBody.overBlocks = 0;
+  if (mode == BODY_CONV) {
+    if (bodyConvLoad(gRate.sampleRate)) {
+      gBody.active = BODY_CONV;
+    } else {
+      Serial.println("[Body] no IR, using tone filters");
+    }
+  }
+}
+
+void printBodyStatus() {
+  Serial.print("Body: ");
+  Serial.print(gBody.active == BODY_CONV ? "conv" : "tone");
+  if (gBody.requested != gBody.active) Serial.print(" (conv requested)");
+  if (gBody.active == BODY_CONV) {
+    Serial.print(", ");
+    Serial.print(bodyConvPartitions());
+    Serial.print(" partitions, last ");
+    Serial.print(gBody.lastCycles);
+    Serial.print(" cyc");
+  }
+  Serial.println();
+}
+
+// 切换采样率：停掉所有声音，重算 gRate。reinitI2S = false 时只换参数（bench 用）
+bool setSampleRate(int rate, bool reinitI2S) {
+  if (!isSupportedRate(rate)) return false;
+
+  stopAllVoices();
+  gRate             = computeRateParams(rate);
+  paramsSetRate(rate);
+  resetToneState();
+  sympReset();
+  gRenderStats.loadPeak    = 0.0f;
+  gRenderStats.voiceBudget = kNumStrings;
+  masterBusReset();
+  setBodyMode(gBody.requested);   // IR 按新采样率重采样
+  fxReconfigure(rate);
+  seqSetRate(rate);               // 节奏型偏移表按新采样率重算
+
+  if (reinitI2S) {
+    // 听到的采样率真的变了才清 loop（按 sample 存的）；bench 临时换采样率时
+    // loop 由 engineHoldLoopers 暂停，测完换回原采样率，内容还能用
+    looperSetRate(rate);
+    audioLoopSetRate(rate);
+    i2s.end();
+    if (!i2s.begin(I2S_MODE_STD, rate, I2S_DATA_BIT_WIDTH_16BIT, I2S_SLOT_MODE_STEREO)) {
+      Serial.println("Failed to re-initialize I2S!");
+      return false;
+    }
+  }
+  return true;
+}
+
+void printRenderStats() {
+  float blockUs = 1e6f * (float)kBlockFrames / (float)gRate.sampleRate;
+  Serial.print("Rate ");          Serial.print(gRate.sampleRate);
+  Serial.print(" Hz, block ");    Serial.print(kBlockFrames);
+  Serial.print(" (");             Serial.print(blockUs, 0);
+  Serial.println(" us)");
+  Serial.print("  load avg ");    Serial.print(gRenderStats.loadAvg * 100.0f, 1);
+  Serial.print("%  peak ");       Serial.print(gRenderStats.loadPeak * 100.0f, 1);
+  Serial.print("%  last ");       Serial.print(gRenderStats.lastCycles);
+  Serial.println(" cyc");
+  Serial.print("  overruns ");    Serial.print(gRenderStats.overruns);
+  Serial.print(" / ");            Serial.print(gRenderStats.blocks);
+  Serial.print(" blocks, voice budget ");
+  Serial.print(gRenderStats.voiceBudget);
+  Serial.print("/");              Serial.println(kNumStrings);
+  Serial.print("  voices ");       Serial.print(countSoundingVoices());
+  Serial.print(" sounding + ");    Serial.print(engineResonatingVoices());
+  Serial.print(" resonating (symp "); Serial.print(gTone->sympGain, 4);
+  Serial.println(")");
+  Serial.print("  limiter gain ");
+  Serial.println(masterBusLimiterGain(), 3);
+}
+
+// 命令参数是不是一个非负整数（toInt() 遇到非数字会返回 0，不能拿它判断）
+bool isAllDigits(const String &s) {
+  if (s.length() == 0) return false;
+  for (unsigned i = 0; i < s.length(); ++i) {
+    if (!isDigit(s[i])) return false;
+  }
+  return true;
 }
 
 void processCommand(const char *cmd) {
@@ -409,10 +876,12 @@ void processCommand(const char *cmd) {
       setInputMode(INPUT_MODE_SERIAL);
     } else if (low == "atmega" || low == "hw") {
       setInputMode(INPUT_MODE_ATMEGA);
+    } else if (low == "midi") {
+      setInputMode(INPUT_MODE_MIDI);
     } else {
       Serial.print("Unknown mode: ");
       Serial.println(line);
-      Serial.println("Valid: mode serial | mode atmega");
+      Serial.println("Valid: mode serial | mode atmega | mode midi");
     }
     return;
   }
@@ -443,6 +912,273 @@ void processCommand(const char *cmd) {
     return;
   }
 
+  // ---------- 1.52) 演奏调制：palm [on|off] / pedal on|off / swell <ms> ----------
+  if (low.startsWith("palm")) {
+    low.remove(0, 4);
+    low.trim();
+    if (low == "off") {
+      gModSources.palmMute    = false;
+      gModSources.palmLatched = false;
+      Serial.println("[Mod] palm mute off");
+    } else if (low == "on") {
+      gModSources.palmMute    = true;
+      gModSources.palmLatched = true;
+      Serial.println("[Mod] palm mute on");
+    } else {
+      triggerPalmMute();   // 和 PALM_MUTE 手势一样
+    }
+    return;
+  }
+  if (low.startsWith("pedal")) {
+    low.remove(0, 5);
+    low.trim();
+    setPedal(low == "on" || low == "down");
+    return;
+  }
+  if (low.startsWith("swell")) {
+    low.remove(0, 5);
+    low.trim();
+    setSwell(low.toFloat());
+    return;
+  }
+
+  // ---------- 1.54) seed [n]：噪声种子（同一种子 + 同样输入 → 同样的声音） ----------
+  if (low.startsWith("seed")) {
+    low.remove(0, 4);
+    low.trim();
+    if (low.length() > 0) {
+      gNoiseSeed = (uint32_t)strtoul(low.c_str(), nullptr, 0);
+      noiseSeed(gNoise, gNoiseSeed);
+    }
+    Serial.print("Noise seed ");
+    Serial.println(gNoiseSeed);
+    return;
+  }
+
+  // ---------- 1.545) get [name] / set <name> [string] <value> / save / preset [name|list] ----------
+  if (low == "get" || low.startsWith("get ")) {
+    low.remove(0, 3);
+    low.trim();
+    paramsPrint(low.c_str());
+    return;
+  }
+  if (low.startsWith("set ")) {
+    char  name[24];
+    float a = 0.0f, b = 0.0f;
+    int   n = sscanf(low.c_str() + 4, "%23s %f %f", name, &a, &b);
+    // 数组参数（detune）只认 set detune <弦 1..6> <值>，少了弦号不能当成第 1 根弦
+    int  count = (n >= 2) ? paramsCount(name) : 0;
+    bool ok    = (n == 2 && count == 1 && paramsSet(name, 0, a)) ||
+                 (n == 3 && count > 1  && paramsSet(name, (int)a - 1, b));
+    if (!ok) {
+      Serial.println("Usage: set <name> <value> | set detune <string 1..6> <cents>  (get lists names)");
+      return;
+    }
+    paramsPrint(name);
+    return;
+  }
+  if (low == "save") {
+    Serial.println(paramsSave() ? "[Params] saved" : "[Params] save failed");
+    return;
+  }
+  if (low.startsWith("preset")) {
+    low.remove(0, 6);
+    low.trim();
+    if (low.length() == 0 || low == "list") {
+      paramsPrintPresets();
+    } else if (paramsPreset(low.c_str())) {
+      Serial.print("[Params] preset ");
+      Serial.print(low);
+      Serial.println(" (save to keep)");
+    } else {
+      Serial.print("Unknown preset: ");
+      Serial.println(low);
+      paramsPrintPresets();
+    }
+    return;
+  }
+
+  // ---------- 1.55) rate 16000|22050|44100|48000 / stats ----------
+  if (low.startsWith("rate")) {
+    low.remove(0, 4);
+    low.trim();
+    int rate = low.toInt();
+    if (!setSampleRate(rate, true)) {
+      Serial.println("Usage: rate 16000|22050|44100|48000");
+      return;
+    }
+    Serial.print("Sample rate set to ");
+    Serial.println(rate);
+    return;
+  }
+  // ---------- 1.554) tempo <bpm> / pattern [name|off|run|stop|list] ----------
+  if (low.startsWith("tempo")) {
+    low.remove(0, 5);
+    low.trim();
+    if (low.length() > 0) seqSetTempo(low.toFloat());
+    seqPrintStatus();
+    return;
+  }
+  if (low.startsWith("pattern")) {
+    low.remove(0, 7);
+    low.trim();
+    if (low == "list") {
+      seqPrintList();
+      return;
+    }
+    if (low == "off") {
+      seqSetPattern(-1);
+    } else if (low == "run") {
+      seqRun(true, gSampleCounter);
+    } else if (low == "stop") {
+      seqRun(false, gSampleCounter);
+    } else if (low.length() > 0) {
+      int idx = seqFindPattern(low.c_str());
+      if (idx < 0) {
+        Serial.println("Unknown pattern, try: pattern list");
+        return;
+      }
+      seqSetPattern(idx);
+    }
+    seqPrintStatus();
+    return;
+  }
+
+  // ---------- 1.556) loop [tap|play|stop|clear]：事件 looper ----------
+  if (low.startsWith("loop")) {
+    low.remove(0, 4);
+    low.trim();
+    if (low == "tap") {
+      looperTap(gSampleCounter);
+    } else if (low == "play") {
+      looperPlay(gSampleCounter);
+    } else if (low == "stop") {
+      looperStop(gSampleCounter);
+    } else if (low == "clear") {
+      looperClear();
+    } else if (low.length() > 0) {
+      Serial.println("Usage: loop [tap|play|stop|clear]");
+      return;
+    }
+    looperPrintStatus();
+    return;
+  }
+
+  // ---------- 1.557) aloop [tap|play|stop|clear|level x]：音频 looper ----------
+  if (low.startsWith("aloop")) {
+    low.remove(0, 5);
+    low.trim();
+    if (low == "tap") {
+      audioLoopTap();
+    } else if (low == "play") {
+      audioLoopPlay();
+    } else if (low == "stop") {
+      audioLoopStop();
+    } else if (low == "clear") {
+      audioLoopClear();
+    } else if (low.startsWith("level")) {
+      low.remove(0, 5);
+      low.trim();
+      audioLoopSetLevel(low.toFloat());
+    } else if (low.length() > 0) {
+      Serial.println("Usage: aloop [tap|play|stop|clear|level 0..1]");
+      return;
+    }
+    audioLoopPrintStatus();
+    return;
+  }
+
+  // ---------- 1.558) tap [on [decim]|off]：PCM 抓取（tools/pcm_tap_to_wav.py） ----------
+  if (low.startsWith("tap")) {
+    low.remove(0, 3);
+    low.trim();
+    if (low.startsWith("on")) {
+      low.remove(0, 2);
+      low.trim();
+      pcmTapStart(low.length() > 0 ? low.toInt() : 1);
+    } else if (low == "off") {
+      pcmTapStop();
+    } else if (low.length() > 0) {
+      Serial.println("Usage: tap [on [1|2|4|8] | off]");
+      return;
+    }
+    pcmTapPrintStats();
+    return;
+  }
+
+  // ---------- 1.555) song [n|list]：AutoKey 歌曲 ----------
+  if (low.startsWith("song")) {
+    low.remove(0, 4);
+    low.trim();
+    if (low == "list") {
+      songLibPrintList();
+    } else if (isAllDigits(low)) {
+      selectSong(low.toInt());
+    } else if (low.length() > 0) {
+      Serial.println("Usage: song [n|list]");
+    } else {
+      printSongStatus();
+    }
+    return;
+  }
+  if (low == "stats") {
+    printRenderStats();
+    printMidiStats();
+    printBodyStatus();
+    fxPrintStats();
+    traceStats();
+    return;
+  }
+
+  // ---------- 1.58) fx on|off：效果器链（合唱 + 混响，core 0） ----------
+  if (low.startsWith("fx")) {
+    low.remove(0, 2);
+    low.trim();
+    if (low == "on") {
+      fxSetEnabled(true);
+    } else if (low == "off") {
+      fxSetEnabled(false);
+    } else if (low.length() > 0) {
+      Serial.println("Usage: fx on|off");
+      return;
+    }
+    fxPrintStats();
+    return;
+  }
+
+  // ---------- 1.57) body conv|tone：琴箱 IR 卷积 / 一阶滤波 ----------
+  if (low.startsWith("body")) {
+    low.remove(0, 4);
+    low.trim();
+    if (low == "conv") {
+      setBodyMode(BODY_CONV);
+    } else if (low == "tone") {
+      setBodyMode(BODY_TONE);
+    } else if (low.length() > 0) {
+      Serial.println("Usage: body conv|tone");
+      return;
+    }
+    printBodyStatus();
+    return;
+  }
+
+  // ---------- 1.6) bench [name]：跑性能测试（期间音频会暂停） ----------
+  if (low.startsWith("bench")) {
+    low.remove(0, 5);
+    low.trim();
+    runBenchmarks(low.c_str());
+    return;
+  }
+
+  // ---------- 1.61) soak <minutes> [seed]：长时间随机演奏（期间音频会暂停） ----------
+  if (low.startsWith("soak")) {
+    float    minutes = 0.0f;
+    unsigned seed    = gNoiseSeed;
+    sscanf(low.c_str() + 4, "%f %u", &minutes, &seed);
+    runSoak(minutes, seed);
+    return;
+  }
+
   // ---------- 2) Serial 切音：行首是 m / M ----------
   //
   // 语法示例：
@@ -476,8 +1212,7 @@ void processCommand(const char *cmd) {
       if (velAk < 0)   velAk = 0;
       if (velAk > 127) velAk = 127;
 
-      int chordIndex = autoKeyNextChordIndex();
-      scheduleStrum(dir, chordIndex, velAk);
+      autoKeyStrum(dir, velAk);
       return;
     }
   }
@@ -508,15 +1243,131 @@ void processCommand(const char *cmd) {
     Serial.print(NUM_CHORDS - 1);
     Serial.println(", velocity 0..127)");
     Serial.println("  m            (cut current sound, short smack)");
+    Serial.println("  palm         (palm mute: strings keep ringing, damped; on|off to hold)");
+    Serial.println("  pedal on     (sustain pedal: on|off)");
+    Serial.println("  swell 300    (new notes fade in over 300 ms, 0 = off)");
+    Serial.println("  seed 1234    (reseed noise: same seed + same input = same render)");
+    Serial.println("  get [name]   (tone / feel params; set <name> <value>, save, preset <name>|list)");
     Serial.println("  u ak 127     (AutoKey UP   with velocity 127)");
     Serial.println("  d ak 90      (AutoKey DOWN with velocity 90)");
+    Serial.println("  song 2       (AutoKey song: <n> select, list, none = status)");
+    Serial.println("  pattern folk (AutoKey plays a pattern per gesture: <name>|off|run|stop|list)");
+    Serial.println("  tempo 100    (pattern tempo in bpm)");
+    Serial.println("  loop tap     (event looper: rec -> play -> overdub; play|stop|clear)");
+    Serial.println("  aloop tap    (audio looper in PSRAM; play|stop|clear|level 0.8)");
+    Serial.println("  tap on 4     (stream I2S PCM / 4 over serial; tap off)");
     Serial.println("  vol 80       (set master volume to 80%)");
+    Serial.println("  rate 44100   (output rate: 16000|22050|44100|48000)");
+    Serial.println("  stats        (render load / overruns / voice budget)");
+    Serial.println("  body conv    (body: IR convolution | tone filters)");
+    Serial.println("  fx on        (chorus + reverb on core 0: on|off)");
+    Serial.println("  bench [name] (run benchmarks, 'bench list' for names)");
+    Serial.println("  soak 30 [7]  (30 simulated minutes of random playing, seed 7)");
     Serial.println("  mode serial  (switch to serial debug input)");
     Serial.println("  mode atmega  (use ATmega UART chord input)");
+    Serial.println("  mode midi    (USB serial becomes a MIDI byte stream)");
   }
 }
 
+// ---- MIDI 输入（mode midi）----
+//
+// 只走不打印的内部接口：串口这时是 MIDI 线，回显会被主机当成 MIDI 数据
+
+// 单音落在哪根弦
+int midiStringForNote(uint8_t note) {
+  int s = 0;
+  for (int i = 1; i < kNumStrings; ++i) {
+    if (note >= kStringOpenNotes[i]) s = i;
+  }
+  return s;
+}
+
+void handleMidiMessage(const MidiMessage &m) {
+  uint8_t type    = m.status & 0xF0;
+  uint8_t channel = m.status & 0x0F;
+
+  switch (type) {
+    case 0x90: {
+      if (m.data2 == 0) break;            // velocity 0 = note off：吉他自己衰减
+      float vNorm = strumVelocityNorm(m.data2);
+      int   chord = (int)m.data1 - kMidiChordBaseNote;
+      if (channel <= 1 && chord >= 0 && chord < NUM_CHORDS) {
+        if (seqPattern() >= 0 && !seqRunning()) {
+          seqTrigger(gSampleCounter, chord, vNorm);
+        } else {
+          uint32_t spread = (uint32_t)(strumInterDelayMs(vNorm) * gRate.samplesPerMs);
+          StrumDirection dir = (channel == 1) ? STRUM_UP : STRUM_DOWN;
+          queueStrum(dir, chord, vNorm, gSampleCounter, spread);
+          looperRecord(dir == STRUM_UP ? LOOP_EV_STRUM_UP : LOOP_EV_STRUM_DOWN,
+                       chord, 0, 0, vNorm, spread, gSampleCounter);
+        }
+      } else {
+        int string = midiStringForNote(m.data1);
+        queueNote(gSampleCounter, 0, string, vNorm, m.data1);
+        looperRecord(LOOP_EV_NOTE, 0, (uint8_t)string, m.data1, vNorm, 0, gSampleCounter);
+      }
+      break;
+    }
+    case 0xB0:
+      switch (m.data1) {
+        case 1:   gModSources.brightMul = 1.0f - (1.0f - kMidiModBrightMin) * m.data2 / 127.0f; break;
+        case 7:   gMasterVolume = m.data2 / 127.0f;  break;
+        case 64:  gModSources.pedal = m.data2 >= 64; break;
+        case 120: stopAllVoices();                   break;
+        case 123:
+          chokeNow();
+          looperRecord(LOOP_EV_CHOKE, 0, 0, 0, 0.0f, 0, gSampleCounter);
+          break;
+        case 80:  if (m.data2 >= 64) looperTap(gSampleCounter); break;
+        case 81:  if (m.data2 >= 64) looperClear();             break;
+        default:  break;
+      }
+      break;
+    case 0xC0:
+      seqSetPattern(m.data1 == 0 ? -1 : (int)m.data1 - 1);
+      break;
+    case 0xF0:
+      // 只认 F0 7D 7F F7 这一条，前两个字节相同但更长的 SysEx 不算
+      if (m.sysexLen == 2 && m.data1 == kMidiExitSysexId && m.data2 == kMidiExitSysexCmd) {
+        setInputMode(INPUT_MODE_SERIAL);
+      }
+      break;
+    default:
+      break;                              // note off / 压力 / 弯音：吉他用不上
+  }
+}
+
+void handleMidiInput() {
+  MidiMessage msg;
+  while (Serial.available() && gInputMode == INPUT_MODE_MIDI) {
+    uint32_t t0 = ESP.getCycleCount();
+    uint8_t  b  = (uint8_t)Serial.read();
+    gMidiStats.bytes++;
+    if (!midiParseByte(gMidiParser, b, msg)) continue;
+    handleMidiMessage(msg);
+    uint32_t dt = ESP.getCycleCount() - t0;
+    gMidiStats.messages++;
+    gMidiStats.cycles += dt;
+    if (dt > gMidiStats.maxCycles) gMidiStats.maxCycles = dt;
+  }
+}
+
+void printMidiStats() {
+  if (gMidiStats.bytes == 0) return;
+  float cpuMHz = (float)ESP.getCpuFreqMHz();
+  Serial.print("MIDI: ");         Serial.print(gMidiStats.bytes);
+  Serial.print(" bytes, ");       Serial.print(gMidiStats.messages);
+  Serial.print(" messages, avg ");
+  Serial.print(gMidiStats.messages ? (float)gMidiStats.cycles / gMidiStats.messages / cpuMHz : 0.0f, 2);
+  Serial.print(" us/msg (max ");  Serial.print((float)gMidiStats.maxCycles / cpuMHz, 2);
+  Serial.println(" us)");
+}
+
 void handleSerial() {
+  if (gInputMode == INPUT_MODE_MIDI) {
+    handleMidiInput();
+    return;
+  }
   while (Serial.available()) {
     char c = Serial.read();
     if (c == '\r') continue;
@@ -544,6 +1395,33 @@ void handleAtmegaInput() {
     return;  // 还没收到完整一帧
   }
 
+  // 控制帧：第三个字段是参数，不是力度，也不带音量
+  //   SONG|SELECT|<n>     选歌
+  //   TEMPO|SET|<bpm>     节奏型速度
+  //   LOOP|TAP|0          looper 踩一下；LOOP|CLEAR|0 清空
+  if (chord.equalsIgnoreCase("SONG")) {
+    if (gesture.equalsIgnoreCase("SELECT")) {
+      selectSong(vel);
+    }
+    return;
+  }
+  if (chord.equalsIgnoreCase("LOOP")) {
+    if (gesture.equalsIgnoreCase("TAP")) {
+      looperTap(gSampleCounter);
+    } else if (gesture.equalsIgnoreCase("CLEAR")) {
+      looperClear();
+    }
+    TRACE(TR_ATMEGA_LOOP, looperStateName(looperState()));
+    return;
+  }
+  if (chord.equalsIgnoreCase("TEMPO")) {
+    if (gesture.equalsIgnoreCase("SET")) {
+      seqSetTempo(constrain((float)vel, kPatternMinBpm, kPatternMaxBpm));
+      TRACE(TR_ATMEGA_TEMPO, (int)seqTempo());
+    }
+    return;
+  }
+
   // clamp 一下，防错
   if (vel < 0)      vel = 0;
   if (vel > 127)    vel = 127;
@@ -553,20 +1431,31 @@ void handleAtmegaInput() {
   // 更新主音量（映射到 0.0~1.0）
   gMasterVolume = volume / 127.0f;
 
-  Serial.print("Received Chord:   ");  Serial.println(chord);
-  Serial.print("Received Gesture: ");  Serial.println(gesture);
-  Serial.print("Received Velocity:");  Serial.println(vel);
-  Serial.print("Received Volume: ");   Serial.println(volume);
-
   String g = gesture;
   g.toUpperCase();
 
-  // --- 切音手势：MUTE / CHOKE / CUT 之类 ---
-  if (g.indexOf("MUTE") >= 0 || g.indexOf("CHOKE") >= 0 || g.indexOf("CUT") >= 0) {
+  // trace 只存指针：和弦名用 kChordVoicings 里的，手势归到固定的几个字符串
+  bool autoKey    = chord.equalsIgnoreCase("AUTOKEY");
+  int  chordIndex = autoKey ? -1 : chordNameToIndex(chord);
+  const char *gestureName = (g.indexOf("CHOKE") >= 0 || g.indexOf("CUT") >= 0) ? "CHOKE"
+                            : (g.indexOf("MUTE") >= 0) ? "MUTE"
+                            : (g.indexOf("UP") >= 0)   ? "UP"
+                                                       : "DOWN";
+  TRACE(TR_ATMEGA_FRAME, autoKey ? "AUTOKEY" : (chordIndex >= 0 ? kChordVoicings[chordIndex].name : "?"),
+        gestureName, vel, volume);
+
+  // --- 切音手势：CHOKE / CUT ---
+  if (g.indexOf("CHOKE") >= 0 || g.indexOf("CUT") >= 0) {
     triggerChoke();
     return;
   }
 
+  // --- 闷音手势：MUTE / PALM_MUTE（弦继续响，只是闷） ---
+  if (g.indexOf("MUTE") >= 0) {
+    triggerPalmMute();
+    return;
+  }
+
   // --- 普通 up/down 扫弦 ---
   StrumDirection dir;
   if (g.indexOf("UP") >= 0) {
@@ -576,18 +1465,16 @@ void handleAtmegaInput() {
   }
 
   // AUTOKEY 模式：Chord = "AUTOKEY"
-  if (chord.equalsIgnoreCase("AUTOKEY")) {
-    int chordIndex = autoKeyNextChordIndex();
-    scheduleStrum(dir, chordIndex, vel);
+  if (autoKey) {
+    autoKeyStrum(dir, vel);
     return;
   }
 
   // 其它普通和弦：重置 AutoKey 状态
   autoKeyReset();
 
-  int chordIndex = chordNameToIndex(chord);
   if (chordIndex < 0) {
-    Serial.println("Unknown chord name from ATmega, ignoring.");
+    TRACE(TR_ATMEGA_UNKNOWN);
     return;
   }
 
@@ -595,68 +1482,274 @@ void handleAtmegaInput() {
 }
 
 // ============================================================
-// 8. 音频渲染 & Arduino 入口
+// 7. 音频渲染 & Arduino 入口
 // ============================================================
 
-float mixAndShapeOutput() {
-  float out = 0.0f;
-  int activeCount = 0;
-
-  // 1) 所有弦的混音
+// 每个 sample：所有弦按声像相加（归一在 masterBusNormalize 里按块做）
+// bridge：弹响的弦之和（共鸣用，共鸣弦不算）
+void mixVoicesFrame(float &left, float &right, float &bridge) {
+  float l = 0.0f, r = 0.0f, b = 0.0f;
   for (int i = 0; i < kNumStrings; ++i) {
     if (gStrings[i].active) {
-      out += processKSString(gStrings[i]);
-      activeCount++;
+#if GUITAR_VOICE_BACKEND == GUITAR_VOICE_WAVETABLE
+      float v = processWavetableVoice(gStrings[i]);
+#else
+      float v = gStrings[i].process();
+#endif
+      l += v * gVoiceGainL[i];
+      r += v * gVoiceGainR[i];
+      b += v * gSymp.feed[i];
     }
   }
-  if (activeCount > 0) {
-    out /= (float)activeCount;
-  }
+  left   = l;
+  right  = r;
+  bridge = b;
+}
+
+// 切音噪声 “啪”（不参与多弦归一，放在中间）
+void addChokeNoise(float *left, float *right, int frames) {
+  if (!gChoke.active) return;
 
-  // 2) 切音噪声 “啪”
-  if (gChoke.active) {
-    int r = random(-32768, 32767);
-    float n = (float)r / 32768.0f;
-    n *= (kChokeBaseAmp * gChoke.env);
+  static float noise[kBlockFrames];
+  if (frames > kBlockFrames) frames = kBlockFrames;
+  noiseFill(gNoise, noise, frames, gTone->chokeBaseAmp);
+  float envDecay = gTone->chokeEnvDecay;
 
-    out += n;
+  for (int i = 0; i < frames && gChoke.active; ++i) {
+    float n = noise[i] * gChoke.env;
+    left[i]  += n;
+    right[i] += n;
 
-    gChoke.env *= kChokeEnvDecay;
+    gChoke.env *= envDecay;
     gChoke.remainingSamples--;
     if (gChoke.remainingSamples <= 0 || fabsf(gChoke.env) < 1e-3f) {
       gChoke.active = false;
     }
   }
+}
+
+// Tone shaping：presence + 箱体低频（没有 IR 时的琴箱）
+void applyToneFilters(float *buf, int frames, ToneState &st) {
+  const float toneAlpha = gTone->lpToneAlpha;
+  const float presMix   = gTone->presenceMix;
+  const float bodyAlpha = gTone->bodyAlpha;
+  const float bodyMix   = gTone->bodyMix;
+  for (int i = 0; i < frames; ++i) {
+    float out = buf[i];
+    st.lpTone += toneAlpha * (out - st.lpTone);
+    float presence = out - st.lpTone;
+    float shaped   = (1.0f - presMix) * out + presMix * presence;
+
+    st.lpBody += bodyAlpha * (shaped - st.lpBody);
+    buf[i] = (1.0f - bodyMix) * shaped + bodyMix * st.lpBody;
+  }
+  // 弦都停了以后输入是 0，低通状态会一直衰减进非正规数
+  if (fabsf(st.lpTone) < kStateFlushFloor) st.lpTone = 0.0f;
+  if (fabsf(st.lpBody) < kStateFlushFloor) st.lpBody = 0.0f;
+}
+
+// 琴箱：整块走 IR 卷积（L / R 一次复数 FFT）；卷积连续超预算时退回 ToneState
+void applyBody(float *left, float *right, int frames) {
+  if (gBody.active != BODY_CONV || frames != kBlockFrames) {
+    applyToneFilters(left,  frames, gToneState[0]);
+    applyToneFilters(right, frames, gToneState[1]);
+    return;
+  }
+
+  uint32_t t0 = ESP.getCycleCount();
+  bodyConvProcess(left, right);
+  gBody.lastCycles = ESP.getCycleCount() - t0;
+
+  float budgetCycles = (float)ESP.getCpuFreqMHz() * 1e6f
+                       * (float)kBlockFrames / (float)gRate.sampleRate;
+  if ((float)gBody.lastCycles > kBodyConvMaxLoad * budgetCycles) {
+    if (++gBody.overBlocks >= kBodyConvOverBlocks) {
+      gBody.active = BODY_TONE;
+      resetToneState();
+      TRACE(TR_BODY_FALLBACK);   // 正是渲染核超预算的时候，不能同步打印
+    }
+  } else {
+    gBody.overBlocks = 0;
+  }
+}
+
+// 渲染一块：在 pluck 触发点切开，保证起音 sample 精确，
+// 又不用每个 sample 扫一遍 gPlucks[]；之后整块过归一、琴箱和总线
+void renderBlock(float *left, float *right, int frames) {
+  paramsSwap();                        // 串口改过参数：整份系数在块边界换上
+  updateVoiceModulation();
+  seqUpdate(gSampleCounter, frames);   // 本块内到期的节奏型步进 pluck 队列
+  looperUpdate(gSampleCounter, frames);
+
+  int done = 0;
+  while (done < frames) {
+    handleScheduledPlucks();
+    int n = samplesUntilNextPluck(frames - done);
+    if (n < 1) n = 1;
+    for (int i = 0; i < n; ++i) {
+      gSampleCounter++;
+      mixVoicesFrame(left[done + i], right[done + i], gSymp.bridge[done + i]);
+    }
+    done += n;
+  }
 
-  // 3) Tone shaping
-  gToneState.lpTone += kLpToneAlpha * (out - gToneState.lpTone);
-  float presence = out - gToneState.lpTone;
-  float shaped   = (1.0f - kPresenceMix) * out + kPresenceMix * presence;
+  sympProcess(frames);                 // 琴桥 → 共鸣弦（下一块读出）
+  masterBusNormalize(left, right, frames, countSoundingVoices());
+  addChokeNoise(left, right, frames);
+  applyBody(left, right, frames);
+  // 效果器：送出本块干声，加回效果核处理好的湿声（晚 1~2 块）
+  if (frames == kBlockFrames) {
+    fxSend(left, right, gSampleCounter);
+    fxMixReturn(left, right, gSampleCounter);
+  }
+  // 总增益 = 音色增益（set gain）* 主音量（0~1），平滑 + 限幅
+  masterBusProcess(left, right, frames, gTone->outputGain * gMasterVolume);
+  // 音频 looper：录最终输出，回放叠在上面
+  audioLoopProcess(left, right, frames);
+}
+
+// 浮点 L / R → 16-bit 立体声帧，一个 32-bit 字一帧（低半字 = L，先发）
+void packI2sFrames(const float *left, const float *right, uint32_t *frames, int count) {
+  for (int i = 0; i < count; ++i) {
+    int16_t l = (int16_t)(left[i]  * 32760.0f);
+    int16_t r = (int16_t)(right[i] * 32760.0f);
+    frames[i] = (uint32_t)(uint16_t)l | ((uint32_t)(uint16_t)r << 16);
+  }
+}
+
+// 每块更新一次 CPU 占用；超预算时减少同时发声的弦
+void updateRenderBudget(uint32_t cycles) {
+  float budgetCycles = (float)ESP.getCpuFreqMHz() * 1e6f
+                       * (float)kBlockFrames / (float)gRate.sampleRate;
+  float load = (float)cycles / budgetCycles;
+
+  gRenderStats.blocks++;
+  gRenderStats.lastCycles = cycles;
+  gRenderStats.loadAvg   += 0.05f * (load - gRenderStats.loadAvg);
+  if (load > gRenderStats.loadPeak) gRenderStats.loadPeak = load;
+  if (load > 1.0f) gRenderStats.overruns++;
+
+  if (load > kBudgetLoadHigh) {
+    gRenderStats.calmBlocks = 0;
+    if (gRenderStats.voiceBudget > kMinVoiceBudget) {
+      gRenderStats.voiceBudget--;
+    }
+    while (countActiveVoices() > gRenderStats.voiceBudget) {
+      if (stealOldestVoice(-1) < 0) break;
+    }
+  } else if (load < kBudgetLoadLow) {
+    if (++gRenderStats.calmBlocks >= kBudgetRecoverBlocks &&
+        gRenderStats.voiceBudget < kNumStrings) {
+      gRenderStats.voiceBudget++;
+      gRenderStats.calmBlocks = 0;
+    }
+  }
+}
+
+// ---- 供 engine_bench.cpp 测整条渲染链 ----
+int engineSampleRate() {
+  return gRate.sampleRate;
+}
+
+bool engineSetSampleRate(int rate) {
+  return setSampleRate(rate, false);
+}
+
+// 测试用扫弦：和 scheduleStrum 一样排 pluck，但不进 looper、不打 trace
+// （bench / soak 一跑几千次，不能录进用户的 loop，也不能把 trace 环冲掉）
+void engineStrumNow(int chordIndex, int velocity) {
+  if (chordIndex < 0 || chordIndex >= NUM_CHORDS) return;
+  float vNorm = strumVelocityNorm(velocity);
+  queueStrum(STRUM_DOWN, chordIndex, vNorm, gSampleCounter,
+             (uint32_t)(strumInterDelayMs(vNorm) * gRate.samplesPerMs));
+}
 
-  gToneState.lpBody += kBodyAlpha * (shaped - gToneState.lpBody);
-  shaped = (1.0f - kBodyMix) * shaped + kBodyMix * gToneState.lpBody;
+void engineRenderBlock(float *left, float *right, int frames) {
+  renderBlock(left, right, frames);
+}
 
-  // 4) 总增益 = 固定音色增益 * 主音量（0~1）
-  shaped *= (kOutputGain * gMasterVolume);
+// 渲染链的状态回到刚开机：噪声源按 seed 重新开始，滤波 / 共鸣 / 总线 / 琴箱 / 效果器清空
+void engineResetState(uint32_t seed) {
+  stopAllVoices();
+  noiseSeed(gNoise, seed);
+  resetToneState();
+  sympReset();
+  masterBusReset();
+  for (int i = 0; i < kNumStrings; ++i) {
+    voiceModReset(gVoiceMod[i], gRate.modToneAlpha, gRate.modGainAlpha);
+  }
+  gBody.overBlocks = 0;
+  if (gBody.active == BODY_CONV) bodyConvReset();
+  fxReconfigure(gRate.sampleRate);
+}
 
-  if (shaped > 1.0f)  shaped = 1.0f;
-  if (shaped < -1.0f) shaped = -1.0f;
+void engineHoldLoopers(bool hold) {
+  looperHold(hold, gSampleCounter);
+  audioLoopHold(hold);
+}
 
-  return shaped;
+void engineStopAll() {
+  stopAllVoices();
 }
 
-float renderSample() {
-  handleScheduledPlucks();
-  gSampleCounter++;
-  return mixAndShapeOutput();
+int engineResonatingVoices() {
+  return countActiveVoices() - countSoundingVoices();
+}
+
+// ---- 供 engine_soak.cpp 随机演奏 / 查状态 ----
+int engineNumChords() {
+  return NUM_CHORDS;
+}
+
+void engineChoke() {
+  chokeNow();
+}
+
+void enginePalmMute() {
+  palmMuteAt(gSampleCounter);
+}
+
+float engineSetVolume(float volume) {
+  float old     = gMasterVolume;
+  gMasterVolume = constrain(volume, 0.0f, 1.0f);
+  return old;
+}
+
+int engineActiveVoices() {
+  return countActiveVoices();
+}
+
+void engineScanState(EngineStateScan &scan) {
+  scan.nonFinite = 0;
+  scan.denormal  = 0;
+#if GUITAR_VOICE_BACKEND != GUITAR_VOICE_WAVETABLE
+  for (int i = 0; i < kNumStrings; ++i) {
+    const GuitarKSVoice &v = gStrings[i];
+    if (!v.active) continue;
+    for (int k = 0; k < v.length; ++k) {
+      soakClassify(v.buffer[k], scan);
+    }
+    if constexpr (GuitarKSVoice::has<KSBrightness>) {
+      soakClassify(v.brightLp, scan);
+    }
+    if constexpr (GuitarKSVoice::has<KSFractionalTuning>) {
+      soakClassify(v.fracState, scan);
+    }
+  }
+#endif
+  for (int c = 0; c < 2; ++c) {
+    soakClassify(gToneState[c].lpTone, scan);
+    soakClassify(gToneState[c].lpBody, scan);
+  }
 }
 
 void setup() {
-  Serial.begin(115200);
+  Serial.begin(kSerialBaud);
+  traceBegin();
   Serial1.begin(19200, SERIAL_8N1, 11, 10); // RX=11, TX=10（按你实际连线）
 
   delay(1000);
-  randomSeed((uint32_t)millis());
+  noiseSeed(gNoise, gNoiseSeed);   // 固定种子：每次开机渲染一样
 
   for (int i = 0; i < kNumStrings; ++i) {
     gStrings[i].active = false;
@@ -664,21 +1757,41 @@ void setup() {
   for (int i = 0; i < kMaxScheduledPlucks; ++i) {
     gPlucks[i].active = false;
   }
-  gToneState.lpTone = 0.0f;
-  gToneState.lpBody = 0.0f;
+  resetToneState();
+  sympReset();
   gSampleCounter    = 0;
+  gRate             = computeRateParams(kSampleRate);
+  paramsBegin(gRate.sampleRate);    // NVS 里存过的音色参数（没有就用默认值）
+  masterBusReset();
+  initPanGains();
+  for (int i = 0; i < kNumStrings; ++i) {
+    voiceModReset(gVoiceMod[i], gRate.modToneAlpha, gRate.modGainAlpha);
+  }
+  songLibBegin(chordIndexByName);   // 先用内置歌，文件里的歌后台预取
+  seqSetRate(gRate.sampleRate);
+  looperSetRate(gRate.sampleRate);
+  audioLoopBegin();                 // PSRAM 缓冲；没有 PSRAM 就关掉
+  audioLoopSetRate(gRate.sampleRate);
   autoKeyReset();
   gChoke.active     = false;
   gMasterVolume     = 1.0f;   // 默认 100%
 
   setInputMode(INPUT_MODE_ATMEGA);  // 默认用 ATmega
+  setBodyMode(BODY_CONV);           // 有 IR 就用卷积琴箱
+  fxBegin(gRate.sampleRate);        // 效果器任务跑在 core 0
+
+#if GUITAR_VOICE_BACKEND == GUITAR_VOICE_WAVETABLE
+  if (!wavetableBegin()) {
+    Serial.println("Wavetable backend selected but no data: strings will be silent.");
+  }
+#endif
 
   i2s_data_bit_width_t bps  = I2S_DATA_BIT_WIDTH_16BIT;
   i2s_mode_t           mode = I2S_MODE_STD;
   i2s_slot_mode_t      slot = I2S_SLOT_MODE_STEREO;
 
   i2s.setPins(I2S_BCLK, I2S_LRC, I2S_DIN);
-  if (!i2s.begin(mode, kSampleRate, bps, slot)) {
+  if (!i2s.begin(mode, gRate.sampleRate, bps, slot)) {
     Serial.println("Failed to initialize I2S!");
     while (1) { delay(1000); }
   }
@@ -687,12 +1800,30 @@ void setup() {
   Serial.println("Commands:");
   Serial.println("  mode serial  - Serial debug input");
   Serial.println("  mode atmega  - Use ATmega UART chord input");
+  Serial.println("  mode midi    - USB serial MIDI (F0 7D 7F F7 returns)");
   Serial.println("  d 0 100      - normal DOWN C");
   Serial.println("  u 12 90      - normal UP Am");
   Serial.println("  m            - choke: smack + stop all strings");
+  Serial.println("  palm         - palm mute (like PALM_MUTE gesture)");
+  Serial.println("  pedal on     - sustain pedal on/off");
+  Serial.println("  swell 300    - volume swell on new notes (ms, 0 = off)");
+  Serial.println("  seed 1234    - reseed noise generator (reproducible renders)");
+  Serial.println("  get          - tone / feel params (set gain 3 / save to NVS / preset warm)");
   Serial.println("  u ak 127     - AutoKey UP");
   Serial.println("  d ak 90      - AutoKey DOWN");
+  Serial.println("  song 2       - select AutoKey song (song list / song)");
+  Serial.println("  pattern folk - AutoKey pattern (off / run / stop / list)");
+  Serial.println("  tempo 100    - pattern tempo (bpm)");
+  Serial.println("  loop tap     - event looper (play / stop / clear)");
+  Serial.println("  aloop tap    - audio looper, ADPCM in PSRAM (play / stop / clear / level)");
+  Serial.println("  tap on 4     - stream output PCM for tools/pcm_tap_to_wav.py (tap off)");
   Serial.println("  vol 80       - set master volume to 80%");
+  Serial.println("  rate 44100   - output sample rate (16000/22050/44100/48000)");
+  Serial.println("  stats        - render load / overruns");
+  Serial.println("  body tone    - body: conv (IR) / tone (filters)");
+  Serial.println("  fx off       - effects chain (chorus + reverb) on/off");
+  Serial.println("  bench        - run benchmarks (audio pauses)");
+  Serial.println("  soak 30      - 30 min simulated random playing: load / heap / NaN (audio pauses)");
 }
 
 void loop() {
@@ -701,13 +1832,15 @@ void loop() {
   if (gInputMode == INPUT_MODE_ATMEGA) {
     handleAtmegaInput();
   }
+  if (songLibPoll()) {
+    autoKeyReset();   // 点的歌加载好了：指针交换，从头播
+  }
 
-  float   s = renderSample();
-  int16_t v = (int16_t)(s * 32760.0f);
-
-  uint8_t lo = v & 0xFF;
-  uint8_t hi = (v >> 8) & 0xFF;
+  uint32_t t0 = ESP.getCycleCount();
+  renderBlock(gBlockL, gBlockR, kBlockFrames);
+  updateRenderBudget(ESP.getCycleCount() - t0);
 
-  i2s.write(lo); i2s.write(hi); // Left
-  i2s.write(lo); i2s.write(hi); // Right
+  packI2sFrames(gBlockL, gBlockR, gI2sFrames, kBlockFrames);
+  i2s.write((uint8_t *)gI2sFrames, sizeof(gI2sFrames));
+  pcmTapPush(gI2sFrames, kBlockFrames, gSampleCounter - kBlockFrames, gRate.sampleRate);
 }
@@ -57,10 +57,7 @@ bool getFromAtmega(String &chord, String &gesture, int &velocity, int &volume)
                 volume   = line.substring(sep3 + 1).toInt();
             }
 
-            // 简单 clamp 一下，避免奇怪值
-            if (velocity < 0)   velocity = 0;
-            if (velocity > 127) velocity = 127;
-
+            // 第三个字段的范围看帧类型（力度 / 歌曲号 / bpm），由 handleAtmegaInput 各自 clamp
             if (volume < 0)     volume = 0;
             if (volume > 100)   volume = 100;
 
@@ -14,7 +14,7 @@ struct StrumCommand {
 // 推荐新格式：chord|gesture|velocity|volume\n
 //   - chord   : String，比如 "C", "Am", "AUTOKEY"
 //   - gesture : String，比如 "STRUM_UP", "STRUM_DOWN", "MUTE"
-//   - velocity: 0..127
+//   - velocity: 0..127（控制帧 SONG / TEMPO 里是参数，如 bpm，不在这里 clamp）
 //   - volume  : 0..100   （主音量百分比）
 //
 // 兼容旧格式：chord|gesture|velocity\n
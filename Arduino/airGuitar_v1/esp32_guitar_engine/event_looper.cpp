@@ -0,0 +1,220 @@
+#include <Arduino.h>
+#include "event_looper.h"
+
+struct LooperStats {
+  uint32_t recorded;
+  uint32_t dropped;       // 事件满了 / 超过最长 loop
+  uint32_t played;
+  uint32_t passes;
+};
+
+static LoopEvent   gEvents[kLooperMaxEvents];
+static int         gCount     = 0;
+static int         gCursor    = 0;      // 本圈下一个要回放的事件
+static uint32_t    gLength    = 0;      // loop 长度（samples），录完第一遍才有
+static uint32_t    gLoopStart = 0;      // 本圈开头（录音时 = 开始录的时刻）
+static int         gSampleRate = kSampleRate;
+static uint32_t    gMaxLength = (uint32_t)(kLooperMaxSeconds * kSampleRate);
+static LooperState gState     = LOOPER_EMPTY;
+static LooperStats gStats;
+static bool        gHeld      = false;
+static uint32_t    gHeldAt    = 0;
+
+static const char *kStateName[] = { "empty", "recording", "playing", "overdub", "stopped" };
+
+// 结束第一遍录音：两次踩之间就是 loop 长度，从 now 开始第一圈回放
+static void finishRecording(uint32_t now) {
+  gLength = now - gLoopStart;
+  if (gLength == 0) {
+    looperClear();
+    return;
+  }
+  // 节奏型会提前一块排事件，落在 loop 之外的丢掉（它们已经现场弹了）
+  while (gCount > 0 && gEvents[gCount - 1].offset >= gLength) {
+    gCount--;
+    gStats.dropped++;
+  }
+  gLoopStart = now;
+  gCursor    = 0;
+  gState     = LOOPER_PLAYING;
+}
+
+void looperSetRate(int sampleRate) {
+  gSampleRate = sampleRate;
+  gMaxLength = (uint32_t)(kLooperMaxSeconds * sampleRate);
+  looperClear();
+}
+
+void looperHold(bool hold, uint32_t now) {
+  if (hold == gHeld) return;
+  gHeld = hold;
+  if (hold) {
+    gHeldAt = now;
+  } else {
+    gLoopStart += now - gHeldAt;
+  }
+}
+
+void looperTap(uint32_t now) {
+  switch (gState) {
+    case LOOPER_EMPTY:
+      gCount     = 0;
+      gCursor    = 0;
+      gLoopStart = now;
+      gState     = LOOPER_RECORDING;
+      break;
+    case LOOPER_RECORDING:
+      finishRecording(now);
+      break;
+    case LOOPER_PLAYING:
+      gState = LOOPER_OVERDUB;
+      break;
+    case LOOPER_OVERDUB:
+      gState = LOOPER_PLAYING;
+      break;
+    case LOOPER_STOPPED:
+      looperPlay(now);
+      break;
+  }
+}
+
+void looperPlay(uint32_t now) {
+  if (gState == LOOPER_RECORDING) {
+    finishRecording(now);
+    return;
+  }
+  if (gLength == 0) return;
+  gLoopStart = now;
+  gCursor    = 0;
+  gState     = LOOPER_PLAYING;
+}
+
+void looperStop(uint32_t now) {
+  if (gState == LOOPER_RECORDING) finishRecording(now);
+  if (gLength > 0) gState = LOOPER_STOPPED;
+}
+
+void looperClear() {
+  gCount  = 0;
+  gCursor = 0;
+  gLength = 0;
+  gState  = LOOPER_EMPTY;
+  memset(&gStats, 0, sizeof(gStats));
+}
+
+LooperState looperState() {
+  return gState;
+}
+
+const char *looperStateName(LooperState state) {
+  return kStateName[state];
+}
+
+void looperRecord(uint8_t kind, int chordIndex, uint8_t arg, uint8_t note,
+                  float velocityNorm, uint32_t spreadSamples, uint32_t atSample) {
+  if (gHeld) return;
+  if (gState != LOOPER_RECORDING && gState != LOOPER_OVERDUB) return;
+
+  // 偏移 + 这个事件要跳过几圈回放（现场已经弹过的那一次不能再放）
+  int32_t  d    = (int32_t)(atSample - gLoopStart);
+  uint32_t off;
+  uint8_t  skip = 0;
+  if (gState == LOOPER_RECORDING) {
+    if (d < 0 || (uint32_t)d >= gMaxLength) {
+      gStats.dropped++;
+      return;
+    }
+    off = (uint32_t)d;
+  } else if (d < 0) {
+    off = (uint32_t)(d + (int32_t)gLength);          // 上一圈的尾巴：下次在本圈放
+  } else if ((uint32_t)d < gLength) {
+    off  = (uint32_t)d;
+    skip = 1;                                       // 本圈现场已经弹了
+  } else {
+    off  = (uint32_t)d - gLength;                   // 落在下一圈：下一圈现场会弹
+    skip = 2;
+  }
+
+  if (gCount >= kLooperMaxEvents) {
+    gStats.dropped++;
+    return;
+  }
+
+  // 按偏移插入（同偏移排在后面），保持有序
+  int i = gCount;
+  while (i > 0 && gEvents[i - 1].offset > off) {
+    gEvents[i] = gEvents[i - 1];
+    --i;
+  }
+  if (i < gCursor) {
+    gCursor++;                                      // 本圈已经过了这个位置
+    if (skip > 0) skip--;
+  }
+
+  LoopEvent &e = gEvents[i];
+  e.offset     = off;
+  e.kind       = kind;
+  e.chordIndex = (uint8_t)chordIndex;
+  e.arg        = arg;
+  e.note       = note;
+  e.spread     = (uint16_t)(spreadSamples > 0xFFFF ? 0xFFFF : spreadSamples);
+  e.velocity   = (uint8_t)(constrain(velocityNorm, 0.0f, 1.0f) * 255.0f + 0.5f);
+  e.skipPasses = skip;
+  gCount++;
+  gStats.recorded++;
+}
+
+void looperUpdate(uint32_t now, int frames) {
+  if (gHeld) return;
+  uint32_t end = now + (uint32_t)frames;
+
+  if (gState == LOOPER_RECORDING) {
+    if (end - gLoopStart >= gMaxLength) finishRecording(end);
+    return;
+  }
+  if (gState != LOOPER_PLAYING && gState != LOOPER_OVERDUB) return;
+
+  for (;;) {
+    if (gCursor >= gCount) {
+      uint32_t nextPass = gLoopStart + gLength;
+      if ((int32_t)(nextPass - end) >= 0) return;
+      gLoopStart = nextPass;
+      gCursor    = 0;
+      gStats.passes++;
+      if (gCount == 0) return;
+      continue;
+    }
+
+    LoopEvent &e = gEvents[gCursor];
+    uint32_t t = gLoopStart + e.offset;
+    if ((int32_t)(t - end) >= 0) return;
+
+    if (e.skipPasses > 0) {
+      e.skipPasses--;
+    } else {
+      looperPlayEvent(e, t);
+      gStats.played++;
+    }
+    gCursor++;
+  }
+}
+
+size_t looperMemoryBytes() {
+  return sizeof(gEvents);
+}
+
+void looperPrintStatus() {
+  Serial.print("Looper: ");     Serial.print(kStateName[gState]);
+  Serial.print(", ");           Serial.print(gCount);
+  Serial.print("/");            Serial.print(kLooperMaxEvents);
+  Serial.print(" events, loop ");
+  Serial.print((float)gLength / (float)gSampleRate, 2);
+  Serial.println(" s");
+  Serial.print("  recorded ");  Serial.print(gStats.recorded);
+  Serial.print(", dropped ");   Serial.print(gStats.dropped);
+  Serial.print(", played ");    Serial.print(gStats.played);
+  Serial.print(", passes ");    Serial.println(gStats.passes);
+  Serial.print("  memory ");    Serial.print((int)looperMemoryBytes());
+  Serial.print(" B (");         Serial.print((int)sizeof(LoopEvent));
+  Serial.println(" B/event, fixed)");
+}
@@ -0,0 +1,73 @@
+#pragma once
+//
+// event_looper.h
+// ==============================
+// 事件循环录音：录下扫弦 / 拨弦 / 切音事件和它们在 loop 里的 sample 偏移，
+// 回放时在 loop 边界对齐，按原偏移重新排进 pluck 队列（精确到 sample）。
+//
+//  - 一个事件 12 B，整条 loop 最多 kLooperMaxEvents 个，内存固定（looperMemoryBytes）
+//  - 事件按偏移排好序，回放只看游标处的下一个，每块几次整数比较
+//  - 叠录（overdub）：边放边录，新事件按偏移插进去，下一圈开始回放
+//  - 回放出来的事件不会再被录一遍（回放走 looperPlayEvent，不经过 looperRecord）
+//
+// 踩一下（looperTap）：空 → 录音 → 播放 → 叠录 → 播放 → 叠录 ……
+// 第一次录音时两次踩之间的长度就是 loop 长度。
+//
+
+#include <stdint.h>
+#include "guitar_params.h"
+
+enum LoopEventKind : uint8_t {
+  LOOP_EV_STRUM_DOWN = 0,
+  LOOP_EV_STRUM_UP   = 1,
+  LOOP_EV_PICK       = 2,   // 和弦里的一根弦（节奏型单拨）
+  LOOP_EV_NOTE       = 3,   // 单音（MIDI）
+  LOOP_EV_CHOKE      = 4,
+  LOOP_EV_PALM       = 5
+};
+
+struct LoopEvent {
+  uint32_t offset;        // 相对 loop 开头（samples）
+  uint8_t  kind;
+  uint8_t  chordIndex;
+  uint8_t  arg;           // PICK / NOTE：弦号；NOTE 的音高放在 note
+  uint8_t  note;
+  uint16_t spread;        // 扫弦的弦间隔（samples）
+  uint8_t  velocity;      // velocityNorm * 255
+  uint8_t  skipPasses;    // 叠录时现场已经弹过：回放跳过这么多圈
+};
+
+enum LooperState : uint8_t {
+  LOOPER_EMPTY     = 0,
+  LOOPER_RECORDING = 1,
+  LOOPER_PLAYING   = 2,
+  LOOPER_OVERDUB   = 3,
+  LOOPER_STOPPED   = 4    // 有内容但不放
+};
+
+// 采样率变了：偏移和弦间隔都按 sample 存的，清空
+void looperSetRate(int sampleRate);
+
+// bench / soak 期间暂停：不录、不放；放开时 loop 开头顺延过去的 sample 数，
+// 回来还在原来的相位上（loop 内容不动）
+void looperHold(bool hold, uint32_t now);
+
+void looperTap(uint32_t now);
+void looperPlay(uint32_t now);
+void looperStop(uint32_t now);   // 录音中停：先按 now 定下长度
+void looperClear();
+LooperState looperState();
+const char *looperStateName(LooperState state);
+
+// 现场演奏时调用：录音 / 叠录状态下记下来
+void looperRecord(uint8_t kind, int chordIndex, uint8_t arg, uint8_t note,
+                  float velocityNorm, uint32_t spreadSamples, uint32_t atSample);
+
+// 每块一次：[now, now + frames) 内到期的事件交给 looperPlayEvent
+void looperUpdate(uint32_t now, int frames);
+
+void   looperPrintStatus();
+size_t looperMemoryBytes();
+
+// ---- 由 esp32_guitar_engine.ino 提供：把事件排进调度器 ----
+void looperPlayEvent(const LoopEvent &e, uint32_t atSample);
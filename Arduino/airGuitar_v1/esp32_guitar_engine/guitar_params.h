@@ -10,22 +10,55 @@
 //  - 频响 / 箱体音色
 //  - 总体输出音量
 //  - 每根弦的 detune
-//  - AutoKey（海阔天空版）顺序
+//  - AutoKey（晴天）歌曲编码（song_code.h）
 //  - Choke（切音）的啪声参数
+//  - 音色后端（实时 KS / flash wavetable）
 //
+// 扫弦手感 / KS 衰减 / 力度映射 / detune / 音色 / 总增益 / 切音 这几组只是开机默认值：
+// 运行中用串口 set / save / preset 改，存在 NVS 里（param_store.h，见第 15 节）。
+//
+
+#include <stdint.h>
+#include "song_code.h"
 
 // -----------------------------------------------------------------------------
 // 0. 基本引擎维度
 // -----------------------------------------------------------------------------
 
 // 音频采样率（Hz）
-constexpr int kSampleRate = 16000;
+//
+// 支持 16000 / 22050 / 44100 / 48000，这里是开机默认值
+// （也可以 -DGUITAR_SAMPLE_RATE=44100），运行中用串口命令 rate 切换。
+// 所有和采样率有关的量（延迟线长度、滤波系数、切音长度、扫弦偏移）
+// 都在 rate_params.h 里由当前采样率推出来，不要再按 16k 手调。
+//
+#ifndef GUITAR_SAMPLE_RATE
+#define GUITAR_SAMPLE_RATE 16000
+#endif
+constexpr int kSampleRate    = GUITAR_SAMPLE_RATE;
+constexpr int kMaxSampleRate = 48000;
 
 // 虚拟弦数量（模拟吉他 6 根弦）
 constexpr int kNumStrings = 6;
 
-// Karplus–Strong 延迟线最大长度
-constexpr int kMaxKsDelay = 512;
+// 标准调弦 E A D G B E（0 = 最低音弦），和弦指法（chord_voicings.h）和 MIDI 单音分弦都用它
+constexpr uint8_t kStringOpenNotes[kNumStrings] = { 40, 45, 50, 55, 59, 64 };
+
+// 最低音：MIDI 单音留到 C2；和弦指法最低是 6 弦空弦 E2（chord_voicings.h 里 static_assert）
+constexpr float kLowestNoteHz = 65.41f;
+
+// Karplus–Strong 延迟线最大长度：按最高采样率 + 最低音 + detune 余量算
+constexpr int kMaxKsDelay = (int)(kMaxSampleRate / (kLowestNoteHz * 0.99f)) + 2;
+
+// 每次渲染的块长度（frames）。loop() 每块测一次 CPU 占用（见 rate_params.h）
+constexpr int kBlockFrames = 64;
+
+// 渲染预算：块渲染时间占块时长的比例超过 High 就减少同时发声的弦，
+// 连续 kBudgetRecoverBlocks 块低于 Low 再加回来
+constexpr float kBudgetLoadHigh       = 0.85f;
+constexpr float kBudgetLoadLow        = 0.60f;
+constexpr int   kBudgetRecoverBlocks  = 256;
+constexpr int   kMinVoiceBudget       = 2;
 
 // 同时允许排队的最大 pluck 数
 constexpr int kMaxScheduledPlucks = kNumStrings * 4;
@@ -54,11 +87,40 @@ constexpr float kKsDecayMin = 0.992f;    // 力度小的衰减
 constexpr float kKsDecayMax = 0.9985f;   // 力度大的衰减
 
 
+// -----------------------------------------------------------------------------
+// 2.5 KS 扩展特性（ks_voice.h 里 GuitarKSVoice 启用了的才生效）
+// -----------------------------------------------------------------------------
+
+// 拨弦位置（占弦长比例）：0.5 = 弦中间（空心、没二次泛音），越小越靠琴桥越亮
+constexpr float kPickPosition = 0.13f;
+
+// 环路亮度（一阶低通系数，1 = 不额外滤）：力度小 → Min，力度大 → Max
+constexpr float kLoopBrightnessMin = 0.55f;
+constexpr float kLoopBrightnessMax = 0.95f;
+
+// 刚度全通系数（-1~0，越负高次泛音越偏高）
+constexpr float kStiffnessCoef = -0.15f;
+
+
+// -----------------------------------------------------------------------------
+// 2.6 尾音收尾 & 非正规数保护
+// -----------------------------------------------------------------------------
+//
+// KS 环路每圈乘 decay，不停的话尾音会一直衰减到 1e-38 以下的非正规数
+// （x86 主机上每次运算慢几十倍，别的 FPU 也不保证快）。
+//  - 一根弦整条延迟线绕一圈的峰值低于 kKsSilenceFloor（约 -100 dBFS，
+//    乘完总增益也低于 16-bit 的 1 LSB）就停掉，延迟线不再参与运算
+//  - 一阶低通一类的递归状态（音色滤波、混响阻尼）低于 kStateFlushFloor 置零
+//
+constexpr float kKsSilenceFloor  = 1e-5f;
+constexpr float kStateFlushFloor = 1e-15f;
+
+
 // -----------------------------------------------------------------------------
 // 3. 拨弦噪声 RMS & 力度映射（响度/动态）
 // -----------------------------------------------------------------------------
 //
-// initKSString() 会生成一段噪声，并归一化到 targetRms：
+// KSVoice::pluck() 会生成一段噪声，并归一化到 targetRms：
 //   targetRms = kBaseNoiseTargetRms * velScale;
 //   velScale  = kVelRmsScaleMin + (kVelRmsScaleMax - kVelRmsScaleMin)*v;
 //
@@ -66,6 +128,10 @@ constexpr float kBaseNoiseTargetRms = 0.20f;  // 中等力度时基础 RMS
 constexpr float kVelRmsScaleMin     = 0.5f;   // velocity ≈ 0
 constexpr float kVelRmsScaleMax     = 1.4f;   // velocity ≈ 127
 
+// 弦还在响时再拨：KSVoice::repluck() 把原来的延迟线乘这个系数，再叠加新的噪声激励
+// （不清空、不重新起头，快速扫弦时尾音接得上）。0 = 和没在响一样整条重填（旧行为）
+constexpr float kRepluckKeep        = 0.5f;
+
 
 // -----------------------------------------------------------------------------
 // 4. 六根弦 detune 配置（单位：cent）
@@ -83,20 +149,65 @@ constexpr float kDetuneCents[kNumStrings] = {
     4.0f    // 高音略高
 };
 
+// 每根弦的声像（-1 = 最左，0 = 中间，+1 = 最右），等功率 pan。
+// 像站在吉他手对面听：低音弦偏左，高音弦偏右
+constexpr float kStringPan[kNumStrings] = {
+    -0.6f,
+    -0.35f,
+    -0.1f,
+    0.1f,
+    0.35f,
+    0.6f
+};
+
 
 // -----------------------------------------------------------------------------
 // 5. Tone Shaping：亮度、attack、箱体
 // -----------------------------------------------------------------------------
 
-// 高频低通响应速度（越大越“亮”）
-constexpr float kLpToneAlpha = 0.24f;
+// 高频低通截止频率（越高越“亮”）
+// 系数 alpha = 1 - exp(-2π·fc/fs)，16k 下 699 Hz ≈ 原来的 0.24
+constexpr float kLpToneCutoffHz = 699.0f;
 
 // presence 占比（out 与低通差值的混合）
 constexpr float kPresenceMix = 0.25f;
 
-// 箱体低频滤波速度 & 占比
-constexpr float kBodyAlpha   = 0.02f;
-constexpr float kBodyMix     = 0.25f;
+// 箱体低频滤波截止频率 & 占比（16k 下 51.5 Hz ≈ 原来的 alpha 0.02）
+constexpr float kBodyCutoffHz = 51.5f;
+constexpr float kBodyMix      = 0.25f;
+
+// 琴箱卷积（body_convolver.h）：IR 截到多长，以及卷积占块时长的上限。
+// 连续 kBodyConvOverBlocks 块超过上限就退回上面的 ToneState 滤波
+constexpr float kBodyIrMs           = 30.0f;
+constexpr float kBodyConvMaxLoad    = 0.35f;
+constexpr int   kBodyConvOverBlocks = 32;
+
+
+// -----------------------------------------------------------------------------
+// 5.5 共鸣：琴桥耦合（没弹的弦跟着响）
+// -----------------------------------------------------------------------------
+//
+// 弹响的弦输出相加 → 一个共用的琴桥带通（每块算一次）→ 乘 kSympGain
+// 加进“共鸣弦”的延迟线：指法里不弹的弦、已经停了的弦，按它们现在按着的音
+// （不弹的弦 = 空弦）调好音，只在琴桥送进来的能量落在自己泛音上时响起来。
+//
+//  - 只从弹响的弦流向共鸣弦，共鸣弦不回送琴桥：没有回路，增益怎么调都稳定
+//  - 开销：大头是共鸣弦本身，每根都是一根完整的、逐 sample 渲染的 KS voice
+//    （和弹响的弦一样占 voice 预算）；琴桥求和 / 带通 / 注入只是每 sample 几次乘加。
+//    和弦数成正比，不是 N²；bench symp 和关掉时对比的主要就是多出来的这几根 voice
+//  - 指法里不弹的弦如果还在响上一个音，扫弦时先止音（第 8.5 节），停了以后按空弦共鸣
+//  - 只有 KS 后端有延迟线，wavetable 后端没有共鸣
+//  - 共鸣弦不算进多弦归一的发声弦数，电平不会因为它们起伏
+//
+// 默认值；运行中 set symp（0 = 整级关掉）
+constexpr float kSympGain = 0.004f;
+
+// 琴桥带通：低频切掉（不让直流 / 超低频进延迟线），高频收掉（琴桥导纳主要在中低频）
+constexpr float kSympBridgeLowHz  = 70.0f;
+constexpr float kSympBridgeHighHz = 1800.0f;
+
+// 一块里琴桥信号峰值 × 增益低于这个就不唤起新的共鸣弦（已经在响的照常注入）
+constexpr float kSympArmFloor = 1e-4f;
 
 
 // -----------------------------------------------------------------------------
@@ -104,17 +215,33 @@ constexpr float kBodyMix     = 0.25f;
 // -----------------------------------------------------------------------------
 constexpr float kOutputGain  = 3.5f;
 
+// 多弦混音按 1/sqrt(发声弦数) 归一（等功率），再乘 kMixHeadroom。
+// 取 1/sqrt(6)：六弦全响时和原来的 1/N 一样响，单弦时不再突然变大
+constexpr float kMixHeadroom = 0.41f;
+
+// 总增益（kOutputGain × 主音量）的平滑时间，避免 ATmega 调音量时的 zipper 噪声
+constexpr float kMasterGainSmoothMs = 15.0f;
+
+// 输出限幅：look-ahead 一块，峰值不超过阈值；释放时间常数
+constexpr float kLimiterThreshold = 0.95f;
+constexpr float kLimiterReleaseMs = 80.0f;
+
 
 // -----------------------------------------------------------------------------
 // 7. AutoKey 配置（晴天版）
 // -----------------------------------------------------------------------------
 //
-// chords[] 排列约定（在 esp32_guitar_engine.ino 中实现）：
+// 和弦索引约定（kChordShapes，在 chord_voicings.h 中实现）：
 //  0:C,  1:G,  2:D,   3:A,   4:E,   5:F,
 //  6:C7, 7:G7, 8:D7,  9:A7, 10:E7, 11:B7,
 //  12:Am,13:Em,14:Dm,15:Bm,16:F#m,17:Gm,
 //  18:Dsus4,19:Gsus4,20:Asus4,21:Esus4,22:Bdim,23:F#dim,
-//  24:Cmaj7
+//  24:Cmaj7,
+//  25:Gmaj7,26:Dmaj7,27:Fmaj7,28:Am7,29:Em7,30:Dm7,31:Bm7,
+//  32:Cadd9,33:Dsus2,34:Asus2,35:E9
+//
+// 每个和弦的六弦指法在 chord_voicings.h。24..35 是 ATmega 上 Button1 + Button2
+// 一起按（ALT 组）选的扩展和弦。
 //
 // 下面先把常用和弦的索引写成常量，方便 AutoKey 序列阅读。
 
@@ -142,11 +269,25 @@ constexpr int CH_Asus4  = 20;
 constexpr int CH_Esus4  = 21;
 constexpr int CH_Bdim   = 22;
 constexpr int CH_FsharpDim = 23;
-constexpr int CH_Cmaj7  = 24;  // 新增 Cmaj7（放在 chords[] 末尾）
+constexpr int CH_Cmaj7  = 24;  // 新增 Cmaj7
+constexpr int CH_Gmaj7  = 25;
+constexpr int CH_Dmaj7  = 26;
+constexpr int CH_Fmaj7  = 27;
+constexpr int CH_Am7    = 28;
+constexpr int CH_Em7    = 29;
+constexpr int CH_Dm7    = 30;
+constexpr int CH_Bm7    = 31;
+constexpr int CH_Cadd9  = 32;
+constexpr int CH_Dsus2  = 33;
+constexpr int CH_Asus2  = 34;
+constexpr int CH_E9     = 35;
+
+// 和弦个数（chord_voicings.h 里 static_assert 对上）
+constexpr int kNumChordIndices = CH_E9 + 1;
 
 // -------- AutoKey --------
 //
-// 换成：
+// 晴天：
 //   ① Em(3) Cmaj7(7) G(7) D(3)，整组轮 9 次
 //   ② Em(3) Cmaj7(7) Dsus4(7) D(3)，轮 1 次
 //   ③ G(10) Em(10) C(5) D(5)
@@ -154,56 +295,131 @@ constexpr int CH_Cmaj7  = 24;  // 新增 Cmaj7（放在 chords[] 末尾）
 //   ⑤ G(10) Em(10)
 //   ⑥ C(5) D(5) G(10) B7(10) Em(10) C(10) Dsus4(7) D(3) G(10)
 //
-// 由于每一段里“轮几次”已经展开为重复的索引，
-// 所以 kAutoKeyRepeatsPerChord = 1 即可。
+// 用 song_code.h 的字节编码：SONG_SECTION(轮几次) 开一段，
+// SONG_RUN(和弦, 扫几次) 是一段里的一个和弦，SONG_END 结束（之后从头循环）。
+// 以前用 REP 宏把每次扫弦展开成一个 int（370 × 4 = 1480 B），
+// 现在整首 65 B；串口 song 命令会打印这两个数。
 
-#define REP3(x)    x,x,x
-#define REP5(x)    x,x,x,x,x
-#define REP7(x)    x,x,x,x,x,x,x
-#define REP10(x)   x,x,x,x,x,x,x,x,x,x
-
-constexpr int kAutoKeySeq[] = {
+constexpr uint8_t kAutoKeySong[] = {
   // ---- Section 1：Em(3) Cmaj7(7) G(7) D(3)，整组循环 9 次 ----
-  REP3(CH_Em),    REP7(CH_Cmaj7),  REP7(CH_G),  REP3(CH_D),
-  REP3(CH_Em),    REP7(CH_Cmaj7),  REP7(CH_G),  REP3(CH_D),
-  REP3(CH_Em),    REP7(CH_Cmaj7),  REP7(CH_G),  REP3(CH_D),
-  REP3(CH_Em),    REP7(CH_Cmaj7),  REP7(CH_G),  REP3(CH_D),
-  REP3(CH_Em),    REP7(CH_Cmaj7),  REP7(CH_G),  REP3(CH_D),
-  REP3(CH_Em),    REP7(CH_Cmaj7),  REP7(CH_G),  REP3(CH_D),
-  REP3(CH_Em),    REP7(CH_Cmaj7),  REP7(CH_G),  REP3(CH_D),
-  REP3(CH_Em),    REP7(CH_Cmaj7),  REP7(CH_G),  REP3(CH_D),
-  REP3(CH_Em),    REP7(CH_Cmaj7),  REP7(CH_G),  REP3(CH_D),
+  SONG_SECTION(9),
+  SONG_RUN(CH_Em, 3),    SONG_RUN(CH_Cmaj7, 7), SONG_RUN(CH_G, 7),   SONG_RUN(CH_D, 3),
 
   // ---- Section 2：Em(3) Cmaj7(7) Dsus4(7) D(3) ----
-  REP3(CH_Em),    REP7(CH_Cmaj7),  REP7(CH_Dsus4),  REP3(CH_D),
+  SONG_SECTION(1),
+  SONG_RUN(CH_Em, 3),    SONG_RUN(CH_Cmaj7, 7), SONG_RUN(CH_Dsus4, 7), SONG_RUN(CH_D, 3),
 
   // ---- Section 3：G(10) Em(10) C(5) D(5) ----
-  REP10(CH_G),    REP10(CH_Em),   REP5(CH_C),   REP5(CH_D),
+  SONG_SECTION(1),
+  SONG_RUN(CH_G, 10),    SONG_RUN(CH_Em, 10),   SONG_RUN(CH_C, 5),   SONG_RUN(CH_D, 5),
 
   // ---- Section 4：G(10) B7(10) Em(10) C(10) Dsus4(7) D(3) ----
-  REP10(CH_G),    REP10(CH_B7),   REP10(CH_Em), REP10(CH_C),
-  REP7(CH_Dsus4), REP3(CH_D),
+  SONG_SECTION(1),
+  SONG_RUN(CH_G, 10),    SONG_RUN(CH_B7, 10),   SONG_RUN(CH_Em, 10), SONG_RUN(CH_C, 10),
+  SONG_RUN(CH_Dsus4, 7), SONG_RUN(CH_D, 3),
 
   // ---- Section 5：G(10) Em(10) ----
-  REP10(CH_G),    REP10(CH_Em),
+  SONG_SECTION(1),
+  SONG_RUN(CH_G, 10),    SONG_RUN(CH_Em, 10),
 
   // ---- Section 6：
   // C(5) D(5) G(10) B7(10) Em(10) C(10) Dsus4(7) D(3) G(10)
-  REP5(CH_C),     REP5(CH_D),
-  REP10(CH_G),    REP10(CH_B7),   REP10(CH_Em), REP10(CH_C),
-  REP7(CH_Dsus4), REP3(CH_D),
-  REP10(CH_G),
+  SONG_SECTION(1),
+  SONG_RUN(CH_C, 5),     SONG_RUN(CH_D, 5),
+  SONG_RUN(CH_G, 10),    SONG_RUN(CH_B7, 10),   SONG_RUN(CH_Em, 10), SONG_RUN(CH_C, 10),
+  SONG_RUN(CH_Dsus4, 7), SONG_RUN(CH_D, 3),
+  SONG_RUN(CH_G, 10),
+
+  SONG_END
 };
 
-#undef REP3
-#undef REP5
-#undef REP7
-#undef REP10
+constexpr int kAutoKeySongBytes = sizeof(kAutoKeySong);
+constexpr int kAutoKeySongStrums =
+    songStrumCount(kAutoKeySong, sizeof(kAutoKeySong));
 
-// 每个元素只用一次；重复次数已经展开在数组里了
-constexpr int kAutoKeySeqLength       =
-    sizeof(kAutoKeySeq) / sizeof(kAutoKeySeq[0]);
-constexpr int kAutoKeyRepeatsPerChord = 1;
+// 旧的展开数组：每次扫弦一个 int
+constexpr int kAutoKeyExpandedBytes = kAutoKeySongStrums * (int)sizeof(int);
+
+static_assert(songValid(kAutoKeySong, sizeof(kAutoKeySong), kNumChordIndices),
+              "kAutoKeySong: bad encoding");
+static_assert(kAutoKeySongStrums == 370,
+              "kAutoKeySong must strum exactly like the old expanded array");
+
+// -------- 歌曲库（song_library.h）--------
+//
+// LittleFS（partitions.csv 的 spiffs 分区）里 /songs/index.txt 每行一个谱子文件名，
+// 谱子是纯文本和弦谱，加载时编译成上面的字节编码。
+// 0 号歌永远是上面内置的 kAutoKeySong，文件里的歌从 1 开始编号。
+// RAM 里只有两个槽：正在播的 + 预取的下一首。
+constexpr int  kSongMaxSongs     = 16;     // 含内置歌
+constexpr int  kSongMaxBytes     = 512;    // 每首编译后的最大字节数
+constexpr int  kSongTitleLen     = 32;
+constexpr int  kSongFileNameLen  = 24;
+constexpr char kSongDir[]        = "/songs";
+
+
+// -----------------------------------------------------------------------------
+// 7.5 节奏型（pattern_seq.h）：一个 AutoKey 和弦按节奏型展开成一小节
+// -----------------------------------------------------------------------------
+//
+// 每个字符是一步（stepsPerBeat 步 = 一拍）：
+//   D / U   下扫 / 上扫（重音）      d / u   轻扫
+//   1..6    只拨一根弦（1 = 最低音弦，startPluck 的 stringIndex + 1；
+//           指法里不弹的弦换成最近的一根响弦，见 chord_voicings.h）
+//   -       空拍
+//
+struct PatternDef {
+  const char *name;
+  const char *steps;
+  int         stepsPerBeat;
+};
+
+constexpr PatternDef kPatterns[] = {
+  { "folk",   "D-DU-UDU", 2 },   // 民谣：下 下上 上下上
+  { "rock",   "D-D-DUDU", 2 },
+  { "waltz",  "D-dudu",   2 },   // 3/4
+  { "pick",   "13456543", 2 },   // 分解和弦：低音 → 高音 → 回来
+  { "travis", "15241524", 2 },   // 低音交替 + 高音
+};
+constexpr int kNumPatterns     = sizeof(kPatterns) / sizeof(kPatterns[0]);
+constexpr int kPatternMaxSteps = 16;
+
+constexpr float kPatternDefaultBpm = 90.0f;
+constexpr float kPatternMinBpm     = 40.0f;
+constexpr float kPatternMaxBpm     = 240.0f;
+
+// 节奏型里扫弦的弦间隔（比手势扫弦快，不跟力度变）
+constexpr float kPatternStrumMs = 6.0f;
+
+// 轻扫 / 单拨相对重音的力度
+constexpr float kPatternSoftVel = 0.6f;
+constexpr float kPatternPickVel = 0.8f;
+
+
+// -----------------------------------------------------------------------------
+// 7.6 事件循环录音（event_looper.h）：录的是扫弦 / 拨弦 / 切音事件，不是音频
+// -----------------------------------------------------------------------------
+
+// 一条 loop 最多多少个事件（一次扫弦 = 1 个事件），超出的丢弃并计数
+constexpr int kLooperMaxEvents = 512;
+
+// loop 最长（秒），录到这么长自动开始播放
+constexpr float kLooperMaxSeconds = 60.0f;
+
+
+// -----------------------------------------------------------------------------
+// 7.7 音频循环录音（audio_looper.h）：录总线输出，IMA-ADPCM 4-bit 存在 PSRAM
+// -----------------------------------------------------------------------------
+//
+// 一块 kBlockFrames 帧编成一个 ADPCM 块（每声道 4 B 头 + 32 B 数据），
+// 立体声 72 B / 块，是 16-bit 的 28%。48 kHz 下约 54 KB/s。
+//
+
+// 按 kMaxSampleRate 算的最长 loop（秒）；采样率低时能录更长
+constexpr float kAudioLoopMaxSeconds = 30.0f;
+
+// 回放电平（叠在现场演奏上）
+constexpr float kAudioLoopLevel = 0.8f;
 
 
 // -----------------------------------------------------------------------------
@@ -213,14 +429,277 @@ constexpr int kAutoKeyRepeatsPerChord = 1;
 // 切音时：
 //  - 立刻停止所有弦（active = false）
 //  - 开启一个极短的噪声包络，用来模拟“啪”的瞬态。
-//  - 长度 10~30ms，Env 每个 sample 乘一个系数快速衰减。
+//  - 长度 10~30ms，Env 按指数快速衰减。
 //
 
-// 噪声长度（samples）：这里设为 20ms
-constexpr int   kChokeLengthSamples = (int)(0.020f * kSampleRate);
+// 噪声长度（ms）：这里设为 20ms
+constexpr float kChokeLengthMs  = 20.0f;
 
 // 噪声基准幅度（0~1，可根据耳朵调整）
 constexpr float kChokeBaseAmp   = 0.9f;
 
-// 包络衰减系数（每个 sample 乘一次）
-constexpr float kChokeEnvDecay  = 0.90f;
+// 包络时间常数（ms）：16k 下等于原来每 sample 乘 0.90
+constexpr float kChokeEnvTauMs  = 0.593f;
+
+
+// 开机时噪声源（noise_gen.h）的种子：固定种子 → 每次开机渲染结果一样，
+// 串口 seed <n> 可以换
+constexpr uint32_t kNoiseSeed = 0x5EED2024u;
+
+
+// -----------------------------------------------------------------------------
+// 8.5 演奏调制：闷音 / 延音踏板 / 音量渐强（voice_mod.h）
+// -----------------------------------------------------------------------------
+//
+// 都是对起音时参数的乘数（1 = 不变），每块平滑一次，不逐 sample 重算。
+//
+
+// 调制平滑时间：音色类（衰减 / 亮度）和增益
+constexpr float kModToneSmoothMs = 8.0f;
+constexpr float kModGainSmoothMs = 8.0f;
+
+// 闷音（PALM_MUTE 手势 / 串口 palm）：弦继续响，但衰减更快、环路更暗。
+// 手势是一次性事件，闷音保持 kPalmMuteHoldMs；期间再扫弦会续上（连续闷音扫弦）
+constexpr float kPalmMuteDecayMul  = 0.93f;
+constexpr float kPalmMuteBrightMul = 0.35f;
+constexpr float kPalmMuteGain      = 0.85f;
+constexpr float kPalmMuteHoldMs    = 600.0f;
+
+// 止音（和弦指法里不弹的弦，上一个和弦还在响）：增益以 kStringDampMs 的时间常数滑到 0，
+// 同时衰减乘 kStringDampDecayMul，低于 kStringDampOffGain 就停掉这根弦（之后可以空弦共鸣）
+constexpr float kStringDampMs       = 15.0f;
+constexpr float kStringDampDecayMul = 0.8f;
+constexpr float kStringDampOffGain  = 1e-3f;
+
+// 延音踏板：环路衰减乘 kPedalDecayMul，但不超过 kKsDecayCeil（否则不衰减）
+constexpr float kPedalDecayMul = 1.003f;
+constexpr float kKsDecayCeil   = 0.9995f;
+
+// 音量渐强（swell）：新起音从 0 开始，kSwellMs 内升到原音量；0 = 关
+constexpr float kSwellDefaultMs = 0.0f;
+
+
+// -----------------------------------------------------------------------------
+// 9. 音色后端（Voice backend）
+// -----------------------------------------------------------------------------
+//
+// GUITAR_VOICE_KS        ：实时 Karplus–Strong（ks_voice.h）
+// GUITAR_VOICE_WAVETABLE ：播放 flash "wavetable" 数据分区里预渲染好的
+//                          分力度层音色（wavetable_voice.h）。
+//                          数据由 tools/render_wavetable.py 生成并烧录，
+//                          分区见 partitions.csv。
+//
+// 可以在这里改，也可以用编译参数 -DGUITAR_VOICE_BACKEND=1 覆盖。
+//
+#define GUITAR_VOICE_KS         0
+#define GUITAR_VOICE_WAVETABLE  1
+
+#ifndef GUITAR_VOICE_BACKEND
+#define GUITAR_VOICE_BACKEND    GUITAR_VOICE_KS
+#endif
+
+// 每个 wavetable voice 的流式缓存长度（samples，int16）。
+// 播放到缓存末尾时从 flash 分区再读一段，越大读 flash 越少、占 RAM 越多。
+constexpr int kWtCacheSamples = 256;
+
+
+// -----------------------------------------------------------------------------
+// 10. 效果器（effects_task.h：在另一个核上跑，湿声混回总线）
+// -----------------------------------------------------------------------------
+
+// 开机时是否打开效果器（串口 fx on|off 可切换）
+constexpr bool kFxEnabledDefault = true;
+
+// 核间块环形缓冲的深度（块）。湿声比干声晚 1~2 块，深度只是抗抖动
+constexpr int kFxRingBlocks = 4;
+
+// 合唱：基础延迟 / 调制深度 / LFO 频率 / 湿声增益（L、R 的 LFO 相差 90°）。
+// 实际听到的延迟还要加上核间缓冲的 1~2 块
+constexpr float kChorusDelayMs = 8.0f;
+constexpr float kChorusDepthMs = 2.5f;
+constexpr float kChorusRateHz  = 0.8f;
+constexpr float kChorusMix     = 0.30f;
+constexpr float kChorusMaxMs   = kChorusDelayMs + kChorusDepthMs + 1.0f;
+
+// 混响（4 线 FDN）：RT60、高频阻尼截止、湿声增益
+constexpr float kReverbT60Sec  = 1.6f;
+constexpr float kReverbDampHz  = 4500.0f;
+constexpr float kReverbMix     = 0.18f;
+
+// FDN 四条延迟线长度（ms，互质附近的取值，避免模态重叠）
+constexpr float kReverbLineMs[4] = { 29.7f, 37.1f, 41.1f, 43.7f };
+constexpr float kReverbMaxLineMs = 44.0f;
+
+
+// -----------------------------------------------------------------------------
+// 11. MIDI 输入（mode midi：USB 串口上直接收 MIDI 字节流，midi_input.h）
+// -----------------------------------------------------------------------------
+//
+//  Note on，通道 1 / 2：kMidiChordBaseNote + 和弦索引 → 下扫 / 上扫这个和弦
+//                      （选了节奏型时按节奏型弹一小节）
+//  Note on，其它音 / 其它通道：单根弦弹这个音高
+//  CC7 主音量，CC1 调暗环路亮度，CC64 延音踏板，CC120 静音，CC123 切音
+//  CC80 ≥ 64：looper 踩一下（录 / 播 / 叠录），CC81 ≥ 64：清空 looper
+//  Program change：0 = 关节奏型，1.. = kPatterns[p - 1]
+//  SysEx F0 7D 7F F7：退出 MIDI 模式，回到串口文本命令
+//
+constexpr int kMidiChordBaseNote = 48;   // C3
+
+// 单音落在哪根弦：开放弦音高（kStringOpenNotes）≤ 这个音的最高那根
+
+// CC1 = 127 时的环路亮度乘数（CC1 = 0 不变）
+constexpr float kMidiModBrightMin = 0.3f;
+
+// 退出 MIDI 模式的 SysEx（0x7D = 非商业 / 自用厂商 ID）
+constexpr uint8_t kMidiExitSysexId  = 0x7D;
+constexpr uint8_t kMidiExitSysexCmd = 0x7F;
+
+
+// -----------------------------------------------------------------------------
+// 12. PCM 抓取（pcm_tap.h：把送进 I2S 的 int16 原样从 USB 串口发出去）
+// -----------------------------------------------------------------------------
+
+// 抓取时串口切到这个波特率（原生 USB CDC 不看波特率，只对 USB-UART 桥有用）
+constexpr uint32_t kPcmTapBaud   = 921600;
+constexpr uint32_t kSerialBaud   = 115200;
+
+// 一帧多少个（抽取后的）立体声 sample，和环形缓冲深度（帧）
+constexpr int kPcmTapFrames     = 64;
+constexpr int kPcmTapRingFrames = 16;
+
+// 抽取倍数上限（1 = 原样；2 / 4 / 8 = 每 N 个 sample 取平均）
+constexpr int kPcmTapMaxDecim = 8;
+
+// 发送任务给串口文本输出留的 TX 空间：缓冲少于 帧长 + 这么多 就先不发，
+// loop() 里的 Serial.print 不会因为抓取把 TX 缓冲占满而阻塞
+constexpr int kPcmTapTxReserve = 256;
+
+
+// -----------------------------------------------------------------------------
+// 13. 调试输出（trace.h：渲染循环里只写二进制记录，低优先级任务再格式化打印）
+// -----------------------------------------------------------------------------
+//
+// 编译期级别：比这个级别详细的 TRACE() 整个编译掉。
+//   0 = 关   1 = 只有警告   2 = 扫弦 / 切音 / 模式切换 / ATmega 帧（默认）   3 = 更细
+// 也可以用编译参数 -DGUITAR_TRACE_LEVEL=0 覆盖。
+//
+#define TRACE_LEVEL_OFF   0
+#define TRACE_LEVEL_WARN  1
+#define TRACE_LEVEL_INFO  2
+#define TRACE_LEVEL_DEBUG 3
+
+#ifndef GUITAR_TRACE_LEVEL
+#define GUITAR_TRACE_LEVEL TRACE_LEVEL_INFO
+#endif
+
+// 记录环形缓冲深度（条，2 的幂）；满了新记录丢掉并计数
+constexpr int kTraceRingRecords = 128;
+
+// 打印任务多久醒一次（ms）：渲染核不用通知它，写记录只是几次存储
+constexpr int kTraceDrainMs = 20;
+
+
+// -----------------------------------------------------------------------------
+// 14. 长时间稳定性测试（engine_soak.h：串口命令 soak）
+// -----------------------------------------------------------------------------
+//
+// 按模拟时间随机扫弦 / 切音 / 闷音 / 改音量，偶尔长时间不弹，让尾音一直衰减到底。
+//
+
+// 每隔多少秒（模拟时间）报告一次
+constexpr int kSoakReportSec = 60;
+
+// 两个事件之间的间隔（ms，均匀随机）
+constexpr int kSoakGapMsMin = 60;
+constexpr int kSoakGapMsMax = 1500;
+
+// 各事件的概率（%），剩下的是扫弦
+constexpr int kSoakChokePct  = 6;
+constexpr int kSoakPalmPct   = 8;
+constexpr int kSoakVolumePct = 6;
+constexpr int kSoakRestPct   = 1;
+
+// 长时间不弹的时长（秒）。不停弦的话，16 kHz 下大力扫的尾音约 100 s 进非正规数
+constexpr int kSoakRestSecMin = 60;
+constexpr int kSoakRestSecMax = 150;
+
+
+// -----------------------------------------------------------------------------
+// 15. 运行时参数（param_store.h：串口 set / get / save / preset，存 NVS）
+// -----------------------------------------------------------------------------
+//
+// 上面第 1~6、8 节里的手感 / 音色参数（含 3 的再拨保留、5.5 的共鸣增益）是默认值，NVS 里存过就用存的。
+// ToneParams 的成员变了（增删 / 换顺序）就把版本号加一，旧数据会被忽略。
+//
+constexpr char     kParamsNvsNamespace[] = "guitar";
+constexpr char     kParamsNvsKey[]       = "tone";
+constexpr uint16_t kParamsNvsVersion     = 3;
+
+// 预设：只列和默认值不同的项（名字同 set 命令，index 只对 detune 有用，0 = 最低音弦）
+struct ParamOverride {
+  const char *name;
+  int         index;
+  float       value;
+};
+
+struct ParamPresetDef {
+  const char          *name;
+  const ParamOverride *overrides;
+  int                  count;
+};
+
+// 亮：低通开高、presence 多一点，箱体少一点
+constexpr ParamOverride kPresetBright[] = {
+  { "tone_hz",    0, 1100.0f },
+  { "presence",   0, 0.35f },
+  { "bright_min", 0, 0.70f },
+  { "bright_max", 0, 1.0f },
+  { "body_mix",   0, 0.15f },
+};
+
+// 暖：低通关小，环路更暗，箱体多一点
+constexpr ParamOverride kPresetWarm[] = {
+  { "tone_hz",    0, 450.0f },
+  { "presence",   0, 0.15f },
+  { "bright_min", 0, 0.40f },
+  { "bright_max", 0, 0.80f },
+  { "body_mix",   0, 0.35f },
+};
+
+// 长延音：衰减更慢
+constexpr ParamOverride kPresetSustain[] = {
+  { "decay_min", 0, 0.995f },
+  { "decay_max", 0, 0.9992f },
+};
+
+// 紧：扫得快、尾巴短，适合节奏
+constexpr ParamOverride kPresetTight[] = {
+  { "strum_slow_ms", 0, 10.0f },
+  { "strum_fast_ms", 0, 2.0f },
+  { "decay_min",     0, 0.990f },
+  { "decay_max",     0, 0.996f },
+};
+
+// 宽：detune 加大，像十二弦
+constexpr ParamOverride kPresetWide[] = {
+  { "detune", 0, -10.0f },
+  { "detune", 1, -6.0f },
+  { "detune", 2, -3.0f },
+  { "detune", 3, 3.0f },
+  { "detune", 4, 6.0f },
+  { "detune", 5, 10.0f },
+};
+
+#define PARAM_PRESET(name, arr) { name, arr, (int)(sizeof(arr) / sizeof(arr[0])) }
+
+constexpr ParamPresetDef kParamPresets[] = {
+  { "default", nullptr, 0 },
+  PARAM_PRESET("bright",  kPresetBright),
+  PARAM_PRESET("warm",    kPresetWarm),
+  PARAM_PRESET("sustain", kPresetSustain),
+  PARAM_PRESET("tight",   kPresetTight),
+  PARAM_PRESET("wide",    kPresetWide),
+};
+constexpr int kNumParamPresets = sizeof(kParamPresets) / sizeof(kParamPresets[0]);
+
+#undef PARAM_PRESET
@@ -0,0 +1,104 @@
+#pragma once
+//
+// ima_adpcm.h
+// ==============================
+// IMA-ADPCM（4 bit / sample）块编解码，音频 looper 用。
+//
+//  - 块格式：4 B 头（int16 预测值 LE、uint8 步长索引、0），后面每字节两个 sample，
+//    低 4 位在前。头里存的是编码器在本块第一个 sample 之前的状态，第一个 sample
+//    也编成 4 bit（frames 个 sample 正好 frames / 2 字节）。WAV 的 IMA-ADPCM 头里
+//    存的是第一个 sample 本身，所以这里的块不能直接当 WAV 数据用
+//  - 每块从头里的状态开始解码，块之间互不依赖：叠录时可以就地重编某一块
+//  - 只有整数加减、移位和查表；float 进出时才做一次缩放和限幅
+//
+
+#include <stdint.h>
+
+constexpr int adpcmBlockBytes(int frames) {
+  return 4 + frames / 2;
+}
+
+struct AdpcmState {
+  int32_t predictor;
+  int32_t index;
+};
+
+static const int16_t kAdpcmStepTable[89] = {
+  7, 8, 9, 10, 11, 12, 13, 14, 16, 17, 19, 21, 23, 25, 28, 31, 34, 37, 41, 45,
+  50, 55, 60, 66, 73, 80, 88, 97, 107, 118, 130, 143, 157, 173, 190, 209, 230,
+  253, 279, 307, 337, 371, 408, 449, 494, 544, 598, 658, 724, 796, 876, 963,
+  1060, 1166, 1282, 1411, 1552, 1707, 1878, 2066, 2272, 2499, 2749, 3024, 3327,
+  3660, 4026, 4428, 4871, 5358, 5894, 6484, 7132, 7845, 8630, 9493, 10442,
+  11487, 12635, 13899, 15289, 16818, 18500, 20350, 22385, 24623, 27086, 29794,
+  32767
+};
+
+static const int8_t kAdpcmIndexTable[8] = { -1, -1, -1, -1, 2, 4, 6, 8 };
+
+inline void adpcmReset(AdpcmState &st) {
+  st.predictor = 0;
+  st.index     = 0;
+}
+
+// 按 code 更新预测值和步长索引（编码端和解码端共用，两边状态一致）
+inline void adpcmStep(AdpcmState &st, uint8_t code) {
+  int32_t step  = kAdpcmStepTable[st.index];
+  int32_t delta = step >> 3;
+  if (code & 4) delta += step;
+  if (code & 2) delta += step >> 1;
+  if (code & 1) delta += step >> 2;
+  int32_t p = (code & 8) ? st.predictor - delta : st.predictor + delta;
+  st.predictor = p > 32767 ? 32767 : (p < -32768 ? -32768 : p);
+  int32_t i = st.index + kAdpcmIndexTable[code & 7];
+  st.index = i < 0 ? 0 : (i > 88 ? 88 : i);
+}
+
+inline uint8_t adpcmEncodeSample(AdpcmState &st, int32_t sample) {
+  int32_t step = kAdpcmStepTable[st.index];
+  int32_t diff = sample - st.predictor;
+  uint8_t code = 0;
+  if (diff < 0) {
+    code = 8;
+    diff = -diff;
+  }
+  if (diff >= step)        { code |= 4; diff -= step; }
+  if (diff >= (step >> 1)) { code |= 2; diff -= step >> 1; }
+  if (diff >= (step >> 2)) { code |= 1; }
+  adpcmStep(st, code);
+  return code;
+}
+
+inline int16_t floatToPcm16(float v) {
+  int32_t s = (int32_t)(v * 32767.0f);
+  return (int16_t)(s > 32767 ? 32767 : (s < -32768 ? -32768 : s));
+}
+
+// frames 个 float（[-1, 1]）→ adpcmBlockBytes(frames) 字节；st 接着上一块往下走
+inline void adpcmEncodeBlock(const float *in, int frames, AdpcmState &st, uint8_t *out) {
+  out[0] = (uint8_t)(st.predictor & 0xFF);
+  out[1] = (uint8_t)((st.predictor >> 8) & 0xFF);
+  out[2] = (uint8_t)st.index;
+  out[3] = 0;
+  uint8_t *data = out + 4;
+  for (int i = 0; i < frames; i += 2) {
+    uint8_t lo = adpcmEncodeSample(st, floatToPcm16(in[i]));
+    uint8_t hi = adpcmEncodeSample(st, floatToPcm16(in[i + 1]));
+    data[i >> 1] = (uint8_t)(lo | (hi << 4));
+  }
+}
+
+// 一块 → frames 个 float
+inline void adpcmDecodeBlock(const uint8_t *in, int frames, float *out) {
+  AdpcmState st;
+  st.predictor = (int16_t)(in[0] | (in[1] << 8));
+  st.index     = in[2] > 88 ? 88 : in[2];
+  const uint8_t *data = in + 4;
+  const float k = 1.0f / 32768.0f;
+  for (int i = 0; i < frames; i += 2) {
+    uint8_t b = data[i >> 1];
+    adpcmStep(st, b & 0x0F);
+    out[i] = (float)st.predictor * k;
+    adpcmStep(st, b >> 4);
+    out[i + 1] = (float)st.predictor * k;
+  }
+}
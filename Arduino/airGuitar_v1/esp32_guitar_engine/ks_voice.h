@@ -0,0 +1,303 @@
+#pragma once
+//
+// ks_voice.h
+// ==============================
+// Karplus–Strong 单弦（实时合成后端），模板 KSVoice<Features...>。
+//
+// 基本环路和原来一样：两点平均 + 每圈乘 decay。
+// 下面这些扩展是编译期可选的“特性”，不在模板参数里的特性
+// 不占任何状态、不产生任何指令（if constexpr + 空基类）：
+//
+//   KSPickPosition      拨弦位置梳状滤波（只在起音时对激励做一次）
+//   KSBrightness        环路一阶低通，控制尾音亮度（每 sample 1 乘 1 加）
+//   KSStiffness         环路一阶全通，模拟弦的刚度（高次泛音偏高）
+//   KSFractionalTuning  一阶全通分数延迟，修正整数延迟线的音准
+//
+// 一圈下来整条延迟线都低于 kKsSilenceFloor 时弦自己停掉（active = false），
+// 尾音不会一直衰减进非正规数。
+//
+// 带附加环路延迟的特性（亮度 / 刚度）在起音时按基频处的相位延迟
+// 扣掉整数延迟线长度，启用 KSFractionalTuning 时再把小数部分补准（tune()）。
+//
+// 共鸣（guitar_params.h 第 5.5 节）：resonate() 只调音、延迟线从静音开始，
+// inject() 每块把琴桥信号加进延迟线。
+//
+// 还在响的弦再拨（第 3 节 kRepluckKeep）：repluck() 不清延迟线，新激励叠加进去，
+// 只动新长度那么多点。延迟线只读 [0, length)，超出的部分任何时候都不用清零。
+//
+// 与 wavetable_voice.h 提供同样的“起音 / 每 sample 取值”接口，
+// 由 guitar_params.h 中的 GUITAR_VOICE_BACKEND 选择引擎实际使用哪一个。
+//
+
+#include <Arduino.h>
+#include <math.h>
+#include <type_traits>
+#include "guitar_params.h"
+#include "rate_params.h"
+#include "noise_gen.h"
+
+// ---- 特性 ----
+
+struct KSPickPosition {
+  // 无运行时状态：起音时对激励做 x[n] -= x[n - P]，P = kPickPosition * N
+};
+
+struct KSBrightness {
+  float brightLp   = 0.0f;
+  float brightCoef = 1.0f;   // 0~1，1 = 不额外衰减高频
+  float baseBright = 1.0f;   // 起音时的亮度，modulate() 在此基础上乘
+};
+
+struct KSStiffness {
+  float stiffState = 0.0f;
+};
+
+struct KSFractionalTuning {
+  float fracCoef  = 0.0f;
+  float fracState = 0.0f;
+};
+
+// 一阶全通 y = C·x + x[n-1] - C·y[n-1]（转置 DF-II，一个状态）
+inline float ksAllpass(float x, float c, float &state) {
+  float y = c * x + state;
+  state   = x - c * y;
+  return y;
+}
+
+// 一阶全通在 ω 处的相位延迟（samples）
+inline float ksAllpassDelay(float c, float w) {
+  float s = sinf(w), co = cosf(w);
+  float phase = atan2f(-s * (1.0f - c * c), 2.0f * c + (1.0f + c * c) * co);
+  return -phase / w;
+}
+
+// 一阶低通 y += g(x - y) 在 ω 处的相位延迟（samples）
+inline float ksOnePoleDelay(float g, float w) {
+  float p = 1.0f - g;
+  return atan2f(p * sinf(w), 1.0f - p * cosf(w)) / w;
+}
+
+// repluck() 生成激励用的暂存区（所有弦共用：起音都在渲染任务里，一次一根；
+// 定义在 esp32_guitar_engine.ino）
+extern float gKsExcitation[kMaxKsDelay];
+
+// ---- 单弦 ----
+
+template <typename... Features>
+struct KSVoice : Features... {
+  template <typename F>
+  static constexpr bool has = (std::is_same<F, Features>::value || ...);
+
+  float buffer[kMaxKsDelay];
+  int   length;
+  int   index;
+  float decay;
+  float baseDecay;    // 起音时的衰减，modulate() 在此基础上乘
+  float passPeak;     // 本圈（index 从 0 走到 length）输出的峰值
+  bool  active;
+
+  // 按音高定延迟线长度（扣掉特性的附加延迟、补分数延迟）和环路系数。
+  // 不动 buffer 的内容、读位置和滤波器状态
+  void tune(float freq, float brightness) {
+    float period = (float)gRate.sampleRate / freq;
+    float w      = 2.0f * (float)M_PI * freq / (float)gRate.sampleRate;
+
+    // 特性带来的额外环路延迟
+    float extra = 0.0f;
+    if constexpr (has<KSBrightness>) {
+      this->brightCoef = constrain(brightness, 0.05f, 1.0f);
+      this->baseBright = this->brightCoef;
+      extra += ksOnePoleDelay(this->brightCoef, w);
+    }
+    if constexpr (has<KSStiffness>) {
+      extra += ksAllpassDelay(kStiffnessCoef, w);
+    }
+
+    int len;
+    if constexpr (has<KSFractionalTuning>) {
+      // 读 [i, i+1] 写回 i，环路延迟 = N - 0.5（两点平均）+ d + extra，
+      // 小数部分 d 留给全通，d ∈ [0.1, 1.1)
+      float target = period + 0.5f - extra;
+      len          = (int)floorf(target - 0.1f);
+      if (len < 2) len = 2;
+      float d      = target - (float)len;
+      if (d < 0.1f) d = 0.1f;
+      this->fracCoef  = (1.0f - d) / (1.0f + d);
+    } else {
+      len = (int)(period - extra + 0.5f);
+    }
+    if (len < 2)           len = 2;
+    if (len > kMaxKsDelay) len = kMaxKsDelay;
+
+    length = len;
+  }
+
+  // 环路里各特性的滤波器状态清零（新起音 / 共鸣从静音开始）
+  void clearLoopState() {
+    if constexpr (has<KSBrightness>) {
+      this->brightLp = 0.0f;
+    }
+    if constexpr (has<KSStiffness>) {
+      this->stiffState = 0.0f;
+    }
+    if constexpr (has<KSFractionalTuning>) {
+      this->fracState = 0.0f;
+    }
+  }
+
+  // 一段激励写进 dst[0..len)：噪声 → 平滑 → 拨弦位置梳状 → RMS 归一到 targetRms
+  static void excite(float *dst, int len, float targetRms) {
+    noiseFill(gNoise, dst, len);
+
+    // 稍微做一点低通，避免太“沙”
+    float prev = 0.0f;
+    for (int i = 0; i < len; ++i) {
+      prev   = 0.4f * dst[i] + 0.6f * prev;
+      dst[i] = prev;
+    }
+
+    if constexpr (has<KSPickPosition>) {
+      // 倒序做，dst[i - p] 还是原值
+      int p = (int)(kPickPosition * (float)len + 0.5f);
+      if (p < 1) p = 1;
+      for (int i = len - 1; i >= p; --i) {
+        dst[i] -= dst[i - p];
+      }
+    }
+
+    float sumSq = 0.0f;
+    for (int i = 0; i < len; ++i) {
+      sumSq += dst[i] * dst[i];
+    }
+
+    // 归一化 RMS
+    if (sumSq > 1e-6f) {
+      float rms   = sqrtf(sumSq / (float)len);
+      float scale = targetRms / rms;
+      for (int i = 0; i < len; ++i) {
+        dst[i] *= scale;
+      }
+    }
+  }
+
+  // 起音：填噪声激励 + RMS 归一化。brightness 只在带 KSBrightness 时有意义
+  void pluck(float freq, float decayIn, float targetRms, float brightness = 1.0f) {
+    if (freq <= 0.0f) {
+      active = false;
+      return;
+    }
+
+    tune(freq, brightness);
+    clearLoopState();
+    index     = 0;
+    decay     = decayIn;
+    baseDecay = decayIn;
+    passPeak  = 0.0f;
+    active    = true;
+
+    excite(buffer, length, targetRms);
+  }
+
+  // 还在响的弦再拨：原来的内容乘 keep（拨片碰到弦先压掉一部分），再加上新的激励，
+  // 整条线不换掉，读位置和环路滤波器状态接着走，快速连扫不会“咔”。
+  // 音高变了只改长度：变长多出来的一段清零，变短的那段不再读。
+  // 开销和新长度成正比（激励 + 一次乘加），没在响就退回 pluck()
+  void repluck(float freq, float decayIn, float targetRms, float brightness, float keep) {
+    if (!active || freq <= 0.0f) {
+      pluck(freq, decayIn, targetRms, brightness);
+      return;
+    }
+
+    int oldLen = length;
+    tune(freq, brightness);
+    for (int i = oldLen; i < length; ++i) {
+      buffer[i] = 0.0f;
+    }
+    if (index >= length) index = 0;
+    decay     = decayIn;
+    baseDecay = decayIn;
+    passPeak  = 0.0f;
+
+    excite(gKsExcitation, length, targetRms);
+    for (int i = 0; i < length; ++i) {
+      buffer[i] = keep * buffer[i] + gKsExcitation[i];
+    }
+  }
+
+  // 共鸣（没弹的弦）：调好音，延迟线从静音开始，能量全靠 inject() 从琴桥送进来
+  void resonate(float freq, float decayIn, float brightness) {
+    if (freq <= 0.0f) {
+      active = false;
+      return;
+    }
+    tune(freq, brightness);
+    clearLoopState();
+    index = 0;
+    for (int i = 0; i < length; ++i) {
+      buffer[i] = 0.0f;
+    }
+    decay     = decayIn;
+    baseDecay = decayIn;
+    passPeak  = 0.0f;
+    active    = true;
+  }
+
+  // 把一块激励 x[0..frames) 按 gain 加进延迟线：从下一个要读的位置起，
+  // 下一块第 n 个 sample 读到 x[n]（延迟线比块短时绕回去叠加）
+  void inject(const float *x, int frames, float gain) {
+    int j = index;
+    for (int n = 0; n < frames; ++n) {
+      buffer[j] += gain * x[n];
+      if (++j >= length) j = 0;
+    }
+  }
+
+  // 块率调制（voice_mod.h）：在起音参数上乘系数，块内不变。
+  // 亮度变了环路相位延迟也会变，音高会有一点偏（真吉他闷音也会）
+  void modulate(float decayMul, float brightMul) {
+    decay = fminf(baseDecay * decayMul, kKsDecayCeil);
+    if constexpr (has<KSBrightness>) {
+      this->brightCoef = constrain(this->baseBright * brightMul, 0.05f, 1.0f);
+    }
+  }
+
+  float process() {
+    if (!active) return 0.0f;
+
+    int i0 = index;
+    int i1 = (index + 1);
+    if (i1 >= length) i1 = 0;
+
+    float y = 0.5f * (buffer[i0] + buffer[i1]);
+    y *= decay;
+
+    if constexpr (has<KSBrightness>) {
+      this->brightLp += this->brightCoef * (y - this->brightLp);
+      y = this->brightLp;
+    }
+    if constexpr (has<KSStiffness>) {
+      y = ksAllpass(y, kStiffnessCoef, this->stiffState);
+    }
+    if constexpr (has<KSFractionalTuning>) {
+      y = ksAllpass(y, this->fracCoef, this->fracState);
+    }
+
+    buffer[i0] = y;
+    index      = i1;
+
+    // 每绕一圈看一次：整圈都低于底噪就停掉，滤波器状态下次起音时清零
+    passPeak = fmaxf(passPeak, fabsf(y));
+    if (i1 == 0) {
+      if (passPeak < kKsSilenceFloor) active = false;
+      passPeak = 0.0f;
+    }
+
+    return y;
+  }
+};
+
+// 原始 KS（无任何扩展）
+using KSString = KSVoice<>;
+
+// 引擎实际使用的组合：加减特性只改这一行
+using GuitarKSVoice = KSVoice<KSPickPosition, KSBrightness, KSFractionalTuning>;
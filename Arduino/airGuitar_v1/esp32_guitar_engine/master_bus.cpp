@@ -0,0 +1,99 @@
+#include "master_bus.h"
+#include "rate_params.h"
+#include "param_store.h"
+
+struct MasterBusState {
+  float normGain;     // 当前归一增益
+  float outGain;      // 平滑后的总增益
+  float limGain;      // 限幅增益（≤ 1）
+  float delayL[kBlockFrames];
+  float delayR[kBlockFrames];
+};
+
+static MasterBusState gBus;
+
+// 延迟线 + 当前块拼在一起，限幅窗口 = 整段
+static float gWindowL[2 * kBlockFrames];
+static float gWindowR[2 * kBlockFrames];
+
+void masterBusReset() {
+  gBus.normGain = kMixHeadroom;
+  gBus.outGain  = gTone->outputGain;
+  gBus.limGain  = 1.0f;
+  for (int i = 0; i < kBlockFrames; ++i) {
+    gBus.delayL[i] = 0.0f;
+    gBus.delayR[i] = 0.0f;
+  }
+}
+
+void masterBusNormalize(float *__restrict left, float *__restrict right,
+                        int frames, int activeVoices) {
+  int   n      = (activeVoices > 1) ? activeVoices : 1;
+  float target = kMixHeadroom / sqrtf((float)n);
+
+  float g    = gBus.normGain;
+  float step = (target - g) / (float)frames;
+  for (int i = 0; i < frames; ++i) {
+    float gi = g + step * (float)(i + 1);
+    left[i]  *= gi;
+    right[i] *= gi;
+  }
+  gBus.normGain = target;
+}
+
+// 延迟线 + 新块 → 窗口，返回窗口峰值
+static float fillWindow(const float *__restrict delay, const float *__restrict in,
+                        float *__restrict window, int frames) {
+  float peak = 0.0f;
+  for (int i = 0; i < kBlockFrames; ++i) {
+    window[i] = delay[i];
+    peak = fmaxf(peak, fabsf(delay[i]));
+  }
+  for (int i = 0; i < frames; ++i) {
+    window[kBlockFrames + i] = in[i];
+    peak = fmaxf(peak, fabsf(in[i]));
+  }
+  return peak;
+}
+
+void masterBusProcess(float *__restrict left, float *__restrict right,
+                      int frames, float targetGain) {
+  // 1) 总增益平滑（每块一次）
+  float g0 = gBus.outGain;
+  float g1 = g0 + gRate.masterGainAlpha * (targetGain - g0);
+  gBus.outGain = g1;
+
+  // 2) 窗口 = 延迟线 + 新块，求两路峰值（输入已乘上增益前）
+  float peak = fmaxf(fillWindow(gBus.delayL, left,  gWindowL, frames),
+                     fillWindow(gBus.delayR, right, gWindowR, frames));
+
+  // 3) 限幅目标：窗口峰值 × 最大增益不超过阈值；否则按释放时间回升。
+  //    上一块的增益已经覆盖了本块要输出的 sample，两端都满足，线性过渡也满足
+  float gMax   = fmaxf(g0, g1);
+  float need   = (peak * gMax > kLimiterThreshold) ? kLimiterThreshold / (peak * gMax) : 1.0f;
+  float l0     = gBus.limGain;
+  float l1     = l0 + gRate.limiterRelease * (1.0f - l0);
+  l1           = fminf(l1, need);
+  gBus.limGain = l1;
+
+  // 4) 输出 = 窗口前 frames 个 sample × (总增益斜坡 × 限幅斜坡)
+  float dg = (g1 - g0) / (float)frames;
+  float dl = (l1 - l0) / (float)frames;
+  for (int i = 0; i < frames; ++i) {
+    float t = (float)(i + 1);
+    float g = (g0 + dg * t) * (l0 + dl * t);
+    // 保险：总增益变大的那一块可能略超阈值
+    left[i]  = fminf(fmaxf(gWindowL[i] * g, -1.0f), 1.0f);
+    right[i] = fminf(fmaxf(gWindowR[i] * g, -1.0f), 1.0f);
+  }
+
+  // 5) 延迟线 = 窗口剩下的 kBlockFrames 个 sample
+  for (int i = 0; i < kBlockFrames; ++i) {
+    gBus.delayL[i] = gWindowL[frames + i];
+    gBus.delayR[i] = gWindowR[frames + i];
+  }
+}
+
+float masterBusLimiterGain() {
+  return gBus.limGain;
+}
@@ -0,0 +1,31 @@
+#pragma once
+//
+// master_bus.h
+// ==============================
+// 块处理的总线：多弦归一 → （琴箱）→ 总增益 + look-ahead 限幅。
+//
+//  - 归一：1/sqrt(发声弦数) × kMixHeadroom，块内线性插值，
+//    起音 / 停弦不会让电平突然跳
+//  - 总增益：目标增益（param_store 的 gain）× 主音量，每块一阶平滑，块内线性插值
+//  - 限幅：输出延迟 kBlockFrames 个 sample，每块根据
+//    “待输出 + 新进来”的峰值算出增益，块内从上一块增益线性过渡，
+//    输出峰值不超过 kLimiterThreshold（不再逐 sample 分支削波）。
+//    立体声两路共用一个增益（取两路峰值），声像不会被压偏
+//
+// 循环里没有分支、没有跨 sample 依赖（除了增益的线性斜坡），
+// 编译器可以展开 / 向量化。bench master 测每块开销。
+//
+
+#include "guitar_params.h"
+
+void masterBusReset();
+
+// 块内发声弦数 → 归一增益斜坡，原地乘到 left / right
+void masterBusNormalize(float *left, float *right, int frames, int activeVoices);
+
+// 总增益 + 限幅，原地处理；输出比输入晚 kBlockFrames 个 sample。
+// frames 不能超过 kBlockFrames
+void masterBusProcess(float *left, float *right, int frames, float targetGain);
+
+// 当前限幅增益（1 = 没在压），stats 用
+float masterBusLimiterGain();
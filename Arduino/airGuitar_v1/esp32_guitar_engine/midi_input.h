@@ -0,0 +1,93 @@
+#pragma once
+//
+// midi_input.h
+// ==============================
+// USB 串口上的 MIDI 字节流解析（mode midi）。
+//
+//  - 每个字节 O(1)：状态机，不拷贝 String、不 sscanf
+//  - 支持 running status（同一状态字节后连续的数据对）
+//  - 实时消息（0xF8..0xFF）可以插在任何位置，直接忽略，不打断 running status
+//  - System common（0xF1..0xF6）清掉 running status，它们的数据字节丢弃
+//  - SysEx 只保留前两个数据字节（用来认退出命令），其余丢弃，但数据字节数照数
+//
+// 消息怎么映射到引擎在 esp32_guitar_engine.ino 的 handleMidiMessage 里。
+//
+
+#include <stdint.h>
+
+struct MidiMessage {
+  uint8_t status;   // 0x80..0xE0 | channel；SysEx 为 0xF0
+  uint8_t data1;
+  uint8_t data2;
+  uint8_t sysexLen; // SysEx 的数据字节数（封顶 255），通道消息为 0
+};
+
+struct MidiParser {
+  uint8_t running;    // 当前 running status（0 = 没有）
+  uint8_t data[2];
+  uint8_t count;      // 已收到的数据字节
+  bool    inSysex;
+  uint8_t sysex[2];
+  uint8_t sysexLen;
+};
+
+inline void midiParserReset(MidiParser &p) {
+  p.running  = 0;
+  p.count    = 0;
+  p.inSysex  = false;
+  p.sysexLen = 0;
+}
+
+// 通道消息的数据字节数：程序切换 / 通道压力 1 个，其它 2 个
+inline uint8_t midiDataLength(uint8_t status) {
+  uint8_t type = status & 0xF0;
+  return (type == 0xC0 || type == 0xD0) ? 1 : 2;
+}
+
+// 喂一个字节；凑齐一条消息时写 out 并返回 true
+inline bool midiParseByte(MidiParser &p, uint8_t b, MidiMessage &out) {
+  if (b >= 0xF8) return false;              // 实时消息（clock / start / active sensing ...）
+
+  if (b & 0x80) {
+    if (p.inSysex) {
+      p.inSysex = false;
+      if (b == 0xF7) {
+        out.status   = 0xF0;
+        out.data1    = p.sysexLen > 0 ? p.sysex[0] : 0;
+        out.data2    = p.sysexLen > 1 ? p.sysex[1] : 0;
+        out.sysexLen = p.sysexLen;
+        return true;
+      }
+      // 没有 F7 就来了新的状态字节：SysEx 作废，按新状态处理
+    }
+    if (b == 0xF0) {
+      p.inSysex  = true;
+      p.sysexLen = 0;
+      p.running  = 0;
+    } else if (b >= 0xF1) {
+      p.running = 0;                        // system common
+    } else {
+      p.running = b;
+    }
+    p.count = 0;
+    return false;
+  }
+
+  // 数据字节
+  if (p.inSysex) {
+    if (p.sysexLen < 2) p.sysex[p.sysexLen] = b;
+    if (p.sysexLen < 255) p.sysexLen++;
+    return false;
+  }
+  if (p.running == 0) return false;         // 没有状态的数据字节（串口上的文本之类）
+
+  p.data[p.count++] = b;
+  if (p.count < midiDataLength(p.running)) return false;
+
+  out.status   = p.running;
+  out.data1    = p.data[0];
+  out.data2    = p.count > 1 ? p.data[1] : 0;
+  out.sysexLen = 0;
+  p.count      = 0;                         // running status：下一对数据沿用这个状态
+  return true;
+}
@@ -0,0 +1,60 @@
+#pragma once
+//
+// noise_gen.h
+// ==============================
+// 可设种子的快速白噪声（xorshift32），拨弦激励和切音“啪”共用。
+//
+//  - 只用 32 位整数移位 / 异或，同一个种子在主机和 ESP32 上得到
+//    完全相同的比特序列；转 float 时只乘 2 的幂（1/32768），也是精确的
+//  - noiseFill() 一次填一整段，比逐 sample 调 Arduino random()
+//    （esp_random + 取模）快得多，bench noise 有对比
+//  - 种子 0 会让 xorshift 卡死在 0，noiseSeed() 先过一遍 splitmix32
+//
+// 注意：渲染结果逐比特一致还取决于后面的浮点运算（libm、FMA 合并），
+// 噪声本身保证一致。
+//
+
+#include <stdint.h>
+
+struct NoiseGen {
+  uint32_t state;
+};
+
+// 引擎共用的噪声源（定义在 esp32_guitar_engine.ino）
+extern NoiseGen gNoise;
+
+inline void noiseSeed(NoiseGen &g, uint32_t seed) {
+  // splitmix32：相近的种子也得到差别很大的初始状态
+  uint32_t z = seed + 0x9E3779B9u;
+  z = (z ^ (z >> 16)) * 0x85EBCA6Bu;
+  z = (z ^ (z >> 13)) * 0xC2B2AE35u;
+  z ^= z >> 16;
+  g.state = (z != 0) ? z : 0x6D2B79F5u;
+}
+
+inline uint32_t noiseNext(NoiseGen &g) {
+  uint32_t x = g.state;
+  x ^= x << 13;
+  x ^= x >> 17;
+  x ^= x << 5;
+  g.state = x;
+  return x;
+}
+
+// [-1, 1)，16 位分辨率（和原来 random(-32768, 32767) / 32768 一样的量化）
+inline float noiseFloat(NoiseGen &g) {
+  return (float)(int16_t)(noiseNext(g) >> 16) * (1.0f / 32768.0f);
+}
+
+// 填 n 个 [-scale, scale) 的噪声
+inline void noiseFill(NoiseGen &g, float *out, int n, float scale = 1.0f) {
+  uint32_t x = g.state;
+  const float k = scale * (1.0f / 32768.0f);
+  for (int i = 0; i < n; ++i) {
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    out[i] = (float)(int16_t)(x >> 16) * k;
+  }
+  g.state = x;
+}
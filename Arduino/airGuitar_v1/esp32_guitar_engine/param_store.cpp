@@ -0,0 +1,290 @@
+#include <Arduino.h>
+#include <Preferences.h>
+#include <atomic>
+#include <stddef.h>
+#include "param_store.h"
+#include "rate_params.h"
+
+// 串口名字 → ToneParams 里的一个（或一组）float
+struct ParamDef {
+  const char *name;
+  size_t      offset;
+  int         count;      // > 1：数组（detune），set / get 带下标
+  float       minValue;
+  float       maxValue;
+  const char *unit;
+};
+
+#define PARAM_DEF(name, field, count, lo, hi, unit) \
+  { name, offsetof(ToneParams, field), count, lo, hi, unit }
+
+static const ParamDef kParamDefs[] = {
+  PARAM_DEF("strum_slow_ms", interDelayMsSlow,   1,           0.0f,   100.0f,       "ms"),
+  PARAM_DEF("strum_fast_ms", interDelayMsFast,   1,           0.0f,   100.0f,       "ms"),
+  PARAM_DEF("decay_min",     ksDecayMin,         1,           0.9f,   kKsDecayCeil, ""),
+  PARAM_DEF("decay_max",     ksDecayMax,         1,           0.9f,   kKsDecayCeil, ""),
+  PARAM_DEF("noise_rms",     baseNoiseTargetRms, 1,           0.01f,  1.0f,         ""),
+  PARAM_DEF("vel_rms_min",   velRmsScaleMin,     1,           0.0f,   4.0f,         "x"),
+  PARAM_DEF("vel_rms_max",   velRmsScaleMax,     1,           0.0f,   4.0f,         "x"),
+  PARAM_DEF("bright_min",    loopBrightnessMin,  1,           0.05f,  1.0f,         ""),
+  PARAM_DEF("bright_max",    loopBrightnessMax,  1,           0.05f,  1.0f,         ""),
+  PARAM_DEF("tone_hz",       lpToneCutoffHz,     1,           50.0f,  8000.0f,      "Hz"),
+  PARAM_DEF("presence",      presenceMix,        1,           0.0f,   1.0f,         ""),
+  PARAM_DEF("body_hz",       bodyCutoffHz,       1,           5.0f,   1000.0f,      "Hz"),
+  PARAM_DEF("body_mix",      bodyMix,            1,           0.0f,   1.0f,         ""),
+  PARAM_DEF("gain",          outputGain,         1,           0.0f,   10.0f,        "x"),
+  PARAM_DEF("detune",        detuneCents,        kNumStrings, -50.0f, 50.0f,        "cent"),
+  PARAM_DEF("choke_ms",      chokeLengthMs,      1,           0.0f,   200.0f,       "ms"),
+  PARAM_DEF("choke_amp",     chokeBaseAmp,       1,           0.0f,   2.0f,         ""),
+  PARAM_DEF("choke_tau_ms",  chokeEnvTauMs,      1,           0.05f,  50.0f,        "ms"),
+  PARAM_DEF("symp",          sympGain,           1,           0.0f,   0.02f,        ""),
+  PARAM_DEF("repluck",       repluckKeep,        1,           0.0f,   1.0f,         ""),
+};
+constexpr int kNumParamDefs = sizeof(kParamDefs) / sizeof(kParamDefs[0]);
+
+#undef PARAM_DEF
+
+// NVS 里存的整块：版本或大小对不上就当没存过
+struct StoredParams {
+  uint16_t   version;
+  uint16_t   size;
+  ToneParams params;
+};
+
+static ToneParams gParams;
+static int        gParamsRate = kSampleRate;
+
+// 双缓冲：gTone 指向前台，另一份是后台；gPending = 后台有新发布的系数
+static ToneCoefs         gCoefs[2];
+static std::atomic<bool> gPending{false};
+const ToneCoefs         *gTone = &gCoefs[0];
+
+static ToneParams defaultToneParams() {
+  ToneParams p;
+  p.interDelayMsSlow   = kInterDelayMsSlow;
+  p.interDelayMsFast   = kInterDelayMsFast;
+  p.ksDecayMin         = kKsDecayMin;
+  p.ksDecayMax         = kKsDecayMax;
+  p.baseNoiseTargetRms = kBaseNoiseTargetRms;
+  p.velRmsScaleMin     = kVelRmsScaleMin;
+  p.velRmsScaleMax     = kVelRmsScaleMax;
+  p.loopBrightnessMin  = kLoopBrightnessMin;
+  p.loopBrightnessMax  = kLoopBrightnessMax;
+  p.lpToneCutoffHz     = kLpToneCutoffHz;
+  p.presenceMix        = kPresenceMix;
+  p.bodyCutoffHz       = kBodyCutoffHz;
+  p.bodyMix            = kBodyMix;
+  p.outputGain         = kOutputGain;
+  for (int i = 0; i < kNumStrings; ++i) {
+    p.detuneCents[i]   = kDetuneCents[i];
+  }
+  p.chokeLengthMs      = kChokeLengthMs;
+  p.chokeBaseAmp       = kChokeBaseAmp;
+  p.chokeEnvTauMs      = kChokeEnvTauMs;
+  p.sympGain           = kSympGain;
+  p.repluckKeep        = kRepluckKeep;
+  return p;
+}
+
+static void computeToneCoefs(const ToneParams &p, int rate, ToneCoefs &c) {
+  float samplesPerMs = (float)rate * 0.001f;
+
+  c.interDelayMsSlow   = p.interDelayMsSlow;
+  c.interDelayMsFast   = p.interDelayMsFast;
+  c.ksDecayMin         = p.ksDecayMin;
+  c.ksDecaySpan        = p.ksDecayMax - p.ksDecayMin;
+  c.baseNoiseTargetRms = p.baseNoiseTargetRms;
+  c.velRmsScaleMin     = p.velRmsScaleMin;
+  c.velRmsScaleSpan    = p.velRmsScaleMax - p.velRmsScaleMin;
+  c.loopBrightnessMin  = p.loopBrightnessMin;
+  c.loopBrightnessSpan = p.loopBrightnessMax - p.loopBrightnessMin;
+  c.lpToneAlpha        = onePoleAlpha(p.lpToneCutoffHz, rate);
+  c.presenceMix        = p.presenceMix;
+  c.bodyAlpha          = onePoleAlpha(p.bodyCutoffHz, rate);
+  c.bodyMix            = p.bodyMix;
+  c.outputGain         = p.outputGain;
+  for (int i = 0; i < kNumStrings; ++i) {
+    c.detuneCents[i]   = p.detuneCents[i];
+    c.detuneRatio[i]   = powf(2.0f, p.detuneCents[i] / 1200.0f);
+  }
+  c.chokeLengthSamples = (int)(p.chokeLengthMs * samplesPerMs);
+  c.chokeEnvDecay      = expf(-1.0f / (p.chokeEnvTauMs * samplesPerMs));
+  c.chokeBaseAmp       = p.chokeBaseAmp;
+  c.sympGain           = p.sympGain;
+  c.repluckKeep        = p.repluckKeep;
+}
+
+// 算进后台那份，下一块开头 paramsSwap 换上来
+static void publishToneCoefs() {
+  ToneCoefs &back = (gTone == &gCoefs[0]) ? gCoefs[1] : gCoefs[0];
+  computeToneCoefs(gParams, gParamsRate, back);
+  gPending.store(true, std::memory_order_release);
+}
+
+void paramsSwap() {
+  if (gPending.exchange(false, std::memory_order_acq_rel)) {
+    gTone = (gTone == &gCoefs[0]) ? &gCoefs[1] : &gCoefs[0];
+  }
+}
+
+static float *paramSlot(ToneParams &p, const ParamDef &d, int index) {
+  return (float *)((uint8_t *)&p + d.offset) + index;
+}
+
+static const ParamDef *findParam(const char *name) {
+  for (int i = 0; i < kNumParamDefs; ++i) {
+    if (strcasecmp(kParamDefs[i].name, name) == 0) return &kParamDefs[i];
+  }
+  return nullptr;
+}
+
+static bool setParamValue(ToneParams &p, const char *name, int index, float value) {
+  const ParamDef *d = findParam(name);
+  if (d == nullptr || index < 0 || index >= d->count) return false;
+  if (!(value >= d->minValue && value <= d->maxValue)) return false;   // 含 NaN
+  *paramSlot(p, *d, index) = value;
+  return true;
+}
+
+// NVS 里读回来的值逐个检查，坏的换回默认值
+static int sanitizeParams(ToneParams &p) {
+  ToneParams def = defaultToneParams();
+  int fixed = 0;
+  for (int i = 0; i < kNumParamDefs; ++i) {
+    const ParamDef &d = kParamDefs[i];
+    for (int k = 0; k < d.count; ++k) {
+      float v = *paramSlot(p, d, k);
+      if (!(v >= d.minValue && v <= d.maxValue)) {
+        *paramSlot(p, d, k) = *paramSlot(def, d, k);
+        fixed++;
+      }
+    }
+  }
+  return fixed;
+}
+
+static bool loadParams(ToneParams &out) {
+  Preferences prefs;
+  if (!prefs.begin(kParamsNvsNamespace, true)) return false;
+
+  StoredParams stored;
+  bool ok = prefs.getBytesLength(kParamsNvsKey) == sizeof(stored) &&
+            prefs.getBytes(kParamsNvsKey, &stored, sizeof(stored)) == sizeof(stored) &&
+            stored.version == kParamsNvsVersion &&
+            stored.size == sizeof(ToneParams);
+  prefs.end();
+
+  if (ok) out = stored.params;
+  return ok;
+}
+
+void paramsBegin(int sampleRate) {
+  gParams     = defaultToneParams();
+  gParamsRate = sampleRate;
+
+  ToneParams stored;
+  if (loadParams(stored)) {
+    int fixed = sanitizeParams(stored);
+    gParams   = stored;
+    Serial.print("[Params] loaded from NVS");
+    if (fixed > 0) {
+      Serial.print(", ");
+      Serial.print(fixed);
+      Serial.print(" bad value(s) reset to default");
+    }
+    Serial.println();
+  }
+
+  // 开机还没在渲染：两份都直接算好
+  computeToneCoefs(gParams, gParamsRate, gCoefs[0]);
+  gCoefs[1] = gCoefs[0];
+  gTone     = &gCoefs[0];
+  gPending.store(false, std::memory_order_release);
+}
+
+void paramsSetRate(int sampleRate) {
+  gParamsRate = sampleRate;
+  publishToneCoefs();
+}
+
+bool paramsSet(const char *name, int index, float value) {
+  if (!setParamValue(gParams, name, index, value)) return false;
+  publishToneCoefs();
+  return true;
+}
+
+int paramsCount(const char *name) {
+  const ParamDef *d = findParam(name);
+  return d == nullptr ? 0 : d->count;
+}
+
+bool paramsPreset(const char *name) {
+  for (int i = 0; i < kNumParamPresets; ++i) {
+    const ParamPresetDef &preset = kParamPresets[i];
+    if (strcasecmp(preset.name, name) != 0) continue;
+
+    // 预设只写和默认值不同的项，其余回到默认
+    ToneParams p = defaultToneParams();
+    for (int k = 0; k < preset.count; ++k) {
+      const ParamOverride &o = preset.overrides[k];
+      if (!setParamValue(p, o.name, o.index, o.value)) {
+        Serial.print("[Params] preset ");
+        Serial.print(preset.name);
+        Serial.print(": bad entry ");
+        Serial.println(o.name);
+      }
+    }
+    gParams = p;
+    publishToneCoefs();
+    return true;
+  }
+  return false;
+}
+
+bool paramsSave() {
+  StoredParams stored;
+  stored.version = kParamsNvsVersion;
+  stored.size    = sizeof(ToneParams);
+  stored.params  = gParams;
+
+  Preferences prefs;
+  if (!prefs.begin(kParamsNvsNamespace, false)) return false;
+  bool ok = prefs.putBytes(kParamsNvsKey, &stored, sizeof(stored)) == sizeof(stored);
+  prefs.end();
+  return ok;
+}
+
+static void printParam(const ParamDef &d) {
+  Serial.printf("  %-14s", d.name);
+  for (int k = 0; k < d.count; ++k) {
+    Serial.printf(" %g", *paramSlot(gParams, d, k));
+  }
+  if (d.unit[0] != '\0') Serial.printf(" %s", d.unit);
+  Serial.printf("  [%g .. %g]\n", d.minValue, d.maxValue);
+}
+
+void paramsPrint(const char *name) {
+  if (name != nullptr && name[0] != '\0') {
+    const ParamDef *d = findParam(name);
+    if (d == nullptr) {
+      Serial.print("Unknown param: ");
+      Serial.println(name);
+      return;
+    }
+    printParam(*d);
+    return;
+  }
+  Serial.printf("Params @ %d Hz (set <name> <value>, save to keep):\n", gParamsRate);
+  for (int i = 0; i < kNumParamDefs; ++i) {
+    printParam(kParamDefs[i]);
+  }
+}
+
+void paramsPrintPresets() {
+  Serial.print("Presets:");
+  for (int i = 0; i < kNumParamPresets; ++i) {
+    Serial.print(' ');
+    Serial.print(kParamPresets[i].name);
+  }
+  Serial.println();
+}
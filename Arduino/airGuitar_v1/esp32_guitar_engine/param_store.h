@@ -0,0 +1,104 @@
+#pragma once
+//
+// param_store.h
+// ==============================
+// 运行时可调的音色 / 手感参数：串口 set / get / save / preset，存在 NVS（Preferences）。
+// guitar_params.h 里对应的 constexpr 只是出厂默认值，改参数不用重新编译烧录。
+//
+//   loop：命令 set / preset                      renderBlock 开头
+//   ToneParams（物理量）──按当前采样率换算──▶ 后台那份 ToneCoefs
+//                                   pending ──▶ paramsSwap()：前后台交换（指针）
+//
+//  - 渲染只读 gTone 指向的前台那份，一块之内不会变；写的一方只写后台那份，
+//    没有锁，也不会读到写了一半的参数
+//  - 写（串口命令）和交换都在 loop 所在的任务里、两次 renderBlock 之间，
+//    一次命令里改多个参数（preset）也只在下一块开头整体生效
+//  - 换算（powf / expf）只在改参数 / 换采样率时做一次，起音和逐 sample 路径只读系数
+//  - save 把当前参数整体写进 NVS（写 flash 期间 I2S DMA 里已有的几块继续播），
+//    开机 paramsBegin 读回来；版本号或大小对不上就用默认值
+//
+// 命令（见 esp32_guitar_engine.ino 的 processCommand）：
+//   get [name]            不带名字列出全部
+//   set <name> <value>    detune 要带弦号：set detune 1 -6（1 = 最低音弦）
+//   save                  写进 NVS，下次开机生效
+//   preset [name|list]    套用内置预设（default = guitar_params.h 的默认值），不自动保存
+//
+
+#include <stdint.h>
+#include "guitar_params.h"
+
+// 串口能改的量，单位和 guitar_params.h 里一样
+struct ToneParams {
+  float interDelayMsSlow;
+  float interDelayMsFast;
+  float ksDecayMin;
+  float ksDecayMax;
+  float baseNoiseTargetRms;
+  float velRmsScaleMin;
+  float velRmsScaleMax;
+  float loopBrightnessMin;
+  float loopBrightnessMax;
+  float lpToneCutoffHz;
+  float presenceMix;
+  float bodyCutoffHz;
+  float bodyMix;
+  float outputGain;
+  float detuneCents[kNumStrings];
+  float chokeLengthMs;
+  float chokeBaseAmp;
+  float chokeEnvTauMs;
+  float sympGain;
+  float repluckKeep;
+};
+
+// 渲染用的系数：由 ToneParams + 采样率换算
+struct ToneCoefs {
+  float interDelayMsSlow;
+  float interDelayMsFast;
+  float ksDecayMin;
+  float ksDecaySpan;         // Max - Min，起音时 × 力度
+  float baseNoiseTargetRms;
+  float velRmsScaleMin;
+  float velRmsScaleSpan;
+  float loopBrightnessMin;
+  float loopBrightnessSpan;
+  float lpToneAlpha;         // 高频低通
+  float presenceMix;
+  float bodyAlpha;           // 箱体低通
+  float bodyMix;
+  float outputGain;
+  float detuneCents[kNumStrings];   // wavetable 后端按 cent 移调
+  float detuneRatio[kNumStrings];   // KS 后端：频率直接乘
+  int   chokeLengthSamples;
+  float chokeEnvDecay;       // 每 sample 乘一次
+  float chokeBaseAmp;
+  float sympGain;            // 共鸣：琴桥 → 共鸣弦，0 = 关
+  float repluckKeep;         // 还在响的弦再拨时保留多少，0 = 整条重填
+};
+
+// 当前块用的系数（前台那份，定义在 param_store.cpp）
+extern const ToneCoefs *gTone;
+
+// 开机：从 NVS 读参数（没有就用默认值），按 sampleRate 算好系数
+void paramsBegin(int sampleRate);
+
+// 换采样率：按新采样率重算（下一块生效）
+void paramsSetRate(int sampleRate);
+
+// renderBlock 开头调用：有新发布的系数就交换前后台（每块一次，只看一个标志）
+void paramsSwap();
+
+// 改一个参数；name 不认识 / 越界返回 false。detune 的 index 是 0..kNumStrings-1
+bool paramsSet(const char *name, int index, float value);
+
+// 参数有几个值：1 = 单值，> 1 = 数组（detune，set 要带弦号），0 = 不认识
+int paramsCount(const char *name);
+
+// 套用内置预设，不认识返回 false
+bool paramsPreset(const char *name);
+
+bool paramsSave();
+
+void paramsPrint(const char *name);   // nullptr = 全部
+void paramsPrintPresets();
+
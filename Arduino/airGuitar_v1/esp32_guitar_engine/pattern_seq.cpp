@@ -0,0 +1,218 @@
+#include <Arduino.h>
+#include "pattern_seq.h"
+
+enum SeqEventKind : uint8_t {
+  SEQ_DOWN = 0,
+  SEQ_UP   = 1,
+  SEQ_PICK = 2
+};
+
+// 一个非空拍的步：偏移（相对小节开头，samples）在换速度时重算
+struct SeqEvent {
+  uint32_t offset;
+  uint8_t  kind;
+  uint8_t  stringIndex;
+  float    velocity;      // 相对手势力度的倍数
+};
+
+struct SeqState {
+  int      pattern;
+  float    bpm;
+  int      sampleRate;
+
+  // 预先算好的表
+  SeqEvent events[kPatternMaxSteps];
+  int      numEvents;
+  uint32_t barSamples;
+  uint32_t strumSpread;   // 节奏型扫弦的弦间隔（samples）
+
+  // 播放状态
+  bool     playing;       // 当前小节还有步没弹
+  bool     running;       // 定速播放：小节弹完接下一小节
+  uint32_t barStart;
+  int      next;          // 下一个要排的 event
+  int      chordIndex;
+  float    velocity;
+};
+
+static SeqState gSeq = { -1, kPatternDefaultBpm, kSampleRate };
+
+constexpr bool patternStepsValid(const char *steps) {
+  int n = 0;
+  for (; steps[n] != '\0'; ++n) {
+    char c = steps[n];
+    bool ok = c == 'D' || c == 'U' || c == 'd' || c == 'u' || c == '-' ||
+              (c >= '1' && c <= '0' + kNumStrings);
+    if (!ok) return false;
+  }
+  return n > 0 && n <= kPatternMaxSteps;
+}
+
+constexpr bool allPatternsValid() {
+  for (int i = 0; i < kNumPatterns; ++i) {
+    if (!patternStepsValid(kPatterns[i].steps) || kPatterns[i].stepsPerBeat < 1) return false;
+  }
+  return true;
+}
+static_assert(allPatternsValid(), "kPatterns: bad step character or too many steps");
+
+// 速度 / 节奏型 / 采样率变了才调用：这里的浮点运算每次改参数只做一遍
+static void seqRebuildTables() {
+  gSeq.numEvents  = 0;
+  gSeq.barSamples = 0;
+  gSeq.strumSpread = (uint32_t)(kPatternStrumMs * 0.001f * (float)gSeq.sampleRate + 0.5f);
+  if (gSeq.pattern < 0) return;
+
+  const PatternDef &p = kPatterns[gSeq.pattern];
+  double samplesPerStep = 60.0 * gSeq.sampleRate / ((double)gSeq.bpm * p.stepsPerBeat);
+
+  int step = 0;
+  for (; p.steps[step] != '\0'; ++step) {
+    char c = p.steps[step];
+    if (c == '-') continue;
+
+    SeqEvent &e   = gSeq.events[gSeq.numEvents++];
+    e.offset      = (uint32_t)(step * samplesPerStep + 0.5);
+    e.stringIndex = 0;
+    if (c >= '1' && c <= '9') {
+      e.kind        = SEQ_PICK;
+      e.stringIndex = (uint8_t)(c - '1');
+      e.velocity    = kPatternPickVel;
+    } else {
+      e.kind     = (c == 'U' || c == 'u') ? SEQ_UP : SEQ_DOWN;
+      e.velocity = (c == 'D' || c == 'U') ? 1.0f : kPatternSoftVel;
+    }
+  }
+  gSeq.barSamples = (uint32_t)(step * samplesPerStep + 0.5);
+}
+
+int seqFindPattern(const char *name) {
+  for (int i = 0; i < kNumPatterns; ++i) {
+    if (strcasecmp(name, kPatterns[i].name) == 0) return i;
+  }
+  return -1;
+}
+
+void seqSetPattern(int index) {
+  if (index >= kNumPatterns) return;
+  gSeq.pattern = index;
+  seqRebuildTables();
+  // 正在弹的小节：定速播放时新节奏型从下一小节开始，否则直接停
+  gSeq.next = gSeq.numEvents;
+  if (index < 0) {
+    gSeq.running = false;
+    gSeq.playing = false;
+  }
+}
+
+int seqPattern() {
+  return gSeq.pattern;
+}
+
+void seqSetTempo(float bpm) {
+  gSeq.bpm = constrain(bpm, kPatternMinBpm, kPatternMaxBpm);
+  seqRebuildTables();
+}
+
+float seqTempo() {
+  return gSeq.bpm;
+}
+
+void seqSetRate(int sampleRate) {
+  gSeq.sampleRate = sampleRate;
+  seqRebuildTables();
+  seqStop();
+}
+
+void seqTrigger(uint32_t now, int chordIndex, float velocityNorm) {
+  if (gSeq.pattern < 0) return;
+  gSeq.velocity = velocityNorm;
+  if (gSeq.running) return;   // 定速播放时手势只改力度
+
+  gSeq.playing    = true;
+  gSeq.barStart   = now;
+  gSeq.next       = 0;
+  gSeq.chordIndex = chordIndex;
+}
+
+void seqRun(bool on, uint32_t now) {
+  if (!on) {
+    seqStop();
+    return;
+  }
+  if (gSeq.pattern < 0) {
+    Serial.println("Pick a pattern first (pattern list)");
+    return;
+  }
+  if (gSeq.velocity <= 0.0f) gSeq.velocity = 0.8f;
+  gSeq.running    = true;
+  gSeq.playing    = true;
+  gSeq.barStart   = now;
+  gSeq.next       = 0;
+  gSeq.chordIndex = autoKeyNextChordIndex();
+}
+
+bool seqRunning() {
+  return gSeq.running;
+}
+
+void seqStop() {
+  gSeq.running = false;
+  gSeq.playing = false;
+}
+
+void seqUpdate(uint32_t now, int frames) {
+  if (!gSeq.playing) return;
+
+  uint32_t end = now + (uint32_t)frames;
+  for (;;) {
+    if (gSeq.next >= gSeq.numEvents) {
+      if (!gSeq.running) {
+        gSeq.playing = false;
+        return;
+      }
+      uint32_t nextBar = gSeq.barStart + gSeq.barSamples;
+      if ((int32_t)(nextBar - end) >= 0) return;
+      gSeq.barStart   = nextBar;
+      gSeq.next       = 0;
+      gSeq.chordIndex = autoKeyNextChordIndex();
+      continue;
+    }
+
+    const SeqEvent &e = gSeq.events[gSeq.next];
+    uint32_t t = gSeq.barStart + e.offset;
+    if ((int32_t)(t - end) >= 0) return;
+
+    float v = gSeq.velocity * e.velocity;
+    if (e.kind == SEQ_PICK) {
+      schedulePatternPick(gSeq.chordIndex, e.stringIndex, v, t);
+    } else {
+      schedulePatternStrum(e.kind == SEQ_UP, gSeq.chordIndex, v, t, gSeq.strumSpread);
+    }
+    gSeq.next++;
+  }
+}
+
+void seqPrintList() {
+  for (int i = 0; i < kNumPatterns; ++i) {
+    Serial.print("  ");   Serial.print(kPatterns[i].name);
+    Serial.print("  ");   Serial.println(kPatterns[i].steps);
+  }
+}
+
+void seqPrintStatus() {
+  Serial.print("Pattern: ");
+  Serial.print(gSeq.pattern < 0 ? "off" : kPatterns[gSeq.pattern].name);
+  Serial.print(", tempo ");   Serial.print(gSeq.bpm, 0);
+  Serial.print(" bpm, ");     Serial.print(gSeq.running ? "running" : "on gesture");
+  Serial.println();
+  if (gSeq.pattern < 0) return;
+  Serial.print("  bar ");     Serial.print(gSeq.barSamples);
+  Serial.print(" samples, "); Serial.print(gSeq.numEvents);
+  Serial.print(" events at");
+  for (int i = 0; i < gSeq.numEvents; ++i) {
+    Serial.print(" ");
+    Serial.print(gSeq.events[i].offset);
+  }
+  Serial.println();
+}
@@ -0,0 +1,50 @@
+#pragma once
+//
+// pattern_seq.h
+// ==============================
+// AutoKey 节奏型 / 分解和弦音序器：一个 AutoKey 和弦按 kPatterns 展开成一小节，
+// 每一步变成 ScheduledPluck（起音时刻精确到 sample）。
+//
+//  - 换速度 / 换节奏型 / 换采样率时把每步的 sample 偏移预先算成整数表，
+//    渲染时只做整数比较，不做逐 sample 的浮点运算
+//  - 两种用法：
+//      手势触发：每个 AutoKey 手势从当下开始弹一小节
+//      定速播放（pattern run）：按 tempo 一小节接一小节，每小节取下一个 AutoKey 和弦
+//  - renderBlock 每块开头调用 seqUpdate，把本块内到期的步排进 pluck 队列
+//
+
+#include <stdint.h>
+#include "guitar_params.h"
+
+// 按名字找节奏型，找不到返回 -1
+int seqFindPattern(const char *name);
+
+// -1 = 关（AutoKey 手势还是一次扫弦）
+void seqSetPattern(int index);
+int  seqPattern();
+
+void  seqSetTempo(float bpm);
+float seqTempo();
+
+// 换采样率后重算偏移表，并停掉正在弹的小节
+void seqSetRate(int sampleRate);
+
+// AutoKey 手势：从 now 开始用 chordIndex 弹一小节（定速播放时只更新力度）
+void seqTrigger(uint32_t now, int chordIndex, float velocityNorm);
+
+void seqRun(bool on, uint32_t now);
+bool seqRunning();
+void seqStop();
+
+// 每块一次：把 [now, now + frames) 内到期的步排进 pluck 队列
+void seqUpdate(uint32_t now, int frames);
+
+void seqPrintStatus();
+void seqPrintList();
+
+// ---- 由 esp32_guitar_engine.ino 提供 ----
+int  autoKeyNextChordIndex();
+void schedulePatternStrum(bool up, int chordIndex, float velocityNorm,
+                          uint32_t startSample, uint32_t spreadSamples);
+void schedulePatternPick(int chordIndex, int stringIndex, float velocityNorm,
+                         uint32_t triggerSample);
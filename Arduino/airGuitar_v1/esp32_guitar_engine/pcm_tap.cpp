@@ -0,0 +1,198 @@
+#include <Arduino.h>
+#include <atomic>
+#include <stddef.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include "pcm_tap.h"
+
+static const int kTapTaskCore     = 0;
+static const int kTapTaskPriority = 1;     // 比效果核低：只搬数据，慢了就丢帧
+static const int kTapTaskStack    = 3072;
+
+struct PcmTapFrame {
+  char     magic[4];
+  uint32_t seq;
+  uint32_t stamp;
+  uint32_t rate;
+  uint16_t frames;
+  uint8_t  channels;
+  uint8_t  decim;
+  int16_t  pcm[kPcmTapFrames * 2];
+  uint16_t check;
+};
+
+// 实际发出去的字节数（不含结构体末尾的对齐填充）
+static const size_t kTapPayloadBytes = offsetof(PcmTapFrame, check);
+static const size_t kTapFrameBytes   = kTapPayloadBytes + sizeof(uint16_t);
+
+static_assert(offsetof(PcmTapFrame, pcm) == 20, "PcmTapFrame header must be 20 bytes");
+static_assert((kPcmTapRingFrames & (kPcmTapRingFrames - 1)) == 0,
+              "kPcmTapRingFrames must be a power of two");
+
+struct TapStats {
+  uint32_t produced;       // 渲染核凑满的帧（= 下一个序号）
+  uint32_t dropped;        // ring 满，丢掉的帧
+  uint32_t sent;
+  uint32_t txWaits;        // 发送任务因为 TX 缓冲不够等过的次数
+  float    pushCycles;     // pcmTapPush 每块平均 cycle
+};
+
+// 单生产者（loop）单消费者（tapTask），和 effects_chain.h 的 BlockRing 一样的做法
+static PcmTapFrame           gRing[kPcmTapRingFrames];
+static std::atomic<uint32_t> gHead{0};
+static std::atomic<uint32_t> gTail{0};
+
+static PcmTapFrame       gBuild;           // 渲染核正在凑的一帧
+static int               gBuildFrames = 0;
+static int32_t           gAccL = 0, gAccR = 0;
+static int               gAccCount = 0;
+static int               gDecim    = 1;
+static TaskHandle_t      gTapTask  = nullptr;
+static std::atomic<bool> gTapOn{false};
+static std::atomic<bool> gTapBusy{false};
+static TapStats          gTapStats;
+
+static uint16_t fletcher16(const uint8_t *data, size_t n) {
+  uint32_t a = 0, b = 0;
+  while (n > 0) {
+    // 每 360 字节取一次模，中间不会溢出 32 位
+    size_t chunk = n < 360 ? n : 360;
+    n -= chunk;
+    while (chunk-- > 0) {
+      a += *data++;
+      b += a;
+    }
+    a %= 255;
+    b %= 255;
+  }
+  return (uint16_t)((b << 8) | a);
+}
+
+static void setSerialBaud(uint32_t baud) {
+  Serial.flush();
+#if !ARDUINO_USB_CDC_ON_BOOT
+  Serial.updateBaudRate(baud);   // 原生 USB CDC 不看波特率
+#endif
+}
+
+static void tapTask(void *) {
+  for (;;) {
+    ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(10));
+
+    gTapBusy = true;
+    while (gTapOn) {
+      uint32_t t = gTail.load(std::memory_order_relaxed);
+      if (gHead.load(std::memory_order_acquire) == t) break;
+
+      PcmTapFrame &f = gRing[t & (kPcmTapRingFrames - 1)];
+      if (Serial.availableForWrite() < (int)(kTapFrameBytes + kPcmTapTxReserve)) {
+        gTapStats.txWaits++;
+        gTapBusy = false;
+        vTaskDelay(1);          // 让串口发一会儿；这期间 ring 满了渲染核会丢帧
+        gTapBusy = true;
+        continue;
+      }
+      f.check = fletcher16((const uint8_t *)&f, kTapPayloadBytes);
+      Serial.write((const uint8_t *)&f, kTapFrameBytes);
+      gTapStats.sent++;
+      gTail.store(t + 1, std::memory_order_release);
+    }
+    gTapBusy = false;
+  }
+}
+
+void pcmTapStart(int decim) {
+  if (decim < 1) decim = 1;
+  if (decim > kPcmTapMaxDecim) decim = kPcmTapMaxDecim;
+  while (decim & (decim - 1)) decim &= decim - 1;   // 向下取 2 的幂
+
+  pcmTapStop();
+  gDecim       = decim;
+  gBuildFrames = 0;
+  gAccL = gAccR = 0;
+  gAccCount    = 0;
+  gHead.store(0, std::memory_order_relaxed);
+  gTail.store(0, std::memory_order_relaxed);
+  memset(&gTapStats, 0, sizeof(gTapStats));
+
+  if (gTapTask == nullptr) {
+    xTaskCreatePinnedToCore(tapTask, "pcmtap", kTapTaskStack, nullptr,
+                            kTapTaskPriority, &gTapTask, kTapTaskCore);
+  }
+
+  Serial.print("[Tap] on, decim ");   Serial.print(gDecim);
+  Serial.print(", serial ");          Serial.print(kPcmTapBaud);
+  Serial.println(" baud");
+  setSerialBaud(kPcmTapBaud);
+  gTapOn = true;
+}
+
+void pcmTapStop() {
+  if (!gTapOn) return;
+  gTapOn = false;
+  while (gTapBusy) {
+    delay(1);
+  }
+  setSerialBaud(kSerialBaud);
+  Serial.println();
+  Serial.println("[Tap] off");
+}
+
+bool pcmTapActive() {
+  return gTapOn;
+}
+
+// 凑满一帧：有空位就拷进 ring，没有就丢（序号照样往前走，主机据此补缺口）
+static void finishFrame() {
+  gBuild.seq = gTapStats.produced++;
+  uint32_t h = gHead.load(std::memory_order_relaxed);
+  if (h - gTail.load(std::memory_order_acquire) >= (uint32_t)kPcmTapRingFrames) {
+    gTapStats.dropped++;
+  } else {
+    memcpy(&gRing[h & (kPcmTapRingFrames - 1)], &gBuild, kTapPayloadBytes);
+    gHead.store(h + 1, std::memory_order_release);
+    if (gTapTask != nullptr) xTaskNotifyGive(gTapTask);
+  }
+  gBuildFrames = 0;
+}
+
+void pcmTapPush(const uint32_t *frames, int count, uint32_t stamp, int sampleRate) {
+  if (!gTapOn) return;
+
+  uint32_t t0 = ESP.getCycleCount();
+  for (int i = 0; i < count; ++i) {
+    if (gBuildFrames == 0 && gAccCount == 0) {
+      memcpy(gBuild.magic, "AGPT", 4);
+      gBuild.stamp    = stamp + (uint32_t)i;
+      gBuild.rate     = (uint32_t)(sampleRate / gDecim);
+      gBuild.frames   = kPcmTapFrames;
+      gBuild.channels = 2;
+      gBuild.decim    = (uint8_t)gDecim;
+    }
+    gAccL += (int16_t)(frames[i] & 0xFFFF);
+    gAccR += (int16_t)(frames[i] >> 16);
+    if (++gAccCount < gDecim) continue;
+
+    // 抽取：N 个 sample 取平均（简单的盒式低通，decim = 1 时就是原样）
+    gBuild.pcm[2 * gBuildFrames]     = (int16_t)(gAccL / gDecim);
+    gBuild.pcm[2 * gBuildFrames + 1] = (int16_t)(gAccR / gDecim);
+    gAccL = gAccR = 0;
+    gAccCount = 0;
+    if (++gBuildFrames >= kPcmTapFrames) finishFrame();
+  }
+  gTapStats.pushCycles += 0.05f * ((float)(ESP.getCycleCount() - t0) - gTapStats.pushCycles);
+}
+
+void pcmTapPrintStats() {
+  Serial.print("Tap: ");         Serial.print(gTapOn ? "on" : "off");
+  Serial.print(", decim ");      Serial.print(gDecim);
+  Serial.print(", ");            Serial.print(kTapFrameBytes);
+  Serial.print(" B/frame of ");  Serial.print(kPcmTapFrames);
+  Serial.println(" stereo samples");
+  Serial.print("  frames ");     Serial.print(gTapStats.produced);
+  Serial.print(", sent ");       Serial.print(gTapStats.sent);
+  Serial.print(", dropped ");    Serial.print(gTapStats.dropped);
+  Serial.print(", tx waits ");   Serial.println(gTapStats.txWaits);
+  Serial.print("  push ");       Serial.print(gTapStats.pushCycles, 0);
+  Serial.println(" cyc/block on the render core");
+}
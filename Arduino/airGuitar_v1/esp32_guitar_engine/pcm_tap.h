@@ -0,0 +1,37 @@
+#pragma once
+//
+// pcm_tap.h
+// ==============================
+// 调试用 PCM 抓取：把送进 I2S 的 int16 立体声原样（或抽取后）从 USB 串口发出去，
+// 主机上用 tools/pcm_tap_to_wav.py 拼回 WAV，不用再拿麦克风对着喇叭录。
+//
+//   loop()（core 1）                          tapTask（core 0，优先级最低）
+//   packI2sFrames → pcmTapPush ──ring──▶  校验和 → Serial.write(一整帧)
+//
+//  - 渲染核只做抽取和 memcpy，从不等待：ring 满了这一帧丢掉，计数，
+//    帧序号照样加一，主机按序号缺口补静音并打标记
+//  - 发送任务只在串口 TX 缓冲还剩 帧长 + kPcmTapTxReserve 时才写，
+//    loop() 里的文本输出不会被抓取挤得阻塞
+//  - 一帧一次 Serial.write，和文本输出不会在帧中间交错；主机按 magic + 校验和重新同步，
+//    中间夹着的文本行直接跳过
+//
+// 帧格式（小端）：
+//   "AGPT" | seq u32 | stamp u32 | rate u32 | frames u16 | channels u8 | decim u8
+//   | int16 × frames × channels（L R 交错） | fletcher16 u16（从 magic 到 pcm 末尾）
+//   stamp = 这一帧第一个 sample 的 gSampleCounter，rate = 抽取后的采样率
+//
+
+#include <stdint.h>
+#include "guitar_params.h"
+
+// 开始抓取（decim = 1..kPcmTapMaxDecim，取 2 的幂），串口切到 kPcmTapBaud
+void pcmTapStart(int decim);
+// 停止，串口切回 kSerialBaud
+void pcmTapStop();
+bool pcmTapActive();
+
+// loop() 每块调用一次：frames 是 packI2sFrames 打包好的 32-bit 帧（低半字 = L），
+// stamp = 这一块第一个 sample 的 gSampleCounter
+void pcmTapPush(const uint32_t *frames, int count, uint32_t stamp, int sampleRate);
+
+void pcmTapPrintStats();
@@ -0,0 +1,61 @@
+#pragma once
+//
+// rate_params.h
+// ==============================
+// 由当前采样率推出来的所有运行时参数。
+// guitar_params.h 只写“物理量”（Hz / ms），这里换算成每 sample 的系数，
+// 切换采样率（串口 rate 命令）时整体重算一次。
+//
+// 注意：KS 的 decay 是“每绕延迟线一圈乘一次”，衰减时间只和音高有关，
+// 与采样率无关，所以不在这里换算。
+// 串口能改的音色参数（音色滤波、切音）不在这里，由 param_store.h 按采样率换算。
+//
+
+#include <math.h>
+#include "guitar_params.h"
+
+constexpr int kSupportedRates[]  = { 16000, 22050, 44100, 48000 };
+constexpr int kNumSupportedRates = sizeof(kSupportedRates) / sizeof(kSupportedRates[0]);
+
+struct RateParams {
+  int   sampleRate;
+  float samplesPerMs;        // 扫弦偏移等 ms → samples
+  float masterGainAlpha;     // 每块一次：总增益平滑
+  float limiterRelease;      // 每块一次：限幅增益恢复
+  float modToneAlpha;        // 每块一次：voice 调制（衰减 / 亮度）平滑
+  float modGainAlpha;        // 每块一次：voice 调制（增益）平滑
+  int   palmMuteHoldSamples;
+  float stringDampAlpha;     // 每块一次：止音时增益滑向 0
+  float sympLowAlpha;        // 共鸣琴桥带通：低端 / 高端一阶低通
+  float sympHighAlpha;
+};
+
+// 当前采样率下的参数（定义在 esp32_guitar_engine.ino）
+extern RateParams gRate;
+
+inline bool isSupportedRate(int rate) {
+  for (int i = 0; i < kNumSupportedRates; ++i) {
+    if (kSupportedRates[i] == rate) return true;
+  }
+  return false;
+}
+
+// 一阶低通系数：y += alpha * (x - y)
+inline float onePoleAlpha(float cutoffHz, int rate) {
+  return 1.0f - expf(-2.0f * (float)M_PI * cutoffHz / (float)rate);
+}
+
+inline RateParams computeRateParams(int rate) {
+  RateParams p;
+  p.sampleRate         = rate;
+  p.samplesPerMs       = (float)rate * 0.001f;
+  p.masterGainAlpha    = 1.0f - expf(-(float)kBlockFrames / (kMasterGainSmoothMs * p.samplesPerMs));
+  p.limiterRelease     = 1.0f - expf(-(float)kBlockFrames / (kLimiterReleaseMs * p.samplesPerMs));
+  p.modToneAlpha       = 1.0f - expf(-(float)kBlockFrames / (kModToneSmoothMs * p.samplesPerMs));
+  p.modGainAlpha       = 1.0f - expf(-(float)kBlockFrames / (kModGainSmoothMs * p.samplesPerMs));
+  p.palmMuteHoldSamples = (int)(kPalmMuteHoldMs * p.samplesPerMs);
+  p.stringDampAlpha    = 1.0f - expf(-(float)kBlockFrames / (kStringDampMs * p.samplesPerMs));
+  p.sympLowAlpha       = onePoleAlpha(kSympBridgeLowHz, rate);
+  p.sympHighAlpha      = onePoleAlpha(kSympBridgeHighHz, rate);
+  return p;
+}
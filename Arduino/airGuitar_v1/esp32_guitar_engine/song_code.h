@@ -0,0 +1,118 @@
+#pragma once
+//
+// song_code.h
+// ==============================
+// AutoKey 歌曲的紧凑字节编码 + O(1) 状态的播放游标。
+//
+// 编码（每个字节 uint8_t）：
+//   0x80 | n        SECTION：段开始，整段轮 n 次（1..127）
+//   c, k            RUN：和弦 c（和弦索引，< 0x80）连扫 k 次（1..255）
+//   0x80            END：歌曲结束（= 轮 0 次的 SECTION），回到开头
+//
+// 一段从它的 SECTION 到下一个 SECTION / END 为止，段里至少一个 RUN。
+// 原来 REP 宏展开的 int 数组每次扫弦 4 B，这里每个 RUN 2 B。
+//
+// 在 guitar_params.h 里用 SONG_SECTION / SONG_RUN / SONG_END 写成
+// constexpr uint8_t 数组，songValid / songStrumCount 在编译期检查。
+//
+
+#include <stdint.h>
+#include <stddef.h>
+
+constexpr uint8_t kSongSectionFlag = 0x80;
+constexpr uint8_t kSongEnd         = 0x80;
+
+#define SONG_SECTION(n)   (uint8_t)(kSongSectionFlag | (n))
+#define SONG_RUN(ch, n)   (uint8_t)(ch), (uint8_t)(n)
+#define SONG_END          kSongEnd
+
+// 编码合法：以 SECTION 开头、以 END 结尾，每段至少一个 RUN，
+// RUN 的次数 ≥ 1，和弦索引 < numChords
+constexpr bool songValid(const uint8_t *code, size_t len, int numChords) {
+  if (len < 4 || code[0] == kSongEnd || !(code[0] & kSongSectionFlag)) return false;
+  size_t i = 0;
+  int runsInSection = 0;
+  while (i < len) {
+    uint8_t b = code[i];
+    if (b & kSongSectionFlag) {
+      if (i > 0 && runsInSection == 0) return false;
+      if (b == kSongEnd) return i == len - 1;
+      runsInSection = 0;
+      ++i;
+    } else {
+      if (i + 1 >= len || b >= numChords || code[i + 1] == 0) return false;
+      ++runsInSection;
+      i += 2;
+    }
+  }
+  return false;   // 没有 END
+}
+
+// 整首歌一共扫几次（各段展开后）
+constexpr int songStrumCount(const uint8_t *code, size_t len) {
+  int total = 0, section = 0, repeat = 1;
+  for (size_t i = 0; i < len; ) {
+    uint8_t b = code[i];
+    if (b & kSongSectionFlag) {
+      total  += section * repeat;
+      section = 0;
+      repeat  = b & 0x7F;
+      if (b == kSongEnd) break;
+      ++i;
+    } else {
+      section += code[i + 1];
+      i += 2;
+    }
+  }
+  return total;
+}
+
+// 播放游标：只有几个字节的状态，取下一个和弦是 O(1)
+struct SongCursor {
+  const uint8_t *code;
+  uint16_t pos;           // 下一个要读的字节
+  uint16_t sectionStart;  // 当前段第一个 RUN 的位置
+  uint8_t  sectionLeft;   // 当前段还剩几轮（含正在播的这一轮）
+  uint8_t  runLeft;       // 当前 RUN 还剩几次
+  uint8_t  chord;         // 当前 RUN 的和弦
+};
+
+inline void songCursorReset(SongCursor &c, const uint8_t *code) {
+  c.code         = code;
+  c.pos          = 0;
+  c.sectionStart = 0;
+  c.sectionLeft  = 0;
+  c.runLeft      = 0;
+  c.chord        = 0;
+}
+
+// 读下一个 RUN；遇到段尾时要么回到段头，要么进下一段 / 回到歌曲开头。
+// 编码合法时最多跳两次标记字节（段尾 → END → 开头 SECTION）就读到 RUN
+inline void songLoadRun(SongCursor &c) {
+  for (;;) {
+    uint8_t b = c.code[c.pos];
+    if (!(b & kSongSectionFlag)) {
+      c.chord   = b;
+      c.runLeft = c.code[c.pos + 1];
+      c.pos    += 2;
+      return;
+    }
+    if (c.sectionLeft > 1) {           // 本段再轮一次
+      --c.sectionLeft;
+      c.pos = c.sectionStart;
+    } else if (b == kSongEnd) {        // 整首结束，从头再来
+      c.pos = 0;
+      c.sectionLeft = 0;
+    } else {                           // 进入下一段
+      c.sectionLeft  = b & 0x7F;
+      c.pos         += 1;
+      c.sectionStart = c.pos;
+    }
+  }
+}
+
+inline int songNextChord(SongCursor &c) {
+  if (c.runLeft == 0) songLoadRun(c);
+  --c.runLeft;
+  return c.chord;
+}
@@ -0,0 +1,321 @@
+#include <Arduino.h>
+#include <LittleFS.h>
+#include <atomic>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include "song_library.h"
+#include "trace.h"
+
+static const int kLoaderTaskCore     = 0;
+static const int kLoaderTaskPriority = 1;      // 比效果器（2）低，只在空闲时读文件
+static const int kLoaderTaskStack    = 4096;
+static const int kLineLen            = 128;
+
+enum SlotState : uint8_t {
+  SLOT_EMPTY   = 0,
+  SLOT_LOADING = 1,
+  SLOT_READY   = 2,
+  SLOT_FAILED  = 3
+};
+
+struct SongSlot {
+  std::atomic<uint8_t> state;
+  int      index;                    // 装的是第几首（LOADING 时 = 正在加载的）
+  uint16_t len;
+  char     title[kSongTitleLen];
+  char     error[40];                // FAILED 时的原因
+  uint8_t  code[kSongMaxBytes];
+};
+
+static SongSlot      gSlots[2];
+static int           gActiveSlot = -1;     // -1 = 内置歌，0/1 = gSlots
+static int           gActiveIndex = 0;
+static int           gWanted     = -1;     // 点了但还没加载好的歌
+static char          gFiles[kSongMaxSongs][kSongFileNameLen];
+static int           gCount      = 1;
+static bool          gFsOk       = false;
+static TaskHandle_t  gLoaderTask = nullptr;
+static int         (*gLookup)(const char *name) = nullptr;
+
+// ---------------- 谱子编译（加载任务里跑） ----------------
+
+static bool emitByte(SongSlot &s, uint8_t b) {
+  if (s.len >= kSongMaxBytes) return false;
+  s.code[s.len++] = b;
+  return true;
+}
+
+static bool fail(SongSlot &s, const char *why, int line) {
+  snprintf(s.error, sizeof(s.error), "line %d: %s", line, why);
+  return false;
+}
+
+static bool compileLine(SongSlot &s, char *line, int lineNo, bool &inSection) {
+  char *save = nullptr;
+  char *tok  = strtok_r(line, " \t\r", &save);
+  if (tok == nullptr || tok[0] == '#') return true;
+
+  if (strcasecmp(tok, "title") == 0) {
+    char *rest = strtok_r(nullptr, "\r", &save);
+    while (rest && (*rest == ' ' || *rest == '\t')) ++rest;
+    strncpy(s.title, rest ? rest : "", sizeof(s.title) - 1);
+    s.title[sizeof(s.title) - 1] = '\0';
+    return true;
+  }
+
+  if (strcasecmp(tok, "section") == 0) {
+    char *arg = strtok_r(nullptr, " \t\r", &save);
+    int repeat = arg ? atoi(arg) : 1;
+    if (repeat < 1 || repeat > 127) return fail(s, "section repeat 1..127", lineNo);
+    inSection = true;
+    return emitByte(s, SONG_SECTION(repeat)) || fail(s, "song too long", lineNo);
+  }
+
+  for (; tok != nullptr; tok = strtok_r(nullptr, " \t\r", &save)) {
+    if (tok[0] == '#') break;   // 行尾注释
+    int count = 1;
+    char *star = strchr(tok, '*');
+    if (star != nullptr) {
+      *star = '\0';
+      count = atoi(star + 1);
+    }
+    int chord = gLookup ? gLookup(tok) : -1;
+    if (chord < 0)  return fail(s, "unknown chord", lineNo);
+    if (count < 1)  return fail(s, "bad count", lineNo);
+    if (!inSection) {           // 没写 section 就当作轮 1 次的一段
+      if (!emitByte(s, SONG_SECTION(1))) return fail(s, "song too long", lineNo);
+      inSection = true;
+    }
+    while (count > 0) {         // RUN 次数只有一个字节，超过 255 拆开
+      int n = count > 255 ? 255 : count;
+      if (!emitByte(s, (uint8_t)chord) || !emitByte(s, (uint8_t)n)) {
+        return fail(s, "song too long", lineNo);
+      }
+      count -= n;
+    }
+  }
+  return true;
+}
+
+static bool compileSong(SongSlot &s, int index) {
+  s.len      = 0;
+  s.title[0] = '\0';
+  s.error[0] = '\0';
+
+  char path[kSongFileNameLen + sizeof(kSongDir) + 1];
+  snprintf(path, sizeof(path), "%s/%s", kSongDir, gFiles[index]);
+  File f = LittleFS.open(path, "r");
+  if (!f) return fail(s, "cannot open", 0);
+
+  char line[kLineLen];
+  int  lineNo = 0;
+  bool inSection = false;
+  bool ok = true;
+  while (ok && f.available()) {
+    size_t n = f.readBytesUntil('\n', line, kLineLen - 1);
+    line[n] = '\0';
+    ok = compileLine(s, line, ++lineNo, inSection);
+  }
+  f.close();
+  if (!ok) return false;
+
+  if (!emitByte(s, SONG_END)) return fail(s, "song too long", lineNo);
+  if (!songValid(s.code, s.len, kNumChordIndices)) return fail(s, "empty section", lineNo);
+  if (s.title[0] == '\0') {
+    strncpy(s.title, gFiles[index], sizeof(s.title) - 1);
+    s.title[sizeof(s.title) - 1] = '\0';
+  }
+  return true;
+}
+
+static void songLoaderTask(void *) {
+  for (;;) {
+    ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+    // loop 只在槽不是 LOADING 时发请求，所以这里独占那个槽
+    for (SongSlot &s : gSlots) {
+      if (s.state.load(std::memory_order_acquire) != SLOT_LOADING) continue;
+      bool ok = compileSong(s, s.index);
+      s.state.store(ok ? SLOT_READY : SLOT_FAILED, std::memory_order_release);
+    }
+  }
+}
+
+// ---------------- loop 侧 ----------------
+
+static int spareSlot() {
+  return gActiveSlot == 0 ? 1 : 0;
+}
+
+static void startLoad(int index) {
+  SongSlot &s = gSlots[spareSlot()];
+  s.index = index;
+  s.state.store(SLOT_LOADING, std::memory_order_release);
+  if (gLoaderTask != nullptr) xTaskNotifyGive(gLoaderTask);
+}
+
+// 选歌 / 加载完都在 loop 里（渲染循环），只发 TRACE。
+// 标题在当前槽里，这个槽在换歌之前不会被重新加载，打印时还有效
+static void activate(int index, int slot) {
+  gActiveSlot  = slot;
+  gActiveIndex = index;
+  TRACE(TR_SONG, index, songLibActiveTitle());
+}
+
+static void loadIndex() {
+  gCount = 1;
+  char path[sizeof(kSongDir) + 12];
+  snprintf(path, sizeof(path), "%s/index.txt", kSongDir);
+  File f = LittleFS.open(path, "r");
+  if (!f) {
+    Serial.println("Songs: no /songs/index.txt, built-in song only");
+    return;
+  }
+  char line[kLineLen];
+  while (f.available() && gCount < kSongMaxSongs) {
+    size_t n = f.readBytesUntil('\n', line, kLineLen - 1);
+    line[n] = '\0';
+    char *save = nullptr;
+    char *name = strtok_r(line, " \t\r", &save);
+    if (name == nullptr || name[0] == '#') continue;
+    strncpy(gFiles[gCount], name, kSongFileNameLen - 1);
+    gFiles[gCount][kSongFileNameLen - 1] = '\0';
+    ++gCount;
+  }
+  f.close();
+}
+
+void songLibBegin(int (*lookup)(const char *name)) {
+  gLookup = lookup;
+  for (SongSlot &s : gSlots) {
+    s.state.store(SLOT_EMPTY);
+    s.index = -1;
+  }
+  gActiveSlot  = -1;
+  gActiveIndex = 0;
+  gWanted      = -1;
+
+  gFsOk = LittleFS.begin(false);
+  if (!gFsOk) {
+    Serial.println("Songs: LittleFS mount failed, built-in song only");
+    gCount = 1;
+    return;
+  }
+  loadIndex();
+  if (gLoaderTask == nullptr && gCount > 1) {
+    xTaskCreatePinnedToCore(songLoaderTask, "songs", kLoaderTaskStack, nullptr,
+                            kLoaderTaskPriority, &gLoaderTask, kLoaderTaskCore);
+  }
+  Serial.print("Songs: ");
+  Serial.print(gCount);
+  Serial.println(" (0 = built-in)");
+}
+
+int songLibCount() {
+  return gCount;
+}
+
+int songLibActiveIndex() {
+  return gActiveIndex;
+}
+
+const char *songLibActiveTitle() {
+  return gActiveSlot < 0 ? "built-in" : gSlots[gActiveSlot].title;
+}
+
+const uint8_t *songLibActiveCode() {
+  return gActiveSlot < 0 ? kAutoKeySong : gSlots[gActiveSlot].code;
+}
+
+int songLibActiveBytes() {
+  return gActiveSlot < 0 ? kAutoKeySongBytes : gSlots[gActiveSlot].len;
+}
+
+bool songLibSelect(int index) {
+  if (index < 0 || index >= gCount) {
+    TRACE(TR_SONG_MISSING, index);
+    return false;
+  }
+  gWanted = -1;
+  if (index == 0) {
+    activate(0, -1);
+    return true;
+  }
+  if (index == gActiveIndex) {
+    return true;   // 重新从头播
+  }
+  SongSlot &s = gSlots[spareSlot()];
+  if (s.index == index && s.state.load(std::memory_order_acquire) == SLOT_READY) {
+    activate(index, spareSlot());
+    return true;
+  }
+  gWanted = index;   // 还没在 RAM 里：songLibPoll 加载完再切
+  return false;
+}
+
+bool songLibPoll() {
+  if (gCount <= 1) return false;
+
+  SongSlot &s   = gSlots[spareSlot()];
+  uint8_t state = s.state.load(std::memory_order_acquire);
+  if (state == SLOT_LOADING) return false;
+
+  // 点了歌就加载那首，否则预取下一首（下一首是内置歌时不用）
+  int next   = (gActiveIndex + 1) % gCount;
+  int target = gWanted >= 0 ? gWanted : (next == 0 ? -1 : next);
+  if (target < 0) return false;
+
+  if (s.index != target) {
+    startLoad(target);
+    return false;
+  }
+  if (state == SLOT_FAILED) {
+    if (gWanted == target) {
+      // 备用槽接着会被预取覆盖：原因先拷出来，TRACE 只存指针
+      static char failReason[sizeof(s.error)];
+      memcpy(failReason, s.error, sizeof(failReason));
+      TRACE(TR_SONG_FAILED, target, gFiles[target], failReason);
+      gWanted = -1;
+    }
+    return false;
+  }
+  if (gWanted == target && state == SLOT_READY) {
+    gWanted = -1;
+    activate(target, spareSlot());
+    return true;
+  }
+  return false;
+}
+
+void songLibPrintList() {
+  Serial.println("  0: built-in");
+  for (int i = 1; i < gCount; ++i) {
+    Serial.print("  ");  Serial.print(i);
+    Serial.print(": ");  Serial.println(gFiles[i]);
+  }
+}
+
+void songLibPrintStatus() {
+  Serial.print("Song ");         Serial.print(gActiveIndex);
+  Serial.print("/");             Serial.print(gCount);
+  Serial.print(": ");            Serial.print(songLibActiveTitle());
+  Serial.print(", ");            Serial.print(songLibActiveBytes());
+  Serial.println(" B code");
+  if (!gFsOk) return;
+
+  const SongSlot &s = gSlots[spareSlot()];
+  static const char *kStateName[] = { "empty", "loading", "ready", "failed" };
+  Serial.print("  spare slot: ");
+  Serial.print(kStateName[s.state.load()]);
+  if (s.index > 0) {
+    Serial.print(" (song ");     Serial.print(s.index);
+    Serial.print(")");
+  }
+  if (gWanted >= 0) {
+    Serial.print(", waiting for song ");
+    Serial.print(gWanted);
+  }
+  Serial.println();
+  Serial.print("  library RAM: ");
+  Serial.print((int)(sizeof(gSlots) + sizeof(gFiles)));
+  Serial.println(" B");
+}
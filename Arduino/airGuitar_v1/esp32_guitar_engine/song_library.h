@@ -0,0 +1,44 @@
+#pragma once
+//
+// song_library.h
+// ==============================
+// AutoKey 歌曲库：LittleFS 上的和弦谱 + 后台预取。
+//
+//   loop（core 1）                          songLoader（core 0，低优先级）
+//   songLibSelect / songLibPoll ──notify──▶ 读 /songs/<file>，编译成字节码
+//        ▲                                  写进空闲槽，state = READY
+//        └── 槽 READY 且是想要的那首 → 交换 active 指针（O(1)）
+//
+//  - 两个槽：active（AutoKey 游标正在读）+ spare（预取下一首 / 加载点的歌）
+//  - 换歌只是交换指针再重置游标，不读文件、不分配内存，远小于一块音频；
+//    要的歌还没加载好时旧歌继续播，加载完 songLibPoll 再切
+//  - 渲染从不碰歌曲库
+//
+// 谱子格式（UTF-8 纯文本，一行一条）：
+//   # 注释
+//   title 晴天
+//   section 9                ← 开一段，整段轮 9 次（省略次数 = 1）
+//   Em*3 Cmaj7*7 G*7 D*3     ← 和弦名*扫几次（省略 = 1）
+//
+
+#include <stdint.h>
+#include "guitar_params.h"
+
+// lookup：和弦名 → 和弦索引，不认识返回 -1
+void songLibBegin(int (*lookup)(const char *name));
+
+int songLibCount();            // 含内置 0 号
+int songLibActiveIndex();
+const char    *songLibActiveTitle();
+const uint8_t *songLibActiveCode();
+int songLibActiveBytes();
+
+// 选歌：已经在 RAM 里（内置 / 预取好）就立刻切换并返回 true，
+// 否则交给加载任务、返回 false，之后由 songLibPoll 切换
+bool songLibSelect(int index);
+
+// loop 每轮调用：推进预取；等的歌加载好了就切换并返回 true
+bool songLibPoll();
+
+void songLibPrintList();
+void songLibPrintStatus();
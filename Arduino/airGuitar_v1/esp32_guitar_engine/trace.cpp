@@ -0,0 +1,122 @@
+#include <Arduino.h>
+#include <atomic>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include "trace.h"
+
+static const int kTraceTaskCore     = 0;
+static const int kTraceTaskPriority = 1;   // 和 loopTask 一样低，只负责打印
+static const int kTraceTaskStack    = 3072;
+
+static_assert((kTraceRingRecords & (kTraceRingRecords - 1)) == 0,
+              "kTraceRingRecords must be a power of two");
+static_assert(sizeof(kTraceLevels) / sizeof(kTraceLevels[0]) == TR_COUNT,
+              "kTraceLevels out of sync with TRACE_EVENTS");
+
+#define TRACE_X_FMT(id, level, fmt) fmt,
+static const char *const kTraceFormats[] = { TRACE_EVENTS(TRACE_X_FMT) };
+#undef TRACE_X_FMT
+
+struct TraceStats {
+  uint32_t emitted;
+  uint32_t dropped;        // ring 满
+  uint32_t printed;
+  uint32_t maxDepth;
+};
+
+// 单生产者（loop）单消费者（traceTask），和 effects_chain.h 的 BlockRing 一样的做法
+static TraceRecord           gRing[kTraceRingRecords];
+static std::atomic<uint32_t> gHead{0};
+static std::atomic<uint32_t> gTail{0};
+static TaskHandle_t          gTraceTask = nullptr;
+static TraceStats            gTraceStats;
+
+extern uint32_t gSampleCounter;
+
+void traceEmit(uint16_t id, TraceArg a0, TraceArg a1, TraceArg a2, TraceArg a3) {
+  uint32_t h     = gHead.load(std::memory_order_relaxed);
+  uint32_t depth = h - gTail.load(std::memory_order_acquire);
+  if (depth >= (uint32_t)kTraceRingRecords) {
+    gTraceStats.dropped++;
+    return;
+  }
+  TraceRecord &r = gRing[h & (kTraceRingRecords - 1)];
+  r.stamp   = gSampleCounter;
+  r.id      = id;
+  r.args[0] = a0;
+  r.args[1] = a1;
+  r.args[2] = a2;
+  r.args[3] = a3;
+  gHead.store(h + 1, std::memory_order_release);
+
+  gTraceStats.emitted++;
+  if (depth + 1 > gTraceStats.maxDepth) gTraceStats.maxDepth = depth + 1;
+}
+
+// 一条记录 → 一行文本：只认 %d / %f / %s，参数按顺序取
+static int formatRecord(const TraceRecord &r, char *out, int cap) {
+  int n = snprintf(out, cap, "[@%u] ", (unsigned)r.stamp);
+  const char *fmt = (r.id < TR_COUNT) ? kTraceFormats[r.id] : "?";
+  int arg = 0;
+  for (const char *p = fmt; *p != '\0' && n < cap - 2; ++p) {
+    if (p[0] != '%' || p[1] == '\0' || arg >= 4) {
+      out[n++] = *p;
+      continue;
+    }
+    const TraceArg &a = r.args[arg++];
+    switch (*++p) {
+      case 'd': n += snprintf(out + n, cap - n, "%d", (int)a.i);              break;
+      case 'f': n += snprintf(out + n, cap - n, "%.2f", (double)a.f);         break;
+      case 's': n += snprintf(out + n, cap - n, "%s", a.s ? a.s : "(null)");  break;
+      default:  out[n++] = '%'; out[n++] = *p; arg--;                         break;
+    }
+    if (n > cap - 2) n = cap - 2;
+  }
+  out[n++] = '\r';
+  out[n++] = '\n';
+  return n;
+}
+
+static void traceTask(void *) {
+  char     line[160];
+  uint32_t reportedDrops = 0;
+  for (;;) {
+    vTaskDelay(pdMS_TO_TICKS(kTraceDrainMs));
+
+    uint32_t t;
+    while ((t = gTail.load(std::memory_order_relaxed)) != gHead.load(std::memory_order_acquire)) {
+      int n = formatRecord(gRing[t & (kTraceRingRecords - 1)], line, sizeof(line));
+      gTail.store(t + 1, std::memory_order_release);
+      Serial.write((const uint8_t *)line, n);
+      gTraceStats.printed++;
+    }
+
+    uint32_t drops = gTraceStats.dropped;
+    if (drops != reportedDrops) {
+      int n = snprintf(line, sizeof(line), "[Trace] %u records dropped\r\n",
+                       (unsigned)(drops - reportedDrops));
+      Serial.write((const uint8_t *)line, n);
+      reportedDrops = drops;
+    }
+  }
+}
+
+void traceBegin() {
+#if GUITAR_TRACE_LEVEL > TRACE_LEVEL_OFF
+  if (gTraceTask == nullptr) {
+    xTaskCreatePinnedToCore(traceTask, "trace", kTraceTaskStack, nullptr,
+                            kTraceTaskPriority, &gTraceTask, kTraceTaskCore);
+  }
+#endif
+}
+
+void traceStats() {
+  Serial.print("Trace: level ");  Serial.print(GUITAR_TRACE_LEVEL);
+  Serial.print(", emitted ");     Serial.print(gTraceStats.emitted);
+  Serial.print(", printed ");     Serial.print(gTraceStats.printed);
+  Serial.print(", dropped ");     Serial.print(gTraceStats.dropped);
+  Serial.print(", max depth ");   Serial.print(gTraceStats.maxDepth);
+  Serial.print("/");              Serial.print(kTraceRingRecords);
+  Serial.print(" (");             Serial.print((int)sizeof(TraceRecord));
+  Serial.println(" B/record)");
+}
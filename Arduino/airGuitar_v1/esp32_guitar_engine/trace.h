@@ -0,0 +1,89 @@
+#pragma once
+//
+// trace.h
+// ==============================
+// 渲染循环里的调试输出：TRACE() 只往无锁环形缓冲里写一条定长二进制记录
+// （事件号 + gSampleCounter 时间戳 + 最多 4 个参数），
+// core 0 上的低优先级任务每 kTraceDrainMs 取出来格式化，一条记录一次 Serial.write。
+//
+//  - 以前一次扫弦同步打印 ~80 个字符，115200 baud 下要 ~7 ms，比一块音频还长；
+//    现在渲染核上只有几次存储，串口慢了只会丢记录（计数），不会卡 I2S
+//  - 事件和格式串都在下面的 TRACE_EVENTS 表里，每个事件有自己的级别，
+//    比 GUITAR_TRACE_LEVEL 详细的 TRACE() 在编译期就被去掉
+//  - 单生产者：只在 loop() 所在的核（core 1）上调用 TRACE()
+//  - 字符串参数只存指针，打印时才读：只能传字符串常量或静态表里的名字
+//    （kChordVoicings[].name 之类），不能传 String::c_str()
+//
+// 格式串里的占位符：%d 整数、%f 浮点（两位小数）、%s 字符串
+//
+// 用法：
+//   TRACE(TR_CHOKE);
+//   TRACE(TR_MODE, "Serial");
+//
+
+#include <stdint.h>
+#include "guitar_params.h"
+
+//  X(事件号, 级别, 格式串)
+#define TRACE_EVENTS(X)                                                                    \
+  X(TR_STRUM,          TRACE_LEVEL_INFO,  "Strum: %s Chord=%s  v=%d  interDelayMs=%f")     \
+  X(TR_CHOKE,          TRACE_LEVEL_INFO,  "[Choke] CUT + smack")                           \
+  X(TR_PALM_MUTE,      TRACE_LEVEL_INFO,  "[Mod] palm mute")                               \
+  X(TR_MODE,           TRACE_LEVEL_INFO,  "Mode: %s")                                      \
+  X(TR_ATMEGA_FRAME,   TRACE_LEVEL_INFO,  "ATmega: chord=%s gesture=%s v=%d vol=%d")       \
+  X(TR_ATMEGA_UNKNOWN, TRACE_LEVEL_WARN,  "Unknown chord name from ATmega, ignoring.")     \
+  X(TR_ATMEGA_TEMPO,   TRACE_LEVEL_INFO,  "Tempo %d")                                      \
+  X(TR_ATMEGA_LOOP,    TRACE_LEVEL_INFO,  "[Loop] %s")                                     \
+  X(TR_SONG,           TRACE_LEVEL_INFO,  "Song %d: %s")                                   \
+  X(TR_SONG_LOADING,   TRACE_LEVEL_INFO,  "Loading song %d")                               \
+  X(TR_SONG_MISSING,   TRACE_LEVEL_WARN,  "Song %d not in library")                        \
+  X(TR_SONG_FAILED,    TRACE_LEVEL_WARN,  "Song %d (%s) failed: %s")                       \
+  X(TR_MIDI_STATS,     TRACE_LEVEL_INFO,  "MIDI: %d bytes, %d messages, avg %f us/msg (max %f us)") \
+  X(TR_BODY_FALLBACK,  TRACE_LEVEL_WARN,  "[Body] convolution over budget, using tone filters")
+
+#define TRACE_X_ID(id, level, fmt) id,
+enum TraceEventId : uint16_t {
+  TRACE_EVENTS(TRACE_X_ID)
+  TR_COUNT
+};
+#undef TRACE_X_ID
+
+#define TRACE_X_LEVEL(id, level, fmt) level,
+constexpr uint8_t kTraceLevels[] = { TRACE_EVENTS(TRACE_X_LEVEL) };
+#undef TRACE_X_LEVEL
+
+union TraceArg {
+  int32_t     i;
+  float       f;
+  const char *s;
+
+  TraceArg() : i(0) {}
+  TraceArg(int v) : i(v) {}
+  TraceArg(uint32_t v) : i((int32_t)v) {}
+  TraceArg(float v) : f(v) {}
+  TraceArg(double v) : f((float)v) {}
+  TraceArg(const char *v) : s(v) {}
+};
+
+struct TraceRecord {
+  uint32_t stamp;          // gSampleCounter
+  uint16_t id;
+  uint16_t reserved;
+  TraceArg args[4];
+};
+
+#define TRACE(id, ...)                                        \
+  do {                                                        \
+    if (kTraceLevels[id] <= GUITAR_TRACE_LEVEL) {             \
+      traceEmit(id, ##__VA_ARGS__);                           \
+    }                                                         \
+  } while (0)
+
+// 建打印任务（GUITAR_TRACE_LEVEL = 0 时什么都不做）
+void traceBegin();
+
+// 写一条记录；满了丢掉并计数。一般通过 TRACE() 调用
+void traceEmit(uint16_t id, TraceArg a0 = TraceArg(), TraceArg a1 = TraceArg(),
+               TraceArg a2 = TraceArg(), TraceArg a3 = TraceArg());
+
+void traceStats();
@@ -0,0 +1,64 @@
+#pragma once
+//
+// voice_mod.h
+// ==============================
+// 每根弦的参数调制：衰减（damping）、环路亮度、增益。
+//
+//  - 输入侧（手势、踏板、串口……）只改 target
+//  - 渲染每块开头调用一次 voiceModStep()，current 向 target 一阶平滑，
+//    结果交给 voice 的块率接口（KSVoice::modulate / modulateWavetableVoice）
+//    和混音的每弦增益，块内保持不变，不增加逐 sample 的计算
+//
+// 所有量都是对起音时参数的乘数，1 = 不变。
+//
+
+#include <math.h>
+#include "guitar_params.h"
+
+struct VoiceModParams {
+  float decayMul;     // 环路衰减乘数（< 1 更闷，> 1 更长，由 voice 自己限幅）
+  float brightMul;    // 环路亮度乘数
+  float gain;         // 输出增益
+};
+
+struct VoiceMod {
+  VoiceModParams target;
+  VoiceModParams current;
+  float          toneAlpha;   // 每块平滑系数：衰减 / 亮度
+  float          gainAlpha;   // 每块平滑系数：增益（swell 时会放慢，止音时加快）
+  bool           damping;     // 止音中：target 固定为增益 0，滑到底由调用方停掉 voice
+};
+
+constexpr VoiceModParams kVoiceModNeutral = { 1.0f, 1.0f, 1.0f };
+
+inline void voiceModReset(VoiceMod &m, float toneAlpha, float gainAlpha) {
+  m.target    = kVoiceModNeutral;
+  m.current   = kVoiceModNeutral;
+  m.toneAlpha = toneAlpha;
+  m.gainAlpha = gainAlpha;
+  m.damping   = false;
+}
+
+// 每块一次；返回音色类参数是否还在变（不变时 voice 不用重算）
+inline bool voiceModStep(VoiceMod &m) {
+  VoiceModParams &c = m.current;
+  const VoiceModParams &t = m.target;
+  c.gain += m.gainAlpha * (t.gain - c.gain);
+
+  float dd = t.decayMul  - c.decayMul;
+  float db = t.brightMul - c.brightMul;
+  if (fabsf(dd) < 1e-5f && fabsf(db) < 1e-4f) {
+    c.decayMul  = t.decayMul;
+    c.brightMul = t.brightMul;
+    return false;
+  }
+  c.decayMul  += m.toneAlpha * dd;
+  c.brightMul += m.toneAlpha * db;
+  return true;
+}
+
+// 块数 → 平滑系数（时间常数 ms）
+inline float voiceModAlpha(float ms, float samplesPerMs) {
+  if (ms <= 0.0f) return 1.0f;
+  return 1.0f - expf(-(float)kBlockFrames / (ms * samplesPerMs));
+}
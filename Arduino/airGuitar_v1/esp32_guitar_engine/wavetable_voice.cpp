@@ -0,0 +1,167 @@
+#include "wavetable_voice.h"
+#include "param_store.h"
+#include <esp_partition.h>
+
+// 与 partitions.csv 中的 wavetable 分区保持一致
+static const char                   *kWtPartitionLabel   = "wavetable";
+static const esp_partition_subtype_t kWtPartitionSubtype = (esp_partition_subtype_t)0x40;
+
+static const uint32_t kWtMagic        = 0x54574741;  // "AGWT"
+static const int      kWtMaxEntries   = 128;
+
+static const esp_partition_t *gWtPart       = nullptr;
+static WavetableEntry         gWtEntries[kWtMaxEntries];
+static uint16_t               gWtSampleRate = 0;
+static uint8_t                gWtFirstNote  = 0;
+static uint8_t                gWtNoteCount  = 0;
+static uint8_t                gWtLayerCount = 0;
+static size_t                 gWtFlashBytes = 0;
+
+bool wavetableBegin() {
+  gWtPart = esp_partition_find_first(ESP_PARTITION_TYPE_DATA,
+                                     kWtPartitionSubtype, kWtPartitionLabel);
+  if (gWtPart == nullptr) {
+    Serial.println("[Wavetable] partition not found (check partitions.csv)");
+    return false;
+  }
+
+  uint8_t hdr[16];
+  if (esp_partition_read(gWtPart, 0, hdr, sizeof(hdr)) != ESP_OK) {
+    gWtPart = nullptr;
+    return false;
+  }
+
+  uint32_t magic, tableOffset;
+  uint16_t version;
+  memcpy(&magic,   hdr + 0, 4);
+  memcpy(&version, hdr + 4, 2);
+  memcpy(&gWtSampleRate, hdr + 6, 2);
+  gWtFirstNote  = hdr[8];
+  gWtNoteCount  = hdr[9];
+  gWtLayerCount = hdr[10];
+  memcpy(&tableOffset, hdr + 12, 4);
+
+  int entries = gWtNoteCount * gWtLayerCount;
+  if (magic != kWtMagic || version != 1 || gWtSampleRate == 0 ||
+      entries == 0 || entries > kWtMaxEntries) {
+    Serial.println("[Wavetable] bad header, flash data with tools/render_wavetable.py");
+    gWtPart = nullptr;
+    return false;
+  }
+
+  if (esp_partition_read(gWtPart, tableOffset, gWtEntries,
+                         entries * sizeof(WavetableEntry)) != ESP_OK) {
+    gWtPart = nullptr;
+    return false;
+  }
+
+  gWtFlashBytes = 0;
+  for (int i = 0; i < entries; ++i) {
+    size_t end = gWtEntries[i].offset + gWtEntries[i].length * sizeof(int16_t);
+    if (end > gWtPart->size || gWtEntries[i].length >= 0x10000) {
+      Serial.println("[Wavetable] entry out of range");
+      gWtPart = nullptr;
+      return false;
+    }
+    if (end > gWtFlashBytes) gWtFlashBytes = end;
+  }
+
+  Serial.print("[Wavetable] notes ");
+  Serial.print(gWtFirstNote);
+  Serial.print("..");
+  Serial.print(gWtFirstNote + gWtNoteCount - 1);
+  Serial.print(", layers ");
+  Serial.print(gWtLayerCount);
+  Serial.print(", ");
+  Serial.print(gWtFlashBytes);
+  Serial.println(" bytes");
+  return true;
+}
+
+bool wavetableReady() {
+  return gWtPart != nullptr;
+}
+
+size_t wavetableFlashBytes() {
+  return gWtFlashBytes;
+}
+
+size_t wavetableIndexBytes() {
+  return sizeof(gWtEntries);
+}
+
+// 从 flash 读一段到 voice 的缓存，cache[0] = sample[start]
+static void refillCache(WavetableVoice &v, uint32_t start) {
+  uint32_t n = v.length - start;
+  if (n > (uint32_t)kWtCacheSamples) n = kWtCacheSamples;
+  esp_partition_read(gWtPart, v.dataOffset + start * sizeof(int16_t),
+                     v.cache, n * sizeof(int16_t));
+  v.cacheStart = start;
+}
+
+static float velScaleOf(float v) {
+  return gTone->velRmsScaleMin + gTone->velRmsScaleSpan * v;
+}
+
+void initWavetableVoice(WavetableVoice &v, uint8_t midi,
+                        float detuneCents, float velocityNorm) {
+  v.active = false;
+  if (gWtPart == nullptr) return;
+
+  // 超出音域就用最近的 note，再靠 step 移调
+  int note = midi;
+  if (note < gWtFirstNote)                     note = gWtFirstNote;
+  if (note >= gWtFirstNote + gWtNoteCount)     note = gWtFirstNote + gWtNoteCount - 1;
+
+  float vel   = constrain(velocityNorm, 0.0f, 1.0f);
+  int   layer = (int)(vel * gWtLayerCount);
+  if (layer >= gWtLayerCount) layer = gWtLayerCount - 1;
+
+  const WavetableEntry &e = gWtEntries[(note - gWtFirstNote) * gWtLayerCount + layer];
+  if (e.length < 2) return;
+
+  float layerCenter = ((float)layer + 0.5f) / (float)gWtLayerCount;
+  float semis       = (float)((int)midi - note) + detuneCents / 100.0f;
+  float ratio       = powf(2.0f, semis / 12.0f)
+                      * (float)gWtSampleRate / (float)gRate.sampleRate;
+
+  v.dataOffset = e.offset;
+  v.length     = e.length;
+  v.pos        = 0;
+  v.step       = (uint32_t)(ratio * 65536.0f + 0.5f);
+  v.gain       = velScaleOf(vel) / velScaleOf(layerCenter);
+  v.loopsPerBlock = 440.0f * powf(2.0f, ((float)midi - 69.0f + detuneCents / 100.0f) / 12.0f)
+                    * (float)kBlockFrames / (float)gRate.sampleRate;
+  v.active     = true;
+  refillCache(v, 0);
+}
+
+float processWavetableVoice(WavetableVoice &v) {
+  if (!v.active) return 0.0f;
+
+  uint32_t i = v.pos >> 16;
+  if (i + 1 >= v.length) {
+    v.active = false;
+    return 0.0f;
+  }
+
+  uint32_t rel = i - v.cacheStart;
+  if (rel + 1 >= (uint32_t)kWtCacheSamples) {
+    refillCache(v, i);
+    rel = 0;
+  }
+
+  // 线性插值
+  float frac = (float)(v.pos & 0xFFFF) * (1.0f / 65536.0f);
+  float a    = (float)v.cache[rel];
+  float b    = (float)v.cache[rel + 1];
+  v.pos     += v.step;
+
+  return (a + (b - a) * frac) * (v.gain / 32768.0f);
+}
+
+void modulateWavetableVoice(WavetableVoice &v, float decayMul) {
+  if (!v.active || decayMul >= 1.0f) return;
+  v.gain *= powf(decayMul, v.loopsPerBlock);
+  if (v.gain < 1e-4f) v.active = false;
+}
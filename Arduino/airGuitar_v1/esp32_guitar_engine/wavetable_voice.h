@@ -0,0 +1,62 @@
+#pragma once
+//
+// wavetable_voice.h
+// ==============================
+// Wavetable 音色后端：播放预渲染的单音（离线 KS 或真实录音），
+// 按 MIDI note + 力度层存放在 flash 的 "wavetable" 数据分区里，
+// 每个 voice 只在 RAM 中保留 kWtCacheSamples 个 sample 的流式缓存。
+//
+// 分区数据格式（小端，由 tools/render_wavetable.py 生成）：
+//
+//   offset  size  内容
+//   0       4     magic "AGWT"
+//   4       2     version (= 1)
+//   6       2     sampleRate（音色渲染时的采样率）
+//   8       1     firstNote（最低 MIDI note）
+//   9       1     noteCount
+//   10      1     layerCount（力度层数）
+//   11      1     reserved
+//   12      4     entryTableOffset
+//   entryTableOffset 起：noteCount * layerCount 个 WavetableEntry，
+//                        顺序为 [note][layer]
+//   之后：int16 PCM sample 数据
+//
+// 力度层 l 对应的力度中心为 (l + 0.5) / layerCount，层内再按力度线性缩放增益。
+//
+
+#include <Arduino.h>
+#include "guitar_params.h"
+#include "rate_params.h"
+
+struct WavetableEntry {
+  uint32_t offset;   // 分区内字节偏移
+  uint32_t length;   // sample 数
+};
+
+struct WavetableVoice {
+  int16_t  cache[kWtCacheSamples];
+  uint32_t cacheStart;   // cache[0] 对应的 sample 序号
+  uint32_t dataOffset;   // 当前音色在分区内的字节偏移
+  uint32_t length;       // 当前音色总 sample 数（Q16.16 位置 → 最多 65535）
+  uint32_t pos;          // 播放位置，Q16.16
+  uint32_t step;         // 每输出 sample 前进多少，Q16.16（含 detune / 采样率换算）
+  float    gain;
+  float    loopsPerBlock; // 每块经过多少个基频周期（块率衰减调制用）
+  bool     active;
+};
+
+// 查找分区并读入表头 + 索引表；失败返回 false（此时所有 voice 静音）
+bool   wavetableBegin();
+bool   wavetableReady();
+
+// 数据占用的 flash 字节数 / 常驻 RAM 的索引表字节数（供 bench 报告）
+size_t wavetableFlashBytes();
+size_t wavetableIndexBytes();
+
+void  initWavetableVoice(WavetableVoice &v, uint8_t midi,
+                         float detuneCents, float velocityNorm);
+float processWavetableVoice(WavetableVoice &v);
+
+// 块率调制（voice_mod.h）：预渲染音色没法改环路，衰减乘数换算成每块额外的
+// 增益衰减（和 KS 每圈多乘 decayMul 等效）；decayMul ≥ 1（踏板）和亮度无法调制，忽略
+void  modulateWavetableVoice(WavetableVoice &v, float decayMul);
@@ -0,0 +1,207 @@
+#!/usr/bin/env python3
+"""
+pcm_tap_to_wav.py
+==============================
+把 esp32_guitar_engine 的 PCM 抓取（串口命令 tap on，pcm_tap.h）拼回 WAV。
+
+两种来源：
+  1. 串口（默认）：--port，先在 115200 下发 "tap on <decim>"，再切到抓取波特率收 --seconds 秒，
+     最后发 "tap off"。需要 pyserial。--raw FILE 顺便把原始字节存下来
+  2. 之前存下的原始字节：--input FILE
+
+按帧序号拼接：序号有缺口（ESP32 发送端丢帧 / 串口丢字节导致校验失败）的地方补静音，
+并在 WAV 里加 cue 标记（Audacity / Reaper 能看到），--labels 另存一份 Audacity 标签文件。
+帧之间夹着的文本（引擎的 Serial.print）跳过，--text 时打印到 stderr。
+
+帧格式（小端，和 pcm_tap.h 一致）：
+  "AGPT" | seq u32 | stamp u32 | rate u32 | frames u16 | channels u8 | decim u8
+  | int16 × frames × channels | fletcher16 u16
+
+用法：
+  python3 pcm_tap_to_wav.py --port /dev/ttyACM0 --decim 4 --seconds 10 -o tap.wav
+  python3 pcm_tap_to_wav.py --input tap.raw -o tap.wav --labels gaps.txt
+  （48 kHz 立体声不抽取约 208 KB/s，921600 baud 的 USB-UART 桥只够 --decim 4；
+   原生 USB CDC 一般 --decim 1 也跟得上）
+"""
+
+import argparse
+import struct
+import sys
+import time
+
+MAGIC = b"AGPT"
+HEADER = struct.Struct("<4sIIIHBB")    # 20 B
+SERIAL_BAUD = 115200                  # = kSerialBaud
+TAP_BAUD = 921600                     # = kPcmTapBaud
+
+
+def fletcher16(data):
+    a = b = 0
+    for x in data:
+        a = (a + x) % 255
+        b = (b + a) % 255
+    return (b << 8) | a
+
+
+def parse_frames(buf, text_out=None):
+    """扫描字节流，返回 (frames, bad)。frames 是 (seq, stamp, rate, channels, pcm bytes)。"""
+    frames = []
+    bad = 0
+    pos = 0
+    n = len(buf)
+    while pos < n:
+        i = buf.find(MAGIC, pos)
+        if i < 0:
+            if text_out:
+                text_out.write(buf[pos:].decode("utf-8", "replace"))
+            break
+        if text_out and i > pos:
+            text_out.write(buf[pos:i].decode("utf-8", "replace"))
+        if i + HEADER.size > n:
+            break
+        _, seq, stamp, rate, count, channels, _decim = HEADER.unpack_from(buf, i)
+        size = HEADER.size + count * channels * 2
+        if channels not in (1, 2) or count == 0 or count > 4096:
+            bad += 1
+            pos = i + 1
+            continue
+        if i + size + 2 > n:
+            break
+        (check,) = struct.unpack_from("<H", buf, i + size)
+        if check != fletcher16(buf[i:i + size]):
+            bad += 1                  # 文本插进了帧里 / 串口丢字节：当缺口处理
+            pos = i + 1
+            continue
+        frames.append((seq, stamp, rate, channels, bytes(buf[i + HEADER.size:i + size])))
+        pos = i + size + 2
+    return frames, bad
+
+
+def assemble(frames):
+    """按序号拼接，缺口补静音。返回 (rate, channels, pcm bytes, markers)。"""
+    if not frames:
+        return 0, 2, b"", []
+    _, _, rate, channels, _ = frames[0]
+    bytes_per_frame = channels * 2
+    pcm = bytearray()
+    markers = []                      # (sample 位置, 长度, 说明)
+    expect = frames[0][0]
+    for seq, _stamp, frame_rate, ch, data in frames:
+        if frame_rate != rate or ch != channels:
+            markers.append((len(pcm) // bytes_per_frame, 0,
+                            f"format change {frame_rate} Hz x{ch} (skipped)"))
+            continue
+        count = len(data) // bytes_per_frame
+        if seq > expect:
+            missing = (seq - expect) * count
+            markers.append((len(pcm) // bytes_per_frame, missing,
+                            f"gap: {seq - expect} frames dropped"))
+            pcm += bytes(missing * bytes_per_frame)
+        elif seq < expect:
+            markers.append((len(pcm) // bytes_per_frame, 0, "tap restarted"))
+        pcm += data
+        expect = seq + 1
+    return rate, channels, bytes(pcm), markers
+
+
+def write_wav(path, rate, channels, pcm, markers):
+    """16-bit PCM WAV，缺口写成 cue 点 + LIST/adtl 标签。"""
+    chunks = []
+    fmt = struct.pack("<HHIIHH", 1, channels, rate, rate * channels * 2, channels * 2, 16)
+    chunks.append(b"fmt " + struct.pack("<I", len(fmt)) + fmt)
+    chunks.append(b"data" + struct.pack("<I", len(pcm)) + pcm + (b"\0" if len(pcm) & 1 else b""))
+
+    if markers:
+        cue = struct.pack("<I", len(markers))
+        adtl = b"adtl"
+        for i, (pos, _length, text) in enumerate(markers, start=1):
+            cue += struct.pack("<II4sIII", i, pos, b"data", 0, 0, pos)
+            label = text.encode("ascii", "replace") + b"\0"
+            if len(label) & 1:
+                label += b"\0"
+            adtl += b"labl" + struct.pack("<II", 4 + len(label), i) + label
+        chunks.append(b"cue " + struct.pack("<I", len(cue)) + cue)
+        chunks.append(b"LIST" + struct.pack("<I", len(adtl)) + adtl)
+
+    body = b"WAVE" + b"".join(chunks)
+    with open(path, "wb") as f:
+        f.write(b"RIFF" + struct.pack("<I", len(body)) + body)
+
+
+def write_labels(path, rate, markers):
+    """Audacity 标签轨：开始 \\t 结束 \\t 文字（秒）。"""
+    with open(path, "w", encoding="utf-8") as f:
+        for pos, length, text in markers:
+            f.write(f"{pos / rate:.6f}\t{(pos + length) / rate:.6f}\t{text}\n")
+
+
+def capture(port, baud, decim, seconds):
+    try:
+        import serial
+    except ImportError:
+        sys.exit("pyserial not installed (pip install pyserial), or use --input")
+
+    ser = serial.Serial(port, SERIAL_BAUD, timeout=0.1)
+    ser.reset_input_buffer()
+    ser.write(f"tap on {decim}\n".encode())
+    ser.flush()
+    time.sleep(0.2)                   # 等 ESP32 打印完状态、切波特率
+    ser.baudrate = baud
+
+    buf = bytearray()
+    t_end = time.time() + seconds
+    while time.time() < t_end:
+        buf += ser.read(65536)
+
+    ser.write(b"tap off\n")
+    ser.flush()
+    time.sleep(0.2)
+    buf += ser.read(65536)
+    ser.baudrate = SERIAL_BAUD
+    ser.close()
+    return bytes(buf)
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__,
+                                 formatter_class=argparse.RawDescriptionHelpFormatter)
+    ap.add_argument("-o", "--out", default="tap.wav")
+    ap.add_argument("--port", default=None)
+    ap.add_argument("--baud", type=int, default=TAP_BAUD)
+    ap.add_argument("--decim", type=int, default=1, choices=[1, 2, 4, 8])
+    ap.add_argument("--seconds", type=float, default=10.0)
+    ap.add_argument("--input", default=None, help="原始字节文件（--raw 存下的）")
+    ap.add_argument("--raw", default=None, help="把收到的原始字节存到这个文件")
+    ap.add_argument("--labels", default=None, help="另存 Audacity 标签文件（缺口位置）")
+    ap.add_argument("--text", action="store_true", help="把帧之间的文本打印到 stderr")
+    args = ap.parse_args()
+
+    if args.input:
+        with open(args.input, "rb") as f:
+            buf = f.read()
+    elif args.port:
+        buf = capture(args.port, args.baud, args.decim, args.seconds)
+        if args.raw:
+            with open(args.raw, "wb") as f:
+                f.write(buf)
+    else:
+        sys.exit("need --port or --input")
+
+    frames, bad = parse_frames(buf, sys.stderr if args.text else None)
+    rate, channels, pcm, markers = assemble(frames)
+    if not frames:
+        sys.exit(f"no tap frames in {len(buf)} B ({bad} bad)")
+
+    write_wav(args.out, rate, channels, pcm, markers)
+    if args.labels:
+        write_labels(args.labels, rate, markers)
+
+    samples = len(pcm) // (channels * 2)
+    gaps = sum(1 for m in markers if m[1] > 0)
+    lost = sum(m[1] for m in markers)
+    print(f"{args.out}: {samples} samples @ {rate} Hz x{channels} ({samples / rate:.2f} s), "
+          f"{len(frames)} frames, {bad} bad, {gaps} gaps ({lost} samples filled)")
+
+
+if __name__ == "__main__":
+    main()
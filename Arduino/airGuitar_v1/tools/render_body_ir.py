@@ -0,0 +1,132 @@
+#!/usr/bin/env python3
+"""
+render_body_ir.py
+==============================
+生成 esp32_guitar_engine 的琴箱脉冲响应（IR）数据分区（body_convolver.h）。
+
+两种来源：
+  1. 合成（默认）：直达声 + 一组指数衰减的琴箱模态（Helmholtz、顶板、背板……），
+     频率 / Q / 增益在下面 MODES 表里，方便按耳朵调。
+  2. 真实录音：--wav FILE（单声道 16-bit，任意采样率），例如敲琴桥录下的 IR。
+
+引擎加载时会按当前输出采样率重采样并截到 kBodyIrMs，
+所以这里用 48k 生成一次即可，换采样率不需要重新烧录。
+
+整体增益归一到 80 Hz ~ 4 kHz 的平均幅频响应 = --level。
+模态共振会把和弦基频一带抬高，默认 0.45 时扫弦响度和 ToneState 路径基本一致，
+切换 body conv / tone 不会忽大忽小。
+
+数据格式（小端）：
+  magic "AGIR" | version u16 | rate u16 | length u32 | scale f32 | int16 × length
+  实际 sample = int16 × scale
+
+用法：
+  python3 render_body_ir.py -o body_ir.bin
+  python3 -m esptool --chip esp32s3 write_flash 0x350000 body_ir.bin
+  （0x350000 = partitions.csv 里 bodyir 分区的 offset）
+"""
+
+import argparse
+import math
+import struct
+import sys
+import wave
+
+PARTITION_SIZE = 0x10000
+
+MAGIC = b"AGIR"
+VERSION = 1
+
+# (频率 Hz, Q, 相对增益)：民谣吉他箱体的典型模态
+MODES = [
+    (98.0,  12.0, 1.00),   # Helmholtz（音孔空气）
+    (196.0, 18.0, 0.80),   # 顶板第一模态
+    (228.0, 20.0, 0.55),   # 背板
+    (390.0, 25.0, 0.35),
+    (545.0, 30.0, 0.25),
+    (810.0, 35.0, 0.15),
+    (1250.0, 40.0, 0.08),
+]
+DIRECT_GAIN = 0.6          # 直达声（琴弦 → 琴桥）占比
+
+
+def synth_ir(rate, seconds):
+    n = int(rate * seconds)
+    ir = [0.0] * n
+    ir[0] = DIRECT_GAIN
+    for freq, q, gain in MODES:
+        tau = q / (math.pi * freq)            # 模态衰减时间常数
+        w = 2.0 * math.pi * freq / rate
+        amp = gain * w                        # 低频模态不至于压过高频
+        for i in range(1, n):
+            ir[i] += amp * math.exp(-i / (tau * rate)) * math.sin(w * i)
+
+    # 尾部 5ms 淡出，避免截断处的咔嗒
+    fade = min(n, int(rate * 0.005))
+    for i in range(fade):
+        ir[n - fade + i] *= 1.0 - (i + 1) / fade
+    return ir
+
+
+def load_wav(path):
+    with wave.open(path, "rb") as w:
+        if w.getnchannels() != 1 or w.getsampwidth() != 2:
+            sys.exit(f"{path}: need mono 16-bit")
+        rate = w.getframerate()
+        raw = w.readframes(w.getnframes())
+    count = len(raw) // 2
+    return rate, [s / 32768.0 for s in struct.unpack(f"<{count}h", raw)]
+
+
+def mean_response(ir, rate, lo=80.0, hi=4000.0, points=48):
+    """对数频率点上的平均幅频响应（直接 DFT，不依赖 numpy）。"""
+    total = 0.0
+    for k in range(points):
+        f = lo * (hi / lo) ** (k / (points - 1))
+        w = 2.0 * math.pi * f / rate
+        re = sum(x * math.cos(w * i) for i, x in enumerate(ir))
+        im = sum(x * math.sin(w * i) for i, x in enumerate(ir))
+        total += math.hypot(re, im)
+    return total / points
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__,
+                                 formatter_class=argparse.RawDescriptionHelpFormatter)
+    ap.add_argument("-o", "--out", default="body_ir.bin")
+    ap.add_argument("--rate", type=int, default=48000)
+    ap.add_argument("--seconds", type=float, default=0.03,
+                    help="IR 长度，引擎最多用 kBodyIrMs")
+    ap.add_argument("--level", type=float, default=0.45,
+                    help="80 Hz ~ 4 kHz 平均幅频响应")
+    ap.add_argument("--wav", default=None)
+    args = ap.parse_args()
+
+    if args.wav:
+        rate, ir = load_wav(args.wav)
+        ir = ir[:int(rate * args.seconds)]
+    else:
+        rate = args.rate
+        ir = synth_ir(rate, args.seconds)
+
+    norm = mean_response(ir, rate)
+    if norm <= 0.0:
+        sys.exit("IR is silent")
+    ir = [x * args.level / norm for x in ir]
+
+    peak = max(abs(x) for x in ir)
+    scale = peak / 32767.0
+    pcm = [max(-32768, min(32767, int(round(x / scale)))) for x in ir]
+
+    data = MAGIC + struct.pack("<HHIf", VERSION, rate, len(pcm), scale)
+    data += struct.pack(f"<{len(pcm)}h", *pcm)
+    if len(data) > PARTITION_SIZE:
+        sys.exit(f"IR too long: {len(data)} B > partition {PARTITION_SIZE} B")
+
+    with open(args.out, "wb") as f:
+        f.write(data)
+    print(f"{args.out}: {len(pcm)} samples @ {rate} Hz ({len(data)} B), scale {scale:.3e}")
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,156 @@
+#!/usr/bin/env python3
+"""
+render_wavetable.py
+==============================
+生成 esp32_guitar_engine 的 wavetable 数据分区（GUITAR_VOICE_WAVETABLE 后端）。
+
+两种来源：
+  1. 离线渲染 KS 单音（默认）：算法和 ks_voice.cpp 一致，
+     衰减 / RMS / 力度映射直接从 guitar_params.h 读取，保证和实时 KS 听感一致。
+  2. 真实录音：--wav-dir DIR，文件名 <midi>_<layer>.wav（单声道 16-bit，
+     采样率与 --rate 相同），缺的文件仍用 KS 渲染补上。
+
+数据格式见 wavetable_voice.h。
+
+用法：
+  python3 render_wavetable.py -o wavetable.bin
+  python3 -m esptool --chip esp32s3 write_flash 0x210000 wavetable.bin
+  （0x210000 = partitions.csv 里 wavetable 分区的 offset）
+"""
+
+import argparse
+import math
+import os
+import random
+import re
+import struct
+import sys
+import wave
+
+HERE = os.path.dirname(os.path.abspath(__file__))
+PARAMS_H = os.path.join(HERE, "..", "esp32_guitar_engine", "guitar_params.h")
+PARTITION_SIZE = 0x140000
+
+MAGIC = b"AGWT"
+VERSION = 1
+HEADER_SIZE = 16
+
+
+def read_params(path):
+    """读取 guitar_params.h 里的 constexpr float 常量。"""
+    params = {}
+    pat = re.compile(r"constexpr\s+float\s+(\w+)\s*=\s*([-0-9.eE]+)f?\s*;")
+    with open(path, encoding="utf-8") as f:
+        for line in f:
+            m = pat.search(line)
+            if m:
+                params[m.group(1)] = float(m.group(2))
+    return params
+
+
+def midi_to_freq(midi):
+    return 440.0 * 2.0 ** ((midi - 69) / 12.0)
+
+
+def render_ks(freq, vel, rate, seconds, p, rng):
+    """与 initKSString() + processKSString() 相同的离线 KS。"""
+    length = max(2, int(rate / freq + 0.5))
+    decay = p["kKsDecayMin"] + (p["kKsDecayMax"] - p["kKsDecayMin"]) * vel
+    vel_scale = p["kVelRmsScaleMin"] + (p["kVelRmsScaleMax"] - p["kVelRmsScaleMin"]) * vel
+    target_rms = p["kBaseNoiseTargetRms"] * vel_scale
+
+    buf = []
+    prev = 0.0
+    for _ in range(length):
+        val = rng.randint(-32768, 32766) / 32768.0
+        val = 0.4 * val + 0.6 * prev
+        prev = val
+        buf.append(val)
+    rms = math.sqrt(sum(v * v for v in buf) / length)
+    if rms > 1e-6:
+        buf = [v * target_rms / rms for v in buf]
+
+    out = []
+    idx = 0
+    for _ in range(int(seconds * rate)):
+        nxt = idx + 1 if idx + 1 < length else 0
+        y = 0.5 * (buf[idx] + buf[nxt]) * decay
+        buf[idx] = y
+        idx = nxt
+        out.append(y)
+    return out
+
+
+def load_wav(path, rate):
+    with wave.open(path, "rb") as w:
+        if w.getnchannels() != 1 or w.getsampwidth() != 2 or w.getframerate() != rate:
+            sys.exit("%s: need mono 16-bit %d Hz" % (path, rate))
+        raw = w.readframes(w.getnframes())
+    n = len(raw) // 2
+    return [s / 32768.0 for s in struct.unpack("<%dh" % n, raw)]
+
+
+def to_pcm(samples):
+    pcm = bytearray()
+    for v in samples:
+        s = int(round(v * 32767.0))
+        pcm += struct.pack("<h", max(-32768, min(32767, s)))
+    return bytes(pcm)
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__,
+                                 formatter_class=argparse.RawDescriptionHelpFormatter)
+    ap.add_argument("-o", "--out", default="wavetable.bin")
+    ap.add_argument("--rate", type=int, default=16000)
+    ap.add_argument("--first-note", type=int, default=36)  # C2，最低弦 root-12
+    ap.add_argument("--last-note", type=int, default=76)   # E5
+    ap.add_argument("--layers", type=int, default=2)
+    ap.add_argument("--seconds", type=float, default=0.45,
+                    help="KS 在 kKsDecayMax 下约 0.3 s 衰减 60 dB")
+    ap.add_argument("--wav-dir", default=None)
+    ap.add_argument("--seed", type=int, default=1)
+    args = ap.parse_args()
+
+    params = read_params(PARAMS_H)
+    rng = random.Random(args.seed)
+
+    notes = list(range(args.first_note, args.last_note + 1))
+    entries = []
+    blobs = []
+    offset = HEADER_SIZE + len(notes) * args.layers * 8
+
+    for midi in notes:
+        for layer in range(args.layers):
+            vel = (layer + 0.5) / args.layers
+            path = os.path.join(args.wav_dir, "%d_%d.wav" % (midi, layer)) if args.wav_dir else None
+            if path and os.path.exists(path):
+                samples = load_wav(path, args.rate)
+            else:
+                samples = render_ks(midi_to_freq(midi), vel, args.rate,
+                                    args.seconds, params, rng)
+            if len(samples) >= 0x10000:
+                samples = samples[:0xFFFF]
+            pcm = to_pcm(samples)
+            entries.append((offset, len(samples)))
+            blobs.append(pcm)
+            offset += len(pcm)
+
+    if offset > PARTITION_SIZE:
+        sys.exit("wavetable is %d bytes, partition is %d" % (offset, PARTITION_SIZE))
+
+    with open(args.out, "wb") as f:
+        f.write(MAGIC)
+        f.write(struct.pack("<HHBBBBI", VERSION, args.rate, notes[0], len(notes),
+                            args.layers, 0, HEADER_SIZE))
+        for off, length in entries:
+            f.write(struct.pack("<II", off, length))
+        for blob in blobs:
+            f.write(blob)
+
+    print("%s: %d notes x %d layers, %d bytes (%.1f%% of partition)"
+          % (args.out, len(notes), args.layers, offset, 100.0 * offset / PARTITION_SIZE))
+
+
+if __name__ == "__main__":
+    main()
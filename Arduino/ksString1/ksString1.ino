@@ -1,6 +1,7 @@
 #include <Arduino.h>
 #include "driver/i2s.h"
 #include <math.h>
+#include <GuitarEngine.h>
 
 // ================== I2S 参数 ==================
 #define I2S_PORT   I2S_NUM_0
@@ -10,40 +11,40 @@
 #define I2S_LRCLK  17   // LRCLK -> MAX98357A LRC
 #define I2S_DOUT   14   // DATA  -> MAX98357A DIN
 
-#define SAMPLE_RATE        22050          // 22.05 kHz 够用，CPU 压力也小
 #define FRAMES_PER_BUFFER  256            // 每次写 256 帧
-#define NUM_STRINGS        3              // 每个和弦用 3 根“弦”
-#define MAX_KS_DELAY       512            // Karplus-Strong 最大延迟长度
 #define CHORD_DURATION_SEC 2.0f           // 每个和弦持续约 2 秒
 
-// ================== Karplus-Strong 拨弦模型 ==================
-struct KSString {
-  float buffer[MAX_KS_DELAY];
-  int   length;       // 使用的延迟长度
-  int   index;        // 当前写指针
-  float decay;        // 衰减系数（0.99 ~ 1.0）
-  bool  active;
+// ================== 合成引擎（GuitarEngine 库） ==================
+// 3 根“弦”，原始噪声激励、所有弦同时起音、直接相加 × 0.4
+struct KsConfig : ge::GuitarEngineDefaults {
+  static constexpr int   kStrings          = 3;
+  static constexpr int   kMaxDelay         = 512;
+  static constexpr int   kSampleRate       = 22050;   // 22.05 kHz 够用，CPU 压力也小
+  template <typename C>
+  using Voice = ge::KSStringRaw<C>;
+  static constexpr float kKsDecay          = 0.996f;  // 衰减略小于 1
+  static constexpr float kInterDelayMsSlow = 0.0f;
+  static constexpr float kInterDelayMsFast = 0.0f;
+  static constexpr bool  kMixAverage       = false;
+  static constexpr bool  kToneShaping      = false;
+  static constexpr float kOutputGain       = 0.4f;    // 混合后整体音量稍微压一下
 };
 
-KSString ksStrings[NUM_STRINGS];
+GuitarEngine<KsConfig> gEngine;
 
-// ========== 和弦定义（MIDI 音高）==========
-struct MidiChord {
-  const char* name;
-  const uint8_t* notes;
-  size_t count;
-};
+#define SAMPLE_RATE KsConfig::kSampleRate
 
+// ========== 和弦定义（MIDI 音高）==========
 const uint8_t CmajNotes[] = {60, 64, 67};  // C4 E4 G4
 const uint8_t GmajNotes[] = {55, 59, 62};  // G3 B3 D4
 const uint8_t AminNotes[] = {57, 60, 64};  // A3 C4 E4
 const uint8_t EminNotes[] = {52, 55, 59};  // E3 G3 B3
 
-MidiChord chords[] = {
-  { "C",  CmajNotes,  sizeof(CmajNotes)  / sizeof(uint8_t) },
-  { "G",  GmajNotes,  sizeof(GmajNotes)  / sizeof(uint8_t) },
-  { "Am", AminNotes,  sizeof(AminNotes)  / sizeof(uint8_t) },
-  { "Em", EminNotes,  sizeof(EminNotes)  / sizeof(uint8_t) },
+const ge::Chord chords[] = {
+  { "C",  CmajNotes,  sizeof(CmajNotes) },
+  { "G",  GmajNotes,  sizeof(GmajNotes) },
+  { "Am", AminNotes,  sizeof(AminNotes) },
+  { "Em", EminNotes,  sizeof(EminNotes) },
 };
 
 const int NUM_CHORDS = sizeof(chords) / sizeof(chords[0]);
@@ -52,103 +53,32 @@ int      currentChordIndex = 0;
 uint32_t samplesInChord    = 0;
 uint32_t samplesPerChord   = (uint32_t)(SAMPLE_RATE * CHORD_DURATION_SEC);
 
-// ================== 工具函数 ==================
-
-float midiToFreq(uint8_t midi) {
-  // 标准 440Hz：MIDI 69 = A4
-  return 440.0f * powf(2.0f, ( (int)midi - 69 ) / 12.0f);
-}
-
-// 初始化一根 Karplus-Strong 弦
-void initKSString(KSString &s, float freq, float decay) {
-  if (freq <= 0.0f) {
-    s.active = false;
-    return;
-  }
-  int len = (int)((float)SAMPLE_RATE / freq + 0.5f);
-  if (len < 2) len = 2;
-  if (len > MAX_KS_DELAY) len = MAX_KS_DELAY;
-
-  s.length = len;
-  s.index  = 0;
-  s.decay  = decay;
-  s.active = true;
-
-  // 用随机噪声初始化缓冲（拨弦瞬间）
-  for (int i = 0; i < len; ++i) {
-    int r = random(-32768, 32767);
-    s.buffer[i] = (float)r / 32768.0f;   // -1.0 ~ 1.0
-  }
-  // 多余的部分清零
-  for (int i = len; i < MAX_KS_DELAY; ++i) {
-    s.buffer[i] = 0.0f;
-  }
-}
-
-// 运行一拍 Karplus-Strong
-float processKSString(KSString &s) {
-  if (!s.active) return 0.0f;
-
-  int i0 = s.index;
-  int i1 = (s.index + 1);
-  if (i1 >= s.length) i1 = 0;
-
-  float y = 0.5f * (s.buffer[i0] + s.buffer[i1]);   // 简单平均
-  y *= s.decay;
-
-  s.buffer[i0] = y;
-  s.index = i1;
-
-  return y;
-}
-
 // 初始化当前和弦
 void initChord(int chordIndex) {
   if (chordIndex < 0 || chordIndex >= NUM_CHORDS) return;
 
-  MidiChord &ch = chords[chordIndex];
-  int stringsToUse = (int)min((size_t)NUM_STRINGS, ch.count);
-
-  for (int i = 0; i < stringsToUse; ++i) {
-    float freq = midiToFreq(ch.notes[i]);
-    initKSString(ksStrings[i], freq, 0.996f);  // 衰减略小于 1
-  }
-  // 多余的弦关掉
-  for (int i = stringsToUse; i < NUM_STRINGS; ++i) {
-    ksStrings[i].active = false;
-  }
-
+  gEngine.stopAll();
+  gEngine.strum(ge::STRUM_DOWN, chordIndex, 127);
   samplesInChord = 0;
 
   Serial.print("Now playing chord: ");
-  Serial.println(ch.name);
+  Serial.println(chords[chordIndex].name);
 }
 
-// 生成一个采样点
-float generateSample() {
-  if (samplesInChord >= samplesPerChord) {
-    // 切换到下一个和弦
-    currentChordIndex = (currentChordIndex + 1) % NUM_CHORDS;
-    initChord(currentChordIndex);
-  }
-  samplesInChord++;
-
-  float out = 0.0f;
-  for (int i = 0; i < NUM_STRINGS; ++i) {
-    if (ksStrings[i].active) {
-      out += processKSString(ksStrings[i]);
+// 生成一块采样：在换和弦的那个 sample 切开，和弦时长精确
+void generateBlock(float *out, int frames) {
+  int done = 0;
+  while (done < frames) {
+    if (samplesInChord >= samplesPerChord) {
+      // 切换到下一个和弦
+      currentChordIndex = (currentChordIndex + 1) % NUM_CHORDS;
+      initChord(currentChordIndex);
     }
+    int n = (int)min((uint32_t)(frames - done), samplesPerChord - samplesInChord);
+    gEngine.renderBlock(out + done, n);
+    samplesInChord += n;
+    done += n;
   }
-
-  // 混合后整体音量稍微压一下
-  const float masterGain = 0.4f;    // 可根据实际再调
-  out *= masterGain;
-
-  // 防止溢出
-  if (out > 1.0f)  out = 1.0f;
-  if (out < -1.0f) out = -1.0f;
-
-  return out;
 }
 
 // ================== I2S 初始化 ==================
@@ -189,6 +119,7 @@ void setupI2S() {
 }
 
 // ================== Arduino 入口 ==================
+static float   blockBuffer[FRAMES_PER_BUFFER];
 static int16_t i2sBuffer[FRAMES_PER_BUFFER * 2];  // *2 是左右声道
 
 void setup() {
@@ -197,22 +128,16 @@ void setup() {
   Serial.println("ESP32-S2 I2S Guitar-like Chord Test (Karplus-Strong)");
 
   // 随机种子（用于初始化弦的噪声）
-  randomSeed((uint32_t)esp_random());
+  gEngine.begin(chords, NUM_CHORDS, (uint32_t)esp_random());
 
   setupI2S();
   initChord(currentChordIndex);
 }
 
 void loop() {
-  // 每次填满一块 buffer，然后写到 I2S
-  for (int n = 0; n < FRAMES_PER_BUFFER; ++n) {
-    float s = generateSample();
-    int16_t v = (int16_t)(s * 32760.0f);   // 映射到 16bit
-
-    // 立体声：左右声道相同
-    i2sBuffer[2 * n]     = v;  // Left
-    i2sBuffer[2 * n + 1] = v;  // Right
-  }
+  // 填一块 buffer（左右声道相同）然后写到 I2S
+  generateBlock(blockBuffer, FRAMES_PER_BUFFER);
+  ge::toPcm16Stereo(blockBuffer, i2sBuffer, FRAMES_PER_BUFFER);
 
   size_t bytesWritten = 0;
   i2s_write(I2S_PORT,
@@ -221,4 +146,3 @@ void loop() {
             &bytesWritten,
             portMAX_DELAY);
 }
-
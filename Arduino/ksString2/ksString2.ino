@@ -1,6 +1,7 @@
 #include <Arduino.h>
 #include "driver/i2s.h"
 #include <math.h>
+#include <GuitarEngine.h>
 
 // ================== I2S 参数 ==================
 #define I2S_PORT   I2S_NUM_0
@@ -10,30 +11,30 @@
 #define I2S_LRCLK  17   // LRCLK -> MAX98357A LRC
 #define I2S_DOUT   14   // DATA  -> MAX98357A DIN
 
-#define SAMPLE_RATE        22050          // 22.05 kHz
 #define FRAMES_PER_BUFFER  256            // 每次写 256 帧
-#define NUM_STRINGS        3              // 每个和弦 3 根“弦”
-#define MAX_KS_DELAY       512            // Karplus-Strong 最大延迟长度
 #define CHORD_DURATION_SEC 0.9f           // 每个和弦大概 0.9 秒，更接近流行乐节奏
 
-// ================== Karplus-Strong 拨弦模型 ==================
-struct KSString {
-  float buffer[MAX_KS_DELAY];
-  int   length;       // 使用的延迟长度
-  int   index;        // 当前写指针
-  float decay;        // 衰减系数（0.99 ~ 1.0）
-  bool  active;
+// ================== 合成引擎（GuitarEngine 库） ==================
+// 3 根“弦”，原始噪声激励、所有弦同时起音、直接相加 × 0.4
+struct KsConfig : ge::GuitarEngineDefaults {
+  static constexpr int   kStrings          = 3;
+  static constexpr int   kMaxDelay         = 512;
+  static constexpr int   kSampleRate       = 22050;   // 22.05 kHz
+  template <typename C>
+  using Voice = ge::KSStringRaw<C>;
+  static constexpr float kKsDecay          = 0.996f;  // 衰减略小于 1
+  static constexpr float kInterDelayMsSlow = 0.0f;
+  static constexpr float kInterDelayMsFast = 0.0f;
+  static constexpr bool  kMixAverage       = false;
+  static constexpr bool  kToneShaping      = false;
+  static constexpr float kOutputGain       = 0.4f;    // 混音后整体音量
 };
 
-KSString ksStrings[NUM_STRINGS];
+GuitarEngine<KsConfig> gEngine;
 
-// ========== 和弦定义（MIDI 音高）==========
-struct MidiChord {
-  const char*   name;
-  const uint8_t* notes;
-  size_t        count;
-};
+#define SAMPLE_RATE KsConfig::kSampleRate
 
+// ========== 和弦定义（MIDI 音高）==========
 // 之前的和弦
 const uint8_t CmajNotes[] = {60, 64, 67};  // C4 E4 G4
 const uint8_t GmajNotes[] = {55, 59, 62};  // G3 B3 D4
@@ -54,13 +55,13 @@ enum {
   CHORD_Am = 5,
 };
 
-MidiChord chords[] = {
-  { "C",  CmajNotes,  sizeof(CmajNotes)  / sizeof(uint8_t) },  // 0
-  { "Dm", DminNotes,  sizeof(DminNotes)  / sizeof(uint8_t) },  // 1
-  { "Em", EminNotes,  sizeof(EminNotes)  / sizeof(uint8_t) },  // 2
-  { "F",  FmajNotes,  sizeof(FmajNotes)  / sizeof(uint8_t) },  // 3
-  { "G",  GmajNotes,  sizeof(GmajNotes)  / sizeof(uint8_t) },  // 4
-  { "Am", AminNotes,  sizeof(AminNotes)  / sizeof(uint8_t) },  // 5
+const ge::Chord chords[] = {
+  { "C",  CmajNotes,  sizeof(CmajNotes) },  // 0
+  { "Dm", DminNotes,  sizeof(DminNotes) },  // 1
+  { "Em", EminNotes,  sizeof(EminNotes) },  // 2
+  { "F",  FmajNotes,  sizeof(FmajNotes) },  // 3
+  { "G",  GmajNotes,  sizeof(GmajNotes) },  // 4
+  { "Am", AminNotes,  sizeof(AminNotes) },  // 5
 };
 
 const int NUM_CHORDS = sizeof(chords) / sizeof(chords[0]);
@@ -82,104 +83,33 @@ int      currentChordIndex = progression[0];    // 当前和弦索引
 uint32_t samplesInChord    = 0;
 uint32_t samplesPerChord   = (uint32_t)(SAMPLE_RATE * CHORD_DURATION_SEC);
 
-// ================== 工具函数 ==================
-
-float midiToFreq(uint8_t midi) {
-  // 标准 440Hz：MIDI 69 = A4
-  return 440.0f * powf(2.0f, ((int)midi - 69) / 12.0f);
-}
-
-// 初始化一根 Karplus-Strong 弦
-void initKSString(KSString &s, float freq, float decay) {
-  if (freq <= 0.0f) {
-    s.active = false;
-    return;
-  }
-  int len = (int)((float)SAMPLE_RATE / freq + 0.5f);
-  if (len < 2) len = 2;
-  if (len > MAX_KS_DELAY) len = MAX_KS_DELAY;
-
-  s.length = len;
-  s.index  = 0;
-  s.decay  = decay;
-  s.active = true;
-
-  // 用随机噪声初始化缓冲（拨弦瞬间）
-  for (int i = 0; i < len; ++i) {
-    int r = random(-32768, 32767);
-    s.buffer[i] = (float)r / 32768.0f;   // -1.0 ~ 1.0
-  }
-  // 多余部分清零
-  for (int i = len; i < MAX_KS_DELAY; ++i) {
-    s.buffer[i] = 0.0f;
-  }
-}
-
-// 运行一拍 Karplus-Strong
-float processKSString(KSString &s) {
-  if (!s.active) return 0.0f;
-
-  int i0 = s.index;
-  int i1 = (s.index + 1);
-  if (i1 >= s.length) i1 = 0;
-
-  float y = 0.5f * (s.buffer[i0] + s.buffer[i1]);   // 简单平均
-  y *= s.decay;
-
-  s.buffer[i0] = y;
-  s.index = i1;
-
-  return y;
-}
-
 // 初始化指定和弦
 void initChord(int chordIndex) {
   if (chordIndex < 0 || chordIndex >= NUM_CHORDS) return;
 
-  MidiChord &ch = chords[chordIndex];
-  int stringsToUse = (int)min((size_t)NUM_STRINGS, ch.count);
-
-  for (int i = 0; i < stringsToUse; ++i) {
-    float freq = midiToFreq(ch.notes[i]);
-    initKSString(ksStrings[i], freq, 0.996f);  // 衰减略小于 1
-  }
-  // 多余的弦关掉
-  for (int i = stringsToUse; i < NUM_STRINGS; ++i) {
-    ksStrings[i].active = false;
-  }
-
+  gEngine.stopAll();
+  gEngine.strum(ge::STRUM_DOWN, chordIndex, 127);
   samplesInChord = 0;
 
   Serial.print("Now playing chord: ");
-  Serial.println(ch.name);
+  Serial.println(chords[chordIndex].name);
 }
 
-// 生成一个采样点（按照 4-5-3-6-2-5-1 进行）
-float generateSample() {
-  if (samplesInChord >= samplesPerChord) {
-    samplesInChord = 0;
-    // 进行推进到下一个和弦
-    progPos = (progPos + 1) % PROG_LEN;
-    currentChordIndex = progression[progPos];
-    initChord(currentChordIndex);
-  }
-  samplesInChord++;
-
-  float out = 0.0f;
-  for (int i = 0; i < NUM_STRINGS; ++i) {
-    if (ksStrings[i].active) {
-      out += processKSString(ksStrings[i]);
+// 生成一块采样（按照 4-5-3-6-2-5-1 进行），在换和弦的那个 sample 切开
+void generateBlock(float *out, int frames) {
+  int done = 0;
+  while (done < frames) {
+    if (samplesInChord >= samplesPerChord) {
+      // 进行推进到下一个和弦
+      progPos = (progPos + 1) % PROG_LEN;
+      currentChordIndex = progression[progPos];
+      initChord(currentChordIndex);
     }
+    int n = (int)min((uint32_t)(frames - done), samplesPerChord - samplesInChord);
+    gEngine.renderBlock(out + done, n);
+    samplesInChord += n;
+    done += n;
   }
-
-  // 混音后整体音量
-  const float masterGain = 0.4f;
-  out *= masterGain;
-
-  if (out > 1.0f)  out = 1.0f;
-  if (out < -1.0f) out = -1.0f;
-
-  return out;
 }
 
 // ================== I2S 初始化 ==================
@@ -220,6 +150,7 @@ void setupI2S() {
 }
 
 // ================== Arduino 入口 ==================
+static float   blockBuffer[FRAMES_PER_BUFFER];
 static int16_t i2sBuffer[FRAMES_PER_BUFFER * 2];  // *2 是左右声道
 
 void setup() {
@@ -227,7 +158,7 @@ void setup() {
   delay(1000);
   Serial.println("ESP32-S2 I2S Guitar-like 4536251 Chord Progression");
 
-  randomSeed((uint32_t)esp_random());
+  gEngine.begin(chords, NUM_CHORDS, (uint32_t)esp_random());
 
   setupI2S();
 
@@ -238,15 +169,9 @@ void setup() {
 }
 
 void loop() {
-  // 填一块 buffer 然后写到 I2S
-  for (int n = 0; n < FRAMES_PER_BUFFER; ++n) {
-    float s = generateSample();
-    int16_t v = (int16_t)(s * 32760.0f);
-
-    // 立体声左右一致
-    i2sBuffer[2 * n]     = v;
-    i2sBuffer[2 * n + 1] = v;
-  }
+  // 填一块 buffer（立体声左右一致）然后写到 I2S
+  generateBlock(blockBuffer, FRAMES_PER_BUFFER);
+  ge::toPcm16Stereo(blockBuffer, i2sBuffer, FRAMES_PER_BUFFER);
 
   size_t bytesWritten = 0;
   i2s_write(I2S_PORT,
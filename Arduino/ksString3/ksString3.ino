@@ -1,6 +1,7 @@
 #include <Arduino.h>
 #include <ESP_I2S.h>
 #include <math.h>
+#include <GuitarEngine.h>
 
 // ================== I2S 引脚 ==================
 #define I2S_LRC   17
@@ -8,54 +9,49 @@
 #define I2S_DIN   14
 
 // ================== 合成 & 音色参数（集中调节区） ==================
-#define NUM_STRINGS        3          // 每个和弦用几根“虚拟弦”
-#define MAX_KS_DELAY       512        // Karplus-Strong 最大延迟长度
-
-// 基本音频
-const int   kSampleRate        = 16000;   // 采样率，16k 稳定且足够
-const float kPluckDurationSec  = 1.0f;    // 每次拨弦时长（秒）
-const int   kPlucksPerChord    = 2;       // 每个和弦拨几次（2 = 刷刷）
-
-// 包络（流行伴奏风格：起音快，尾巴中等）
-const float kAttackSec         = 0.015f;  // Attack 时间（秒），10–20ms
-const float kDecaySec          = 0.75f;   // Decay 时间（秒）
-
-// Karplus-Strong 衰减（越接近 1 越持久）
-const float kKsDecay           = 0.994f;  // 0.992–0.996 可微调
-
-// 拨弦噪声 RMS 目标（决定初始能量 & 整体响度）
-const float kNoiseTargetRms    = 0.23f;   // 0.20–0.27
-
-// 每根弦的 detune（cent），让和弦更宽一点
-const float kDetuneCents[NUM_STRINGS] = { -3.0f, 0.0f, 3.0f };
-
-// Tone shaping：频响和箱体感
-const float kLpToneAlpha       = 0.24f;   // 高频低通强度：0.2 偏暖，0.3 偏亮
-const float kPresenceMix       = 0.28f;   // 存在感（拨弦清脆度）0~0.4
-const float kBodyAlpha         = 0.02f;   // 箱体共鸣低频滤波速度
-const float kBodyMix           = 0.25f;   // 箱体占比 0~0.4
-
-// 总体增益
-const float kOutputGain        = 1.3f;    // 1.1–1.4，根据喇叭和耳朵来调
-
-// ================== Karplus-Strong 结构体 ==================
-struct KSString {
-  float buffer[MAX_KS_DELAY];
-  int   length;
-  int   index;
-  float decay;
-  bool  active;
+// 都是 GuitarEngine 的编译期参数：3 根“虚拟弦”，每次拨弦所有弦同时起音
+struct KsConfig : ge::GuitarEngineDefaults {
+  static constexpr int   kStrings     = 3;       // 每个和弦用几根“虚拟弦”
+  static constexpr int   kMaxDelay    = 512;     // Karplus-Strong 最大延迟长度
+  static constexpr int   kSampleRate  = 16000;   // 采样率，16k 稳定且足够
+
+  // Karplus-Strong 衰减（越接近 1 越持久）
+  static constexpr float kKsDecay     = 0.994f;  // 0.992–0.996 可微调
+
+  // 拨弦噪声 RMS 目标（决定初始能量 & 整体响度），不随力度变
+  static constexpr float kBaseNoiseTargetRms = 0.23f;   // 0.20–0.27
+  static constexpr float kVelRmsScaleMin     = 1.0f;
+  static constexpr float kVelRmsScaleMax     = 1.0f;
+  static constexpr float kInterDelayMsSlow   = 0.0f;
+  static constexpr float kInterDelayMsFast   = 0.0f;
+
+  // 每根弦的 detune（cent），让和弦更宽一点
+  static constexpr float kDetuneCents[kStrings] = { -3.0f, 0.0f, 3.0f };
+
+  // 包络（流行伴奏风格：起音快，尾巴中等）
+  static constexpr bool  kPluckEnvelope = true;
+  static constexpr float kAttackSec     = 0.015f;  // Attack 时间（秒），10–20ms
+  static constexpr float kDecaySec      = 0.75f;   // Decay 时间（秒）
+  static constexpr float kPluckSec      = 1.0f;    // 每次拨弦时长（秒）
+
+  // Tone shaping：频响和箱体感
+  static constexpr float kLpToneAlpha   = 0.24f;   // 高频低通强度：0.2 偏暖，0.3 偏亮
+  static constexpr float kPresenceMix   = 0.28f;   // 存在感（拨弦清脆度）0~0.4
+  static constexpr float kBodyAlpha     = 0.02f;   // 箱体共鸣低频滤波速度
+  static constexpr float kBodyMix       = 0.25f;   // 箱体占比 0~0.4
+
+  // 总体增益
+  static constexpr float kOutputGain    = 1.3f;    // 1.1–1.4，根据喇叭和耳朵来调
 };
 
-KSString ksStrings[NUM_STRINGS];
+GuitarEngine<KsConfig> gEngine;
 
-// ================== 和声配置（C 调 4536251） ==================
-struct MidiChord {
-  const char*   name;
-  const uint8_t* notes;
-  size_t        count;
-};
+const int   kSampleRate       = KsConfig::kSampleRate;
+const float kPluckDurationSec = KsConfig::kPluckSec;
+const int   kPlucksPerChord   = 2;       // 每个和弦拨几次（2 = 刷刷）
+const int   kBlockFrames      = 64;      // 每次渲染 / 写 I2S 的帧数
 
+// ================== 和声配置（C 调 4536251） ==================
 // C 大调常用和弦
 const uint8_t CmajNotes[] = {60, 64, 67};  // C4 E4 G4
 const uint8_t GmajNotes[] = {55, 59, 62};  // G3 B3 D4
@@ -73,13 +69,13 @@ enum {
   CHORD_Am = 5,
 };
 
-MidiChord chords[] = {
-  { "C",  CmajNotes,  sizeof(CmajNotes)  / sizeof(uint8_t) },  // 0
-  { "Dm", DminNotes,  sizeof(DminNotes)  / sizeof(uint8_t) },  // 1
-  { "Em", EminNotes,  sizeof(EminNotes)  / sizeof(uint8_t) },  // 2
-  { "F",  FmajNotes,  sizeof(FmajNotes)  / sizeof(uint8_t) },  // 3
-  { "G",  GmajNotes,  sizeof(GmajNotes)  / sizeof(uint8_t) },  // 4
-  { "Am", AminNotes,  sizeof(AminNotes)  / sizeof(uint8_t) },  // 5
+const ge::Chord chords[] = {
+  { "C",  CmajNotes,  sizeof(CmajNotes) },  // 0
+  { "Dm", DminNotes,  sizeof(DminNotes) },  // 1
+  { "Em", EminNotes,  sizeof(EminNotes) },  // 2
+  { "F",  FmajNotes,  sizeof(FmajNotes) },  // 3
+  { "G",  GmajNotes,  sizeof(GmajNotes) },  // 4
+  { "Am", AminNotes,  sizeof(AminNotes) },  // 5
 };
 
 const int NUM_CHORDS = sizeof(chords) / sizeof(chords[0]);
@@ -107,109 +103,14 @@ struct SynthState {
 
 SynthState synth;
 
-// Tone shaping 状态（滤波器记忆）
-struct ToneState {
-  float lpTone;
-  float lpBody;
-};
-
-// ⚠️ 这里改名，避免和 Arduino 的 tone() 冲突
-ToneState toneState;
-
 // ================== I2S 实例 ==================
 I2SClass i2s;
 
-// ================== 工具函数 ==================
-float midiToFreq(uint8_t midi) {
-  return 440.0f * powf(2.0f, ((int)midi - 69) / 12.0f);
-}
-
-// ---- 初始化一根 KS 弦：平滑噪声 + RMS 归一化 ----
-void initKSString(KSString &s, float freq, float decay) {
-  if (freq <= 0.0f) {
-    s.active = false;
-    return;
-  }
-  int len = (int)((float)kSampleRate / freq + 0.5f);
-  if (len < 2) len = 2;
-  if (len > MAX_KS_DELAY) len = MAX_KS_DELAY;
-
-  s.length = len;
-  s.index  = 0;
-  s.decay  = decay;
-  s.active = true;
-
-  float prev  = 0.0f;
-  float sumSq = 0.0f;
-
-  for (int i = 0; i < len; ++i) {
-    int   r   = random(-32768, 32767);
-    float val = (float)r / 32768.0f;     // -1 ~ 1
-
-    // 平滑一点，让起音更木、少毛刺
-    val = 0.4f * val + 0.6f * prev;
-    prev = val;
-
-    s.buffer[i] = val;
-    sumSq += val * val;
-  }
-
-  for (int i = len; i < MAX_KS_DELAY; ++i) {
-    s.buffer[i] = 0.0f;
-  }
-
-  // RMS 归一化，让每次 pluck 能量一致
-  if (sumSq > 1e-6f) {
-    float rms = sqrtf(sumSq / (float)len);
-    float scale = kNoiseTargetRms / rms;
-    for (int i = 0; i < len; ++i) {
-      s.buffer[i] *= scale;
-    }
-  }
-}
-
-float processKSString(KSString &s) {
-  if (!s.active) return 0.0f;
-
-  int i0 = s.index;
-  int i1 = (s.index + 1);
-  if (i1 >= s.length) i1 = 0;
-
-  float y = 0.5f * (s.buffer[i0] + s.buffer[i1]);
-  y *= s.decay;
-
-  s.buffer[i0] = y;
-  s.index = i1;
-
-  return y;
-}
-
-// ---- 初始化当前和弦的所有弦 ----
-void initChordStrings(int chordIndex) {
-  if (chordIndex < 0 || chordIndex >= NUM_CHORDS) return;
-
-  MidiChord &ch = chords[chordIndex];
-  int stringsToUse = (int)min((size_t)NUM_STRINGS, ch.count);
-
-  for (int i = 0; i < stringsToUse; ++i) {
-    float freq = midiToFreq(ch.notes[i]);
-
-    // 轻微 detune，拉宽一点
-    float detune_cents = kDetuneCents[i];
-    float detune = powf(2.0f, detune_cents / 1200.0f);
-    freq *= detune;
-
-    initKSString(ksStrings[i], freq, kKsDecay);
-  }
-  for (int i = stringsToUse; i < NUM_STRINGS; ++i) {
-    ksStrings[i].active = false;
-  }
-}
-
 void triggerPluckForChord(int chordIndex, bool printName) {
   synth.currentChordIndex  = chordIndex;
   synth.samplesInPluck     = 0;
-  initChordStrings(chordIndex);
+  gEngine.stopAll();
+  gEngine.strum(ge::STRUM_DOWN, chordIndex, 127);
 
   if (printName) {
     Serial.print("Chord: ");
@@ -238,57 +139,18 @@ void updateChordAndPluck() {
   }
 }
 
-// ---- 合成当前采样：KS 和弦 + 包络 + EQ/Tone ----
-float renderSample() {
-  // 先更新 pluck 状态
-  updateChordAndPluck();
-  synth.samplesInPluck++;
-
-  // 1) Karplus-Strong 混合
-  float out = 0.0f;
-  int activeCount = 0;
-  for (int i = 0; i < NUM_STRINGS; ++i) {
-    if (ksStrings[i].active) {
-      out += processKSString(ksStrings[i]);
-      activeCount++;
-    }
-  }
-  if (activeCount > 0) {
-    out /= (float)activeCount;
-  }
-
-  // 2) 包络：Attack + Decay
-  float t = (float)synth.samplesInPluck / (float)kSampleRate;
-  float env;
-  if (t < kAttackSec) {
-    env = t / kAttackSec;
-  } else if (t < kPluckDurationSec) {
-    float dt = t - kAttackSec;
-    env = expf(-dt / kDecaySec);
-  } else {
-    env = 0.0f;
+// ---- 合成一块：在下一次拨弦的那个 sample 切开（包络 / EQ/Tone 在引擎里）----
+void renderBlock(float *out, int frames) {
+  int done = 0;
+  while (done < frames) {
+    updateChordAndPluck();
+    int n = frames - done;
+    uint32_t left = synth.samplesPerPluck - synth.samplesInPluck;
+    if ((uint32_t)n > left) n = (int)left;
+    gEngine.renderBlock(out + done, n);
+    synth.samplesInPluck += n;
+    done += n;
   }
-  out *= env;
-
-  // 3) Tone shaping：存在感 + 箱体
-
-  // 3.1 高频/中频分离：低通 LP_tone 得到“整体”，out-LP_tone 是 presence
-  toneState.lpTone += kLpToneAlpha * (out - toneState.lpTone);
-  float presence = out - toneState.lpTone;
-  float shaped = (1.0f - kPresenceMix) * out + kPresenceMix * presence;
-
-  // 3.2 箱体共鸣（低频缓慢响应）
-  toneState.lpBody += kBodyAlpha * (shaped - toneState.lpBody);
-  shaped = (1.0f - kBodyMix) * shaped + kBodyMix * toneState.lpBody;
-
-  // 4) 总体增益
-  shaped *= kOutputGain;
-
-  // 简单限幅避免极端溢出
-  if (shaped > 1.0f)  shaped = 1.0f;
-  if (shaped < -1.0f) shaped = -1.0f;
-
-  return shaped;
 }
 
 // ================== Arduino 入口 ==================
@@ -298,7 +160,7 @@ void setup() {
   delay(1000);
   Serial.println("ESP32-S2 + ESP_I2S  Guitar 4536251 (Pop backing, tunable)");
 
-  randomSeed((uint32_t)millis());
+  gEngine.begin(chords, NUM_CHORDS, (uint32_t)millis());
 
   // 初始化合成状态
   synth.progressionPos     = 0;
@@ -307,9 +169,6 @@ void setup() {
   synth.samplesPerPluck    = (uint32_t)(kSampleRate * kPluckDurationSec);
   synth.pluckCountForChord = 0;
 
-  toneState.lpTone = 0.0f;
-  toneState.lpBody = 0.0f;
-
   // 配置 I2S（跟官方 example 一样的模式，只换了采样率）
   i2s_data_bit_width_t bps  = I2S_DATA_BIT_WIDTH_16BIT;
   i2s_mode_t           mode = I2S_MODE_STD;
@@ -326,18 +185,12 @@ void setup() {
   triggerPluckForChord(synth.currentChordIndex, true);
 }
 
+static float   blockBuffer[kBlockFrames];
+static int16_t i2sBuffer[kBlockFrames * 2];   // 左右声道相同
+
 void loop() {
-  // 像官方示例一样，一次写一个 sample（左右声道相同）
-  float s = renderSample();
-  int16_t v = (int16_t)(s * 32760.0f);
-
-  uint8_t lo = v & 0xFF;
-  uint8_t hi = (v >> 8) & 0xFF;
-
-  // Left
-  i2s.write(lo);
-  i2s.write(hi);
-  // Right
-  i2s.write(lo);
-  i2s.write(hi);
+  // 一次渲染一块，整块写给 I2S（以前一次写一个字节，每 sample 四次调用）
+  renderBlock(blockBuffer, kBlockFrames);
+  ge::toPcm16Stereo(blockBuffer, i2sBuffer, kBlockFrames);
+  i2s.write((uint8_t *)i2sBuffer, sizeof(i2sBuffer));
 }
@@ -0,0 +1,175 @@
+//
+// host_soak.cpp
+// ==============================
+// 在电脑上跑 GuitarEngine 的长时间测试：随机扫弦 / 切音 / 改音量 / 长时间不弹，
+// 模拟几个小时的演奏，每模拟一分钟报告一次每块渲染时间、NaN / 非正规数。
+// 和 esp32_guitar_engine 的 soak 命令同样的事件分布。
+//
+// 同一个引擎编两份：kSilenceFloor / kStateFlushFloor 打开（正常配置）和关掉，
+// 关掉的那份尾音会衰减进非正规数，x86 上能直接看到每块时间变长。
+//
+// 编译 / 运行（不需要 Arduino）：
+//   g++ -std=c++17 -O2 -I../../src host_soak.cpp -o host_soak
+//   ./host_soak [minutes=60] [seed=1]
+//
+// 退出码：有 NaN / Inf 时为 1
+//
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include "GuitarEngine.h"
+
+namespace {
+
+struct SoakConfig : ge::GuitarEngineDefaults {
+  static constexpr int   kStrings       = 6;
+  static constexpr int   kSampleRate    = 16000;
+  static constexpr float kDetuneCents[kStrings] = { -3.0f, -1.0f, 0.0f, 0.0f, 1.0f, 3.0f };
+};
+
+struct NoFloorConfig : SoakConfig {
+  static constexpr float kSilenceFloor    = 0.0f;
+  static constexpr float kStateFlushFloor = 0.0f;
+};
+
+constexpr int kBlockFrames   = 64;
+constexpr int kReportSec     = 60;
+constexpr int kGapMsMin      = 60;
+constexpr int kGapMsMax      = 1500;
+constexpr int kChokePct      = 6;
+constexpr int kVolumePct     = 6;
+constexpr int kRestPct       = 1;
+constexpr int kRestSecMin    = 60;
+constexpr int kRestSecMax    = 150;
+
+// 六弦开放和弦（低 → 高）
+const uint8_t kC[]  = { 48, 52, 55, 60, 64 };
+const uint8_t kG[]  = { 43, 47, 50, 55, 59, 67 };
+const uint8_t kAm[] = { 45, 52, 57, 60, 64 };
+const uint8_t kEm[] = { 40, 47, 52, 55, 59, 64 };
+const uint8_t kF[]  = { 41, 48, 53, 57, 60, 65 };
+const uint8_t kDm[] = { 50, 57, 62, 65 };
+
+const ge::Chord kChords[] = {
+  { "C",  kC,  sizeof(kC)  }, { "G",  kG,  sizeof(kG)  }, { "Am", kAm, sizeof(kAm) },
+  { "Em", kEm, sizeof(kEm) }, { "F",  kF,  sizeof(kF)  }, { "Dm", kDm, sizeof(kDm) },
+};
+constexpr int kNumChords = sizeof(kChords) / sizeof(kChords[0]);
+
+struct SoakResult {
+  double          worstUs   = 0.0;
+  double          totalUs   = 0.0;
+  long            blocks    = 0;
+  ge::StateScan   out;
+  ge::StateScan   state;
+};
+
+uint32_t randBelow(ge::Noise &g, uint32_t n) {
+  return g.next() % n;
+}
+
+template <typename Config>
+SoakResult runSoak(const char *label, double minutes, uint32_t seed) {
+  static GuitarEngine<Config> engine;   // 六根 512 点延迟线，放静态区
+  using Clock = std::chrono::steady_clock;
+
+  const long   totalBlocks  = (long)(minutes * 60.0 * Config::kSampleRate) / kBlockFrames;
+  const long   reportBlocks = (long)kReportSec * Config::kSampleRate / kBlockFrames;
+  const double budgetUs     = 1e6 * kBlockFrames / Config::kSampleRate;
+
+  engine.begin(kChords, kNumChords, seed);
+  ge::Noise rng;
+  rng.seed(seed);
+
+  std::printf("[%s] %.1f min simulated @ %d Hz, engine %zu B static\n",
+              label, minutes, Config::kSampleRate, sizeof(engine));
+  std::printf("     time  avg us  max us  load max   voices   out nan den   state nan den\n");
+
+  SoakResult res;
+  float      block[kBlockFrames];
+  uint64_t   nextEvent = 0;
+  double     winUs = 0.0, winMax = 0.0;
+  long       winVoices = 0;
+  ge::StateScan winOut;
+
+  for (long b = 0; b < totalBlocks; ++b) {
+    uint64_t now = (uint64_t)b * kBlockFrames;
+    while (nextEvent <= now) {
+      uint32_t gapMs = kGapMsMin + randBelow(rng, kGapMsMax - kGapMsMin + 1);
+      uint32_t r     = randBelow(rng, 100);
+      if (r < kChokePct) {
+        engine.choke();
+      } else if ((r -= kChokePct) < kVolumePct) {
+        engine.setVolume(0.2f + 0.8f * (float)randBelow(rng, 101) / 100.0f);
+      } else if ((r -= kVolumePct) < kRestPct) {
+        gapMs = 1000u * (kRestSecMin + randBelow(rng, kRestSecMax - kRestSecMin + 1));
+      } else {
+        engine.strum(randBelow(rng, 2) ? ge::STRUM_UP : ge::STRUM_DOWN,
+                     (int)randBelow(rng, kNumChords), 20 + (int)randBelow(rng, 108));
+      }
+      nextEvent += (uint64_t)gapMs * Config::kSampleRate / 1000u;
+    }
+
+    auto   t0 = Clock::now();
+    engine.renderBlock(block, kBlockFrames);
+    double us = std::chrono::duration<double, std::micro>(Clock::now() - t0).count();
+
+    winUs += us;
+    if (us > winMax) winMax = us;
+    if (us > res.worstUs) res.worstUs = us;
+    winVoices += engine.activeVoices();
+    for (int i = 0; i < kBlockFrames; ++i) ge::classify(block[i], winOut);
+
+    long done = b + 1;
+    if (done % reportBlocks == 0 || done == totalBlocks) {
+      long n = (done % reportBlocks) ? done % reportBlocks : reportBlocks;
+      ge::StateScan st;
+      engine.scanState(st);
+      long sec = done * kBlockFrames / Config::kSampleRate;
+      std::printf("  %4ld:%02ld  %6.2f  %6.1f  %7.2f%%   %6.2f   %7d %4d   %9d %4d\n",
+                  sec / 60, sec % 60, winUs / n, winMax, 100.0 * winMax / budgetUs,
+                  (double)winVoices / n, winOut.nonFinite, winOut.denormal,
+                  st.nonFinite, st.denormal);
+      res.totalUs         += winUs;
+      res.out.nonFinite   += winOut.nonFinite;
+      res.out.denormal    += winOut.denormal;
+      res.state.nonFinite += st.nonFinite;
+      res.state.denormal  += st.denormal;
+      winUs = winMax = 0.0;
+      winVoices = 0;
+      winOut    = ge::StateScan();
+    }
+  }
+  res.blocks = totalBlocks;
+  return res;
+}
+
+void printSummary(const char *label, const SoakResult &r) {
+  std::printf("  %-9s avg %.2f us/block, worst %.1f us, nan/inf %d + %d, denormal %d + %d "
+              "(output + state)\n",
+              label, r.blocks ? r.totalUs / r.blocks : 0.0, r.worstUs,
+              r.out.nonFinite, r.state.nonFinite, r.out.denormal, r.state.denormal);
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+  double   minutes = (argc > 1) ? std::atof(argv[1]) : 60.0;
+  uint32_t seed    = (argc > 2) ? (uint32_t)std::strtoul(argv[2], nullptr, 0) : 1u;
+  if (minutes <= 0.0) {
+    std::fprintf(stderr, "usage: %s [minutes] [seed]\n", argv[0]);
+    return 2;
+  }
+
+  SoakResult floor   = runSoak<SoakConfig>("floor", minutes, seed);
+  SoakResult noFloor = runSoak<NoFloorConfig>("no floor", minutes, seed);
+
+  std::printf("[Soak] summary\n");
+  printSummary("floor", floor);
+  printSummary("no floor", noFloor);
+
+  bool fail = floor.out.nonFinite || floor.state.nonFinite;
+  std::printf("[Soak] %s\n", fail ? "FAIL" : "PASS");
+  return fail ? 1 : 0;
+}
@@ -0,0 +1,405 @@
+#pragma once
+//
+// GuitarEngine.h
+// ==============================
+// 只有头文件的 Karplus–Strong 吉他引擎：GuitarEngine<Config>。
+// 以前 KSS_Wrap_1 / ksString1~3 / guitar_controller2 各自复制了一份
+// KS 弦 + 和弦 + 扫弦调度，这里合成一份，差别都放进 Config。
+//
+//  - 弦数、最大延迟、采样率、voice 类型都是编译期常量：
+//    每弦循环的次数固定（编译器可以展开），延迟线按 kMaxDelay 精确分配
+//  - 没有动态内存、不依赖 Arduino.h：ESP32 上和主机上（extras/host_soak）编译同一份
+//  - 渲染是单声道 float 块，sketch 自己决定怎么送 I2S（toPcm16Stereo() 是常用的一种）
+//
+// 用法：
+//
+//   struct MyConfig : ge::GuitarEngineDefaults {
+//     static constexpr int kStrings    = 3;
+//     static constexpr int kSampleRate = 16000;
+//     static constexpr float kDetuneCents[kStrings] = { -3.0f, 0.0f, 3.0f };
+//   };
+//   GuitarEngine<MyConfig> gEngine;
+//
+//   gEngine.begin(chords, numChords, seed);
+//   gEngine.strum(ge::STRUM_DOWN, chordIndex, velocity);   // 按力度错开各弦
+//   gEngine.choke();                                       // 停掉所有弦 + 短噪声“啪”
+//   gEngine.setVolume(0.8f);                               // 主音量 0..1，按块平滑
+//   gEngine.renderBlock(buf, frames);
+//
+// esp32_guitar_engine 的采样率可以在运行时切换（rate 命令），还有立体声总线、
+// 琴箱卷积和效果器，所以仍用自己的渲染链（ks_voice.h 的 KSVoice<Features...>）。
+//
+
+#include <math.h>
+#include <stdint.h>
+#include "ge_noise.h"
+#include "ge_ks_string.h"
+
+namespace ge {
+
+struct Chord {
+  const char    *name;
+  const uint8_t *notes;   // MIDI 音高，低 → 高，第 i 个音给第 i 根弦
+  uint8_t        count;
+};
+
+enum StrumDirection {
+  STRUM_DOWN = 0,   // 低音 → 高音
+  STRUM_UP   = 1    // 高音 → 低音
+};
+
+// 每个参数的默认值（= KSS_Wrap_1 / guitar_controller2 的音色）。
+// sketch 继承它，只覆盖要改的
+struct GuitarEngineDefaults {
+  static constexpr int kStrings    = 6;
+  static constexpr int kMaxDelay   = 512;      // 最低音 = kSampleRate / kMaxDelay
+  static constexpr int kSampleRate = 16000;
+
+  // voice 类型：用最终的 Config 实例化，覆盖 kMaxDelay / kSampleRate 也能跟着变
+  template <typename C>
+  using Voice = KSString<C>;
+
+  // KS 衰减（越接近 1，尾巴越长）
+  static constexpr float kKsDecay = 0.994f;
+
+  // 扫弦：弦间延时，力度小 → Slow，力度大 → Fast（都是 0 = 所有弦同时起音）
+  static constexpr float kInterDelayMsSlow = 20.0f;
+  static constexpr float kInterDelayMsFast = 4.0f;
+
+  // 激励 RMS：kBaseNoiseTargetRms × (Min..Max 按力度)
+  static constexpr float kBaseNoiseTargetRms = 0.20f;
+  static constexpr float kVelRmsScaleMin     = 0.5f;
+  static constexpr float kVelRmsScaleMax     = 1.4f;
+
+  // 每根弦的 detune（cent）；比 kStrings 短的部分按 0
+  static constexpr float kDetuneCents[1] = { 0.0f };
+
+  // 混音：true = 除以发声弦数，false = 直接相加
+  static constexpr bool kMixAverage = true;
+
+  // Tone shaping：presence + 箱体低频（一阶低通系数，按 kSampleRate 调好的值）
+  static constexpr bool  kToneShaping = true;
+  static constexpr float kLpToneAlpha = 0.24f;
+  static constexpr float kPresenceMix = 0.25f;
+  static constexpr float kBodyAlpha   = 0.02f;
+  static constexpr float kBodyMix     = 0.25f;
+
+  // 每次扫弦的 attack / decay 包络（ksString3），kPluckSec 之后静音
+  static constexpr bool  kPluckEnvelope = false;
+  static constexpr float kAttackSec     = 0.015f;
+  static constexpr float kDecaySec      = 0.75f;
+  static constexpr float kPluckSec      = 1.0f;
+
+  // 总增益（再乘 setVolume() 的主音量），之后硬限幅到 ±1
+  static constexpr float kOutputGain      = 1.3f;
+  static constexpr float kVolumeSmoothMs  = 15.0f;
+
+  // 切音“啪”：噪声长度 / 幅度 / 包络时间常数（kChokeMs = 0 只停弦）
+  static constexpr float kChokeMs     = 20.0f;
+  static constexpr float kChokeAmp    = 0.9f;
+  static constexpr float kChokeTauMs  = 0.593f;
+
+  // 一根弦整圈低于 kSilenceFloor 就停（约 -100 dBFS）；递归滤波状态低于 kStateFlushFloor 置零
+  static constexpr float kSilenceFloor    = 1e-5f;
+  static constexpr float kStateFlushFloor = 1e-15f;
+};
+
+// scanState() 的结果
+struct StateScan {
+  int nonFinite = 0;   // NaN / Inf
+  int denormal  = 0;
+};
+
+inline void classify(float x, StateScan &scan) {
+  if (!isfinite(x)) {
+    scan.nonFinite++;
+  } else if (x != 0.0f && fabsf(x) < 1.17549435e-38f) {
+    scan.denormal++;
+  }
+}
+
+inline float midiToFreq(uint8_t midi) {
+  return 440.0f * powf(2.0f, ((int)midi - 69) / 12.0f);
+}
+
+// float 单声道 → 16-bit 立体声交错（左右相同），I2S 常用格式
+inline void toPcm16Stereo(const float *in, int16_t *out, int frames) {
+  for (int i = 0; i < frames; ++i) {
+    int16_t v      = (int16_t)(in[i] * 32760.0f);
+    out[2 * i]     = v;
+    out[2 * i + 1] = v;
+  }
+}
+
+}  // namespace ge
+
+template <typename Config>
+class GuitarEngine {
+ public:
+  using Voice = typename Config::template Voice<Config>;
+
+  static constexpr int kStrings     = Config::kStrings;
+  static constexpr int kMaxDelay    = Config::kMaxDelay;
+  static constexpr int kSampleRate  = Config::kSampleRate;
+  static constexpr int kMaxPlucks   = kStrings * 4;   // 允许同时排队的 pluck 数
+
+  static_assert(kStrings > 0, "GuitarEngine needs at least one string");
+  static_assert(kMaxDelay >= 2, "kMaxDelay too small");
+  static_assert(kSampleRate > 0, "bad kSampleRate");
+
+  // 和弦表由 sketch 提供（静态存储，引擎只存指针）
+  void begin(const ge::Chord *chords, int numChords, uint32_t seed = 1) {
+    chords_    = chords;
+    numChords_ = numChords;
+    noise_.seed(seed);
+    stopAll();
+    sampleCounter_ = 0;
+    volume_        = 1.0f;
+    gain_          = Config::kOutputGain;
+
+    constexpr int kDetuneCount = sizeof(Config::kDetuneCents) / sizeof(float);
+    for (int i = 0; i < kStrings; ++i) {
+      float cents = (i < kDetuneCount) ? Config::kDetuneCents[i] : 0.0f;
+      detune_[i]  = powf(2.0f, cents / 1200.0f);
+    }
+    chokeDecay_ = expf(-1000.0f / (Config::kChokeTauMs * (float)kSampleRate));
+  }
+
+  // 避免完全 0，顺手做个稍微平滑一点的力度映射（velocity 0..127 → 0.1..1）
+  static float strumVelocityNorm(int velocity) {
+    if (velocity < 0)   velocity = 0;
+    if (velocity > 127) velocity = 127;
+    return 0.1f + 0.9f * (float)velocity / 127.0f;
+  }
+
+  // 这个力度的弦间延时（ms），力度越大越短；sketch 打印扫弦日志用
+  static float strumInterDelayMs(int velocity) {
+    float interDelayMs = Config::kInterDelayMsSlow
+                         - strumVelocityNorm(velocity)
+                           * (Config::kInterDelayMsSlow - Config::kInterDelayMsFast);
+    if (interDelayMs < Config::kInterDelayMsFast) interDelayMs = Config::kInterDelayMsFast;
+    return interDelayMs;
+  }
+
+  // 安排一次扫弦：力度越大弦间延时越短，各弦在块内按 sample 精确起音
+  void strum(ge::StrumDirection dir, int chordIndex, int velocity) {
+    if (chords_ == nullptr || chordIndex < 0 || chordIndex >= numChords_) return;
+
+    float vNorm        = strumVelocityNorm(velocity);
+    float interDelayMs = strumInterDelayMs(velocity);
+
+    const ge::Chord &ch = chords_[chordIndex];
+    int stringsToUse = (ch.count < kStrings) ? (int)ch.count : kStrings;
+
+    for (int k = 0; k < stringsToUse; ++k) {
+      int s = (dir == ge::STRUM_DOWN) ? k : (stringsToUse - 1 - k);
+      uint32_t offset = (uint32_t)(interDelayMs * (float)k * 0.001f * (float)kSampleRate);
+      schedule(sampleCounter_ + offset, chordIndex, s, vNorm);
+    }
+    if constexpr (Config::kPluckEnvelope) {
+      envSamples_ = 0;
+    }
+  }
+
+  // 切音：停掉所有弦和排队的 pluck，开一个短噪声包络
+  void choke() {
+    stopAll();
+    if constexpr (Config::kChokeMs > 0.0f) {
+      chokeLeft_ = (int)(Config::kChokeMs * 0.001f * (float)kSampleRate);
+      chokeEnv_  = 1.0f;
+    }
+  }
+
+  // 主音量 0..1，在 renderBlock() 里按块平滑
+  void setVolume(float volume) {
+    volume_ = (volume < 0.0f) ? 0.0f : (volume > 1.0f ? 1.0f : volume);
+  }
+
+  void stopAll() {
+    for (int i = 0; i < kStrings; ++i) voices_[i].active = false;
+    for (int i = 0; i < kMaxPlucks; ++i) plucks_[i].active = false;
+    chokeLeft_ = 0;
+  }
+
+  // 渲染 frames 个 sample：在 pluck 触发点切开，起音 sample 精确
+  void renderBlock(float *out, int frames) {
+    float g0 = gain_;
+    float g1 = g0 + volumeAlpha(frames) * (Config::kOutputGain * volume_ - g0);
+    gain_    = g1;
+    float dg = (g1 - g0) / (float)frames;
+
+    int done = 0;
+    while (done < frames) {
+      startDuePlucks();
+      int n = samplesUntilNextPluck(frames - done);
+      for (int i = 0; i < n; ++i) {
+        sampleCounter_++;
+        float y = (shape(mix()) + chokeNoise()) * (g0 + dg * (float)(done + i + 1));
+        out[done + i] = (y > 1.0f) ? 1.0f : (y < -1.0f ? -1.0f : y);
+      }
+      done += n;
+    }
+
+    if constexpr (Config::kToneShaping) {
+      if (fabsf(tone_.lpTone) < Config::kStateFlushFloor) tone_.lpTone = 0.0f;
+      if (fabsf(tone_.lpBody) < Config::kStateFlushFloor) tone_.lpBody = 0.0f;
+    }
+  }
+
+  int activeVoices() const {
+    int n = 0;
+    for (int i = 0; i < kStrings; ++i) n += voices_[i].active ? 1 : 0;
+    return n;
+  }
+
+  // 正在响的弦 + 音色滤波状态里有多少 NaN / Inf / 非正规数（测试用，不在渲染路径上）
+  void scanState(ge::StateScan &scan) const {
+    scan = ge::StateScan();
+    for (int i = 0; i < kStrings; ++i) {
+      voices_[i].forEachState([&scan](float x) { ge::classify(x, scan); });
+    }
+    ge::classify(tone_.lpTone, scan);
+    ge::classify(tone_.lpBody, scan);
+  }
+
+  uint32_t         sampleCount() const { return sampleCounter_; }
+  int              numChords() const   { return numChords_; }
+  const ge::Chord &chord(int i) const  { return chords_[i]; }
+  const Voice     &voice(int i) const  { return voices_[i]; }
+
+ private:
+  struct ScheduledPluck {
+    bool     active;
+    uint32_t triggerSample;
+    int      chordIndex;
+    int      stringIndex;
+    float    velocityNorm;
+  };
+
+  struct ToneState {
+    float lpTone = 0.0f;
+    float lpBody = 0.0f;
+  };
+
+  void schedule(uint32_t at, int chordIndex, int stringIndex, float vNorm) {
+    for (int i = 0; i < kMaxPlucks; ++i) {
+      ScheduledPluck &sp = plucks_[i];
+      if (sp.active) continue;
+      sp.active        = true;
+      sp.triggerSample = at;
+      sp.chordIndex    = chordIndex;
+      sp.stringIndex   = stringIndex;
+      sp.velocityNorm  = vNorm;
+      return;
+    }
+  }
+
+  void startPluck(const ScheduledPluck &sp) {
+    const ge::Chord &ch = chords_[sp.chordIndex];
+    if (sp.stringIndex >= (int)ch.count) return;
+
+    float freq      = ge::midiToFreq(ch.notes[sp.stringIndex]) * detune_[sp.stringIndex];
+    float velScale  = Config::kVelRmsScaleMin
+                      + (Config::kVelRmsScaleMax - Config::kVelRmsScaleMin) * sp.velocityNorm;
+    voices_[sp.stringIndex].pluck(freq, Config::kKsDecay,
+                                  Config::kBaseNoiseTargetRms * velScale, noise_);
+  }
+
+  // 触发时间 ≤ 下一个要渲染的 sample 的 pluck 现在起音
+  void startDuePlucks() {
+    for (int i = 0; i < kMaxPlucks; ++i) {
+      ScheduledPluck &sp = plucks_[i];
+      if (sp.active && (int32_t)(sampleCounter_ - sp.triggerSample) >= 0) {
+        startPluck(sp);
+        sp.active = false;
+      }
+    }
+  }
+
+  int samplesUntilNextPluck(int maxSamples) const {
+    int n = maxSamples;
+    for (int i = 0; i < kMaxPlucks; ++i) {
+      const ScheduledPluck &sp = plucks_[i];
+      if (!sp.active) continue;
+      int32_t d = (int32_t)(sp.triggerSample - sampleCounter_);
+      if (d > 0 && d < n) n = (int)d;
+    }
+    return n;
+  }
+
+  float mix() {
+    float out    = 0.0f;
+    int   active = 0;
+    for (int i = 0; i < kStrings; ++i) {
+      if (voices_[i].active) {
+        out += voices_[i].process();
+        active++;
+      }
+    }
+    if constexpr (Config::kMixAverage) {
+      if (active > 0) out /= (float)active;
+    }
+    return out;
+  }
+
+  // 包络 + tone shaping（都在增益之前）
+  float shape(float out) {
+    if constexpr (Config::kPluckEnvelope) {
+      if (envSamples_ < kPluckSamples) envSamples_++;
+      float t = (float)envSamples_ / (float)kSampleRate;
+      if (t < Config::kAttackSec) {
+        out *= t / Config::kAttackSec;
+      } else if (t < Config::kPluckSec) {
+        out *= expf(-(t - Config::kAttackSec) / Config::kDecaySec);
+      } else {
+        out = 0.0f;
+      }
+    }
+    if constexpr (Config::kToneShaping) {
+      // 1) 低通得到“整体”，out - lpTone 是 presence
+      tone_.lpTone += Config::kLpToneAlpha * (out - tone_.lpTone);
+      float shaped  = (1.0f - Config::kPresenceMix) * out
+                      + Config::kPresenceMix * (out - tone_.lpTone);
+      // 2) 箱体共鸣（低频缓慢响应）
+      tone_.lpBody += Config::kBodyAlpha * (shaped - tone_.lpBody);
+      out = (1.0f - Config::kBodyMix) * shaped + Config::kBodyMix * tone_.lpBody;
+    }
+    return out;
+  }
+
+  // 切音“啪”（不参与混音平均，也不过包络 / 音色）
+  float chokeNoise() {
+    if constexpr (Config::kChokeMs > 0.0f) {
+      if (chokeLeft_ > 0) {
+        chokeLeft_--;
+        float n    = Config::kChokeAmp * chokeEnv_ * noise_.nextFloat();
+        chokeEnv_ *= chokeDecay_;
+        return n;
+      }
+    }
+    return 0.0f;
+  }
+
+  static float volumeAlpha(int frames) {
+    // 一阶平滑，时间常数 kVolumeSmoothMs，每块走一步
+    return 1.0f - expf(-(float)frames * 1000.0f
+                       / (Config::kVolumeSmoothMs * (float)kSampleRate));
+  }
+
+  static constexpr uint32_t kPluckSamples = (uint32_t)(Config::kPluckSec * kSampleRate) + 1;
+
+  Voice          voices_[kStrings];
+  ScheduledPluck plucks_[kMaxPlucks] = {};
+  float          detune_[kStrings];
+  ToneState      tone_;
+  ge::Noise      noise_;
+  const ge::Chord *chords_    = nullptr;
+  int            numChords_   = 0;
+  uint32_t       sampleCounter_ = 0;
+  uint32_t       envSamples_    = kPluckSamples;   // 开机时包络在“已结束”
+  float          volume_      = 1.0f;
+  float          gain_        = Config::kOutputGain;
+  int            chokeLeft_   = 0;
+  float          chokeEnv_    = 0.0f;
+  float          chokeDecay_  = 0.0f;
+};
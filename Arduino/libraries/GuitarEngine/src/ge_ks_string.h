@@ -0,0 +1,100 @@
+#pragma once
+//
+// ge_ks_string.h
+// ==============================
+// GuitarEngine 的 voice 类型：Karplus–Strong 单弦，延迟线长度和采样率来自 Config。
+//
+//   ge::KSString<Config>      平滑噪声激励 + RMS 归一化（按力度给目标 RMS）
+//   ge::KSStringRaw<Config>   原始 ±1 噪声激励，不归一（ksString1 / 2 的音色）
+//
+// 自己写 voice 类型时提供同样的成员即可：
+//   bool  active;
+//   void  pluck(float freq, float decay, float targetRms, Noise &noise);
+//   float process();
+//   template <typename F> void forEachState(F f) const;   // 给 scanState() 查 NaN / 非正规数
+//
+
+#include <math.h>
+#include "ge_noise.h"
+
+namespace ge {
+
+template <typename Config, bool kShapedExcitation = true>
+struct KSString {
+  float buffer[Config::kMaxDelay];
+  int   length;
+  int   index;
+  float decay;
+  float passPeak;     // 本圈输出的峰值，绕完一圈低于 kSilenceFloor 就停
+  bool  active = false;
+
+  void pluck(float freq, float decayIn, float targetRms, Noise &noise) {
+    if (freq <= 0.0f) {
+      active = false;
+      return;
+    }
+    int len = (int)((float)Config::kSampleRate / freq + 0.5f);
+    if (len < 2) len = 2;
+    if (len > Config::kMaxDelay) len = Config::kMaxDelay;
+
+    length   = len;
+    index    = 0;
+    decay    = decayIn;
+    passPeak = 0.0f;
+    active   = true;
+
+    if constexpr (kShapedExcitation) {
+      // 平滑一点，让起音更木、少毛刺；再按 RMS 归一，力度在感知上更线性
+      float prev  = 0.0f;
+      float sumSq = 0.0f;
+      for (int i = 0; i < len; ++i) {
+        prev      = 0.4f * noise.nextFloat() + 0.6f * prev;
+        buffer[i] = prev;
+        sumSq    += prev * prev;
+      }
+      if (sumSq > 1e-6f) {
+        float scale = targetRms / sqrtf(sumSq / (float)len);
+        for (int i = 0; i < len; ++i) {
+          buffer[i] *= scale;
+        }
+      }
+    } else {
+      (void)targetRms;
+      for (int i = 0; i < len; ++i) {
+        buffer[i] = noise.nextFloat();
+      }
+    }
+  }
+
+  float process() {
+    if (!active) return 0.0f;
+
+    int i0 = index;
+    int i1 = index + 1;
+    if (i1 >= length) i1 = 0;
+
+    float y = 0.5f * (buffer[i0] + buffer[i1]) * decay;
+
+    buffer[i0] = y;
+    index      = i1;
+
+    // 每绕一圈看一次：整圈都低于底噪就停掉，尾音不会衰减进非正规数
+    passPeak = fmaxf(passPeak, fabsf(y));
+    if (i1 == 0) {
+      if (passPeak < Config::kSilenceFloor) active = false;
+      passPeak = 0.0f;
+    }
+    return y;
+  }
+
+  template <typename F>
+  void forEachState(F f) const {
+    if (!active) return;
+    for (int i = 0; i < length; ++i) f(buffer[i]);
+  }
+};
+
+template <typename Config>
+using KSStringRaw = KSString<Config, false>;
+
+}  // namespace ge
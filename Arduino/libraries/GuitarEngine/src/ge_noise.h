@@ -0,0 +1,40 @@
+#pragma once
+//
+// ge_noise.h
+// ==============================
+// 可设种子的 xorshift32 白噪声（和 esp32_guitar_engine/noise_gen.h 同一个算法）。
+// 只用整数运算，同一个种子在主机和 ESP32 上序列完全一样；不依赖 Arduino random()。
+//
+
+#include <stdint.h>
+
+namespace ge {
+
+struct Noise {
+  uint32_t state = 0x6D2B79F5u;
+
+  void seed(uint32_t s) {
+    // splitmix32：相近的种子也得到差别很大的初始状态，且不会是 0
+    uint32_t z = s + 0x9E3779B9u;
+    z = (z ^ (z >> 16)) * 0x85EBCA6Bu;
+    z = (z ^ (z >> 13)) * 0xC2B2AE35u;
+    z ^= z >> 16;
+    state = (z != 0) ? z : 0x6D2B79F5u;
+  }
+
+  uint32_t next() {
+    uint32_t x = state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    state = x;
+    return x;
+  }
+
+  // [-1, 1)，16 位分辨率（和 random(-32768, 32767) / 32768 一样的量化）
+  float nextFloat() {
+    return (float)(int16_t)(next() >> 16) * (1.0f / 32768.0f);
+  }
+};
+
+}  // namespace ge
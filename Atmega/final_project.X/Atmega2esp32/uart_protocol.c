@@ -1,6 +1,7 @@
 #include <avr/io.h>
 #include <stdio.h>
 #include "./uart_protocol.h"
+#include "../Profiler/prof.h"
 
 // =========================
 // UART ????
@@ -34,6 +35,7 @@ void uart_protocol_init() {
 }
 
 void send_chord_gesture(const char* chord, const char* gesture, uint8_t strum_velocity) {
+    PROF_BEGIN(t0);
     char velocity_str[4];
     // uint8_t2char
     snprintf(velocity_str, sizeof(velocity_str), "%u", strum_velocity); 
@@ -44,4 +46,20 @@ void send_chord_gesture(const char* chord, const char* gesture, uint8_t strum_ve
     uart1_send_char('|');
     uart1_send_string(velocity_str);
     uart1_send_char('\n');
+    PROF_END(PROF_UART_TX, t0);
+}
+
+// SONG|SELECT|<n>\n : ESP32 switches the AutoKey song
+void send_song_select(uint8_t song) {
+    send_chord_gesture("SONG", "SELECT", song);
+}
+
+// TEMPO|SET|<bpm>\n : ESP32 pattern sequencer tempo
+void send_tempo(uint8_t bpm) {
+    send_chord_gesture("TEMPO", "SET", bpm);
+}
+
+// LOOP|TAP|0\n or LOOP|CLEAR|0\n : ESP32 event looper
+void send_loop(const char* action) {
+    send_chord_gesture("LOOP", action, 0);
 }
@@ -3,5 +3,8 @@
 
 void uart_protocol_init();
 void send_chord_gesture(const char* chord, const char* gesture, uint8_t strum_velocity);
+void send_song_select(uint8_t song);
+void send_tempo(uint8_t bpm);
+void send_loop(const char* action);
 
 #endif
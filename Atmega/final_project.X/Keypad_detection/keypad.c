@@ -5,8 +5,17 @@
 #include "../avr-printf-main/uart.h"
 
 static uint8_t current_group = 0;
+static uint8_t alt_both_latched = 0; // group 2 chosen, wait for both ALT keys up
 static char next_chord[10];
 static uint8_t autoplay_state = 0;
+static uint8_t song_hold = 0;        // Button4 held: keypad selects songs
+static char    song_key_latched = 0; // key already sent while Button4 held
+static int8_t  song_pending = -1;    // song index waiting for keypad_take_song()
+static uint8_t tempo_bpm = KEYPAD_TEMPO_DEFAULT;
+static uint8_t tempo_pending = 0;
+static uint8_t song_hold_used = 0;   // a key was used during this Button4 hold
+static uint8_t song_hold_scans = 0;  // scans since Button4 went down
+static uint8_t loop_pending = 0;     // 1 = tap, 2 = clear, for keypad_take_loop()
 
 static const char key_map[4][3] = {
     {'1','2','3'},
@@ -15,7 +24,7 @@ static const char key_map[4][3] = {
     {'*','0','#'}
 };
 
-const char* chord_map[2][12] = {
+const char* chord_map[KEYPAD_NUM_GROUPS][12] = {
     {   // Group 1: majors + dominant 7ths (0..11)
         "C",  "G",  "D",  "A",  "E",  "F",
         "C7", "G7", "D7", "A7", "E7", "B7"
@@ -23,6 +32,10 @@ const char* chord_map[2][12] = {
     {   // Group 2: minors + sus & dim (12..23)
         "Am",   "Em",   "Dm",   "Bm",   "F#m",  "Gm",
         "Dsus4","Gsus4","Asus4","Esus4","Bdim","F#dim"
+    },
+    {   // Group 3 (Button1 + Button2): maj7 / m7 / add9 / sus2 / 9 (24..35)
+        "Cmaj7","Gmaj7","Dmaj7","Fmaj7","Am7",  "Em7",
+        "Dm7",  "Bm7",  "Cadd9","Dsus2","Asus2","E9"
     }
 };
 
@@ -66,7 +79,9 @@ char keypad_scan()
             for (uint8_t c = 0; c < 3; c++) {
                 if (!(cols & (1 << c))) {
                     // Reset rows to high
-                    autoplay_state = 0;
+                    if (!song_hold) {
+                        autoplay_state = 0;
+                    }
                     ROW_PORT |= ROW_MASK;
                     return key_map[r][c];
                 }
@@ -76,6 +91,7 @@ char keypad_scan()
     
     // Reset rows to high (idle state)
     ROW_PORT |= ROW_MASK;
+    song_key_latched = 0;
     return '\0';
 }
 
@@ -83,24 +99,29 @@ void keypad_scan_group_buttons()
 {
     uint8_t btns = BTN_PIN;
 
-    // Button1 -> group 0
-    if (!(btns & BTN2_MASK)) {
-        _delay_ms(15); 
-        if (!(BTN_PIN & BTN2_MASK)) {   // check again
-            current_group = 0;
-            // printf("Button1 pressed, current group: %d\r\n", current_group);
-        }
-    }
-
-    // Button2 -> group 1
-    if (!(btns & BTN1_MASK)) {
+    // ALT keys: Button1 -> group 0, Button2 -> group 1, both -> group 2.
+    // The two are never pressed in the same scan, so group 2 stays latched
+    // until both are up again; releasing one first doesn't fall back.
+    uint8_t alt = 0;
+    if (!(btns & BTN2_MASK)) alt |= 0x01;   // Button1
+    if (!(btns & BTN1_MASK)) alt |= 0x02;   // Button2
+    if (alt) {
         _delay_ms(15);
-        if (!(BTN_PIN & BTN1_MASK)) {
-            current_group = 1;
-            // printf("Button2 pressed, current group: %d\r\n", current_group);
-        }
+        btns = BTN_PIN;                     // check again
+        if (btns & BTN2_MASK) alt &= ~0x01;
+        if (btns & BTN1_MASK) alt &= ~0x02;
     }
-    
+    if (alt == 0x03) {
+        current_group = 2;
+        alt_both_latched = 1;
+        // printf("Button1 + Button2 pressed, current group: %d\r\n", current_group);
+    } else if (alt == 0) {
+        alt_both_latched = 0;
+    } else if (!alt_both_latched) {
+        current_group = (alt == 0x01) ? 0 : 1;
+        // printf("Button%d pressed, current group: %d\r\n", alt, current_group);
+    }
+
 
     // Button3 -> autoplay
     if (!(btns & BTN3_MASK)) {
@@ -111,12 +132,26 @@ void keypad_scan_group_buttons()
         }
     }
 
-    // Button4 -> group 1
+    // Button4 (held) + keypad key -> song select
+    // Button4 alone: short press -> looper tap, long hold -> looper clear
     if (!(btns & BTN4_MASK)) {
         _delay_ms(15);
         if (!(BTN_PIN & BTN4_MASK)) {
-            // todo 
+            if (!song_hold) {
+                song_hold_used = 0;
+                song_hold_scans = 0;
+            }
+            song_hold = 1;
+            if (!song_hold_used && ++song_hold_scans >= KEYPAD_LOOP_CLEAR_SCANS) {
+                loop_pending = 2;
+                song_hold_used = 1;     // no tap on release
+            }
+        }
+    } else {
+        if (song_hold && !song_hold_used) {
+            loop_pending = 1;
         }
+        song_hold = 0;
     }
 }
 
@@ -145,9 +180,50 @@ void keypad_process(char key)
     default: index = -1; break;
 }
 
-    if (index >= 0) {
-        strcpy(next_chord, chord_map[current_group][index]);
+    if (index < 0) return;
+
+    if (song_hold) {
+        // keypad_scan() reports a held key on every scan: send it once
+        if (key == song_key_latched) return;
+        song_key_latched = key;
+        song_hold_used = 1;
+
+        if (key == '*' || key == '#') {
+            // '*' / '#' : tempo down / up
+            if (key == '*' && tempo_bpm >= KEYPAD_TEMPO_MIN + KEYPAD_TEMPO_STEP) {
+                tempo_bpm -= KEYPAD_TEMPO_STEP;
+            } else if (key == '#' && tempo_bpm <= KEYPAD_TEMPO_MAX - KEYPAD_TEMPO_STEP) {
+                tempo_bpm += KEYPAD_TEMPO_STEP;
+            }
+            tempo_pending = 1;
+        } else {
+            // '1'..'9' -> song 0..8, '0' -> song 9
+            song_pending = (key == '0') ? 9 : (int8_t)index;
+        }
+        return;
     }
+    strcpy(next_chord, chord_map[current_group][index]);
+}
+
+int8_t keypad_take_song(void)
+{
+    int8_t song = song_pending;
+    song_pending = -1;
+    return song;
+}
+
+uint8_t keypad_take_tempo(void)
+{
+    if (!tempo_pending) return 0;
+    tempo_pending = 0;
+    return tempo_bpm;
+}
+
+uint8_t keypad_take_loop(void)
+{
+    uint8_t action = loop_pending;
+    loop_pending = 0;
+    return action;
 }
 
 const char* keypad_get_chord()
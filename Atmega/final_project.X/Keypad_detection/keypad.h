@@ -26,7 +26,28 @@ char keypad_scan(void);
 void keypad_scan_group_buttons(void);
 uint8_t keypad_get_autoplay_state();
 
+// Chord groups: Button1 / Button2 pick 0 / 1, both together pick 2 (extended chords)
+#define KEYPAD_NUM_GROUPS 3
+
 void keypad_process(char key);
 const char* keypad_get_chord(void);
 
+// Pattern tempo (bpm) on the ESP32, changed with Button4 + '*' / '#'
+#define KEYPAD_TEMPO_DEFAULT 90   // = kPatternDefaultBpm in guitar_params.h
+#define KEYPAD_TEMPO_MIN     40
+#define KEYPAD_TEMPO_MAX     240
+#define KEYPAD_TEMPO_STEP    5
+
+// Button4 held + keypad key ('1'..'9' -> 0..8, '0' -> 9): song index, -1 if none
+int8_t keypad_take_song(void);
+// Button4 held + '*' / '#': new tempo in bpm, 0 if unchanged
+uint8_t keypad_take_tempo(void);
+
+// Button4 held this many scans with no keypad key -> looper clear
+// (each scan spends ~15 ms debouncing Button4, plus the IMU read)
+#define KEYPAD_LOOP_CLEAR_SCANS 60
+
+// Button4 alone: 1 = short press (looper tap), 2 = long hold (looper clear), 0 if none
+uint8_t keypad_take_loop(void);
+
 #endif
@@ -0,0 +1,138 @@
+#include "./prof.h"
+
+#ifdef PROF_ENABLE
+
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include <stdio.h>
+#include <string.h>
+
+#ifndef F_CPU
+#define F_CPU 16000000UL
+#endif
+
+#define CYCLES_PER_US (F_CPU / 1000000UL)
+
+struct prof_stats {
+    uint32_t sum;      // halved together with count before it would wrap
+    uint32_t min;
+    uint32_t max;
+    uint16_t count;
+};
+
+static struct {
+    struct prof_stats section[PROF_NUM_SECTIONS];
+    uint16_t imu_hist[PROF_IMU_BUCKETS];
+    uint32_t imu_last;     // timestamp of the previous IMU sample (0 = none yet)
+    uint32_t imu_min;
+    uint32_t imu_max;
+} prof;
+
+static volatile uint16_t prof_ovf = 0;
+
+static const char* const section_names[PROF_NUM_SECTIONS] = {
+    "loop", "keypad", "imu", "i2c", "uart tx"
+};
+
+ISR(TIMER1_OVF_vect)
+{
+    prof_ovf++;
+}
+
+void prof_init(void)
+{
+    TCCR1A = 0;
+    TCCR1B = (1 << CS10);          // clk/1, normal mode
+    TCNT1  = 0;
+    TIFR1  = (1 << TOV1);
+    TIMSK1 = (1 << TOIE1);
+    prof_reset();
+}
+
+uint32_t prof_now(void)
+{
+    uint8_t sreg = SREG;
+    cli();
+    uint16_t lo = TCNT1;
+    uint16_t hi = prof_ovf;
+    // overflow happened but the ISR has not run yet
+    if ((TIFR1 & (1 << TOV1)) && lo < 0x8000) {
+        hi++;
+    }
+    SREG = sreg;
+    return ((uint32_t)hi << 16) | lo;
+}
+
+void prof_end(uint8_t section, uint32_t start)
+{
+    uint32_t d = prof_now() - start;
+    struct prof_stats* s = &prof.section[section];
+
+    if (s->sum + d < s->sum || s->count == 0xFFFF) {
+        s->sum >>= 1;
+        s->count >>= 1;
+    }
+    s->sum += d;
+    s->count++;
+    if (d < s->min) s->min = d;
+    if (d > s->max) s->max = d;
+}
+
+void prof_imu_sample(void)
+{
+    uint32_t now = prof_now();
+    if (prof.imu_last != 0) {
+        uint32_t d  = now - prof.imu_last;
+        uint32_t ms = d / (F_CPU / 1000UL);
+        uint8_t  b  = 0;
+        while (ms > 0 && b < PROF_IMU_BUCKETS - 1) {
+            ms >>= 1;
+            b++;
+        }
+        if (prof.imu_hist[b] != 0xFFFF) prof.imu_hist[b]++;
+        if (d < prof.imu_min) prof.imu_min = d;
+        if (d > prof.imu_max) prof.imu_max = d;
+    }
+    prof.imu_last = now ? now : 1;
+}
+
+void prof_reset(void)
+{
+    memset(&prof, 0, sizeof(prof));
+    for (uint8_t i = 0; i < PROF_NUM_SECTIONS; i++) {
+        prof.section[i].min = 0xFFFFFFFFUL;
+    }
+    prof.imu_min = 0xFFFFFFFFUL;
+}
+
+void prof_dump(void)
+{
+    printf("Profile (cycles @ %lu MHz, us in brackets), %u B SRAM\r\n",
+           (unsigned long)CYCLES_PER_US, (unsigned)sizeof(prof));
+    for (uint8_t i = 0; i < PROF_NUM_SECTIONS; i++) {
+        const struct prof_stats* s = &prof.section[i];
+        if (s->count == 0) {
+            printf("  %-8s -\r\n", section_names[i]);
+            continue;
+        }
+        uint32_t avg = s->sum / s->count;
+        printf("  %-8s n=%u avg=%lu (%lu) min=%lu max=%lu (%lu)\r\n",
+               section_names[i], s->count,
+               avg, avg / CYCLES_PER_US, s->min, s->max, s->max / CYCLES_PER_US);
+    }
+
+    printf("  imu interval");
+    if (prof.imu_max == 0) {
+        printf(" -\r\n");
+        return;
+    }
+    printf(" min=%lu us max=%lu us\r\n",
+           prof.imu_min / CYCLES_PER_US, prof.imu_max / CYCLES_PER_US);
+    printf("    <1ms:%u", prof.imu_hist[0]);
+    for (uint8_t b = 1; b < PROF_IMU_BUCKETS - 1; b++) {
+        printf(" %u-%ums:%u", 1u << (b - 1), 1u << b, prof.imu_hist[b]);
+    }
+    printf(" >=%ums:%u\r\n", 1u << (PROF_IMU_BUCKETS - 2), prof.imu_hist[PROF_IMU_BUCKETS - 1]);
+}
+
+#endif
@@ -0,0 +1,56 @@
+#ifndef PROF_H
+#define PROF_H
+
+// Main-loop profiler on Timer1 (ATmega328PB, 16 MHz).
+//
+// Timer1 free-runs at clk/1, so one tick = one CPU cycle; its overflow
+// interrupt extends it to 32 bits (wraps after ~268 s). Each section keeps
+// count / min / max / average cycles, and every GuitarIMU_getStrum() call
+// records the interval since the previous one in a log2 histogram.
+//
+// Debug UART: 'p' dumps the results, 'z' clears them.
+//
+// Build with -DPROF_ENABLE (or uncomment the define below). Without it all
+// PROF_* macros are empty, prof.c compiles to nothing and Timer1 is left alone.
+
+// #define PROF_ENABLE
+
+#include <stdint.h>
+
+enum prof_section {
+    PROF_LOOP = 0,   // one main-loop iteration
+    PROF_KEYPAD,     // keypad scan + group buttons + key processing
+    PROF_IMU,        // GuitarIMU_getStrum(): I2C reads + strum detection
+    PROF_I2C,        // one 2-byte IMU register read
+    PROF_UART_TX,    // one frame to the ESP32 (UART1, blocking)
+    PROF_NUM_SECTIONS
+};
+
+// IMU interval histogram: bucket 0 < 1 ms, bucket k covers [2^(k-1), 2^k) ms,
+// the last bucket is everything longer
+#define PROF_IMU_BUCKETS 8
+
+#ifdef PROF_ENABLE
+
+void     prof_init(void);
+uint32_t prof_now(void);
+void     prof_end(uint8_t section, uint32_t start);
+void     prof_imu_sample(void);
+void     prof_dump(void);
+void     prof_reset(void);
+
+#define PROF_INIT()            prof_init()
+#define PROF_BEGIN(var)        uint32_t var = prof_now()
+#define PROF_END(section, var) prof_end((section), (var))
+#define PROF_IMU_SAMPLE()      prof_imu_sample()
+
+#else
+
+#define PROF_INIT()            ((void)0)
+#define PROF_BEGIN(var)        ((void)0)
+#define PROF_END(section, var) ((void)0)
+#define PROF_IMU_SAMPLE()      ((void)0)
+
+#endif
+
+#endif
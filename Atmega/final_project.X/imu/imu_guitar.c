@@ -5,7 +5,9 @@
 #include <stdlib.h>   // For abs()
 #include <stdbool.h>  // For bool types
 #include <avr/interrupt.h>
+#include <util/delay.h>
 #include "../avr-printf-main/uart.h"
+#include "../Profiler/prof.h"
 
 static uint8_t address;
 
@@ -16,12 +18,15 @@ void GuitarIMU_init(uint8_t addr) {
     IMU_init(address); //initial imu using the found I2C address from the 
     // previous task
     sei();
+    GuitarIMU_calibrate(); // hold the glove still for ~0.5 s after power-up
 }
 
 static int16_t read16(uint8_t reg) {
     uint8_t data[2];
     // ???? I2C ????
+    PROF_BEGIN(t0);
     NewI2C_readCompleteStream(data, address, reg, 2);
+    PROF_END(PROF_I2C, t0);
     // LSM6DSO ? little-endian?low ??
     return (int16_t) ((data[1] << 8) | data[0]);
 }
@@ -75,14 +80,20 @@ void GuitarIMU_readAll(int16_t* ax, int16_t* ay, int16_t* az,
 // =================================================================
 
 // --- GZ ???? (Directional Thresholds) ---
-#define GZ_BIAS                     416         // GZ ????????? (??)
-#define GX_BIAS                     -1000         // GZ ????????? (??)
-// Angular
-#define POSITIVE_THRESHOLD_RAW      10000       // GZ 14->15->13->10000
-#define NEGATIVE_THRESHOLD_RAW      -10000      // GZ -16->14->12->10
+// Gyro bias is no longer hard-coded: GuitarIMU_calibrate() measures it at
+// startup and the tracker below keeps following it while the hand is still.
+// These are only the fallback if the hand moved during calibration.
+#define DEFAULT_GX_BIAS             -1000
+#define DEFAULT_GY_BIAS             0
+#define DEFAULT_GZ_BIAS             416
+// Angular (relative to tracked bias: max(MIN, NOISE_K * noise floor))
+#define GZ_TRIGGER_MIN              8500        // GZ 10000 (absolute) -> 8500 (relative)
+#define GZ_TRIGGER_NOISE_K          32
+#define GY_TRIGGER_MIN              4200        // GY 5000 (absolute) -> 4200 (relative)
+#define GY_TRIGGER_NOISE_K          16
 #define GX_MAX      20000      // GX 13000->20000
-#define POSITIVE_THRESHOLD_GY      5000       // GY 8000-5000
-#define NEGATIVE_THRESHOLD_GY      -5000      // GY
+#define PALM_MUTE_GX_MIN            24500       // old raw GX_MAX + 3500 around GX bias
+#define PALM_MUTE_GZ_MAX            5000
 //Accelerate
 #define AX_MIN      -6000      // GX -1000->-10000->-6000
 // --- ???? (Kinetic Filter Threshold) ---
@@ -90,10 +101,134 @@ void GuitarIMU_readAll(int16_t* ax, int16_t* ay, int16_t* az,
 #define SQUARED_MAGNITUDE_THRESHOLD 650000000UL 
 
 // --- ???/???? ---
-// GZ ????????? (BIAS) ?????????????
-#define RESET_THRESHOLD             4000         
+// Swing ends once GZ (GX for palm mute) is back within this band around the
+// tracked bias. Used to be a fixed 4000 to tolerate drift between boards.
+#define RESET_MIN                   1500
+#define RESET_NOISE_K               8
 
+// --- Bias / noise tracking ---
+#define CALIB_SAMPLES               128         // samples per calibration pass
+#define CALIB_MAX_NOISE             600         // mean |dev| above this = hand moved
+#define STILL_THRESHOLD             1200        // |g - bias| below this on all axes = still
+#define STILL_HOLD_SAMPLES          16          // consecutive still samples before tracking
+#define BIAS_TRACK_SHIFT            7           // bias EMA: 1/128 per still sample
+#define NOISE_TRACK_SHIFT           6           // noise EMA: 1/64 per still sample
+#define NOISE_FLOOR_MIN             40          // never trust a noise floor below this
 
+// Q8 fixed point so the slow EMAs don't get stuck on integer rounding
+static int32_t bias_q8[3]  = { (int32_t)DEFAULT_GX_BIAS * 256,
+                               (int32_t)DEFAULT_GY_BIAS * 256,
+                               (int32_t)DEFAULT_GZ_BIAS * 256 };
+static int32_t noise_q8[3] = { (int32_t)NOISE_FLOOR_MIN * 256,
+                               (int32_t)NOISE_FLOOR_MIN * 256,
+                               (int32_t)NOISE_FLOOR_MIN * 256 };
+static uint8_t still_count = 0;
+
+// thresholds derived from the noise floor, refreshed by update_thresholds()
+static int16_t gz_trigger = GZ_TRIGGER_MIN;
+static int16_t gy_trigger = GY_TRIGGER_MIN;
+static int16_t reset_threshold = RESET_MIN;
+
+static int16_t clamp16(int32_t v) {
+    if (v > INT16_MAX) return INT16_MAX;
+    if (v < INT16_MIN) return INT16_MIN;
+    return (int16_t) v;
+}
+
+static int16_t noise_of(uint8_t axis) {
+    int16_t n = (int16_t) (noise_q8[axis] >> 8);
+    return (n < NOISE_FLOOR_MIN) ? NOISE_FLOOR_MIN : n;
+}
+
+static int16_t max16(int16_t a, int32_t b) {
+    return (b > a) ? clamp16(b) : a;
+}
+
+static void update_thresholds(void) {
+    gz_trigger = max16(GZ_TRIGGER_MIN, (int32_t) GZ_TRIGGER_NOISE_K * noise_of(2));
+    gy_trigger = max16(GY_TRIGGER_MIN, (int32_t) GY_TRIGGER_NOISE_K * noise_of(1));
+    int16_t n = (noise_of(0) > noise_of(2)) ? noise_of(0) : noise_of(2);
+    reset_threshold = max16(RESET_MIN, (int32_t) RESET_NOISE_K * n);
+}
+
+void GuitarIMU_calibrate(void) {
+    int32_t sum[3] = {0, 0, 0};
+    int32_t mean[3];
+    uint32_t dev[3] = {0, 0, 0};
+
+    // pass 1: mean
+    for (uint16_t i = 0; i < CALIB_SAMPLES; i++) {
+        sum[0] += GuitarIMU_readGyroX();
+        sum[1] += GuitarIMU_readGyroY();
+        sum[2] += GuitarIMU_readGyroZ();
+        _delay_ms(2);
+    }
+    for (uint8_t a = 0; a < 3; a++) {
+        mean[a] = sum[a] / CALIB_SAMPLES;
+    }
+
+    // pass 2: mean absolute deviation = noise floor
+    for (uint16_t i = 0; i < CALIB_SAMPLES; i++) {
+        dev[0] += (uint32_t) labs((int32_t) GuitarIMU_readGyroX() - mean[0]);
+        dev[1] += (uint32_t) labs((int32_t) GuitarIMU_readGyroY() - mean[1]);
+        dev[2] += (uint32_t) labs((int32_t) GuitarIMU_readGyroZ() - mean[2]);
+        _delay_ms(2);
+    }
+
+    for (uint8_t a = 0; a < 3; a++) {
+        uint32_t mad = dev[a] / CALIB_SAMPLES;
+        if (mad > CALIB_MAX_NOISE) {
+            // hand was moving: keep the defaults, tracker will catch up later
+            printf("IMU calib: axis %u noisy (%lu), using defaults\r\n", a, mad);
+            continue;
+        }
+        bias_q8[a] = mean[a] * 256;
+        noise_q8[a] = (int32_t) mad * 256;
+    }
+    still_count = 0;
+    update_thresholds();
+    GuitarIMU_printBias();
+}
+
+/**
+ * Follow slow gyro drift. Only runs while IDLE and the hand has been still
+ * for STILL_HOLD_SAMPLES in a row, so a swing never pulls the bias.
+ */
+static void track_bias(const int16_t raw[3], const int16_t diff[3]) {
+    if (abs(diff[0]) > STILL_THRESHOLD || abs(diff[1]) > STILL_THRESHOLD ||
+            abs(diff[2]) > STILL_THRESHOLD) {
+        still_count = 0;
+        return;
+    }
+    if (still_count < STILL_HOLD_SAMPLES) {
+        still_count++;
+        return;
+    }
+    for (uint8_t a = 0; a < 3; a++) {
+        bias_q8[a] += (((int32_t) raw[a] * 256) - bias_q8[a]) >> BIAS_TRACK_SHIFT;
+        noise_q8[a] += (((int32_t) abs(diff[a]) * 256) - noise_q8[a]) >> NOISE_TRACK_SHIFT;
+    }
+    update_thresholds();
+}
+
+void GuitarIMU_getBias(int16_t* gx, int16_t* gy, int16_t* gz) {
+    *gx = (int16_t) (bias_q8[0] >> 8);
+    *gy = (int16_t) (bias_q8[1] >> 8);
+    *gz = (int16_t) (bias_q8[2] >> 8);
+}
+
+void GuitarIMU_getNoise(int16_t* gx, int16_t* gy, int16_t* gz) {
+    *gx = noise_of(0);
+    *gy = noise_of(1);
+    *gz = noise_of(2);
+}
+
+void GuitarIMU_printBias(void) {
+    printf("IMU bias gx=%d gy=%d gz=%d  noise gx=%d gy=%d gz=%d\r\n",
+            (int) (bias_q8[0] >> 8), (int) (bias_q8[1] >> 8), (int) (bias_q8[2] >> 8),
+            noise_of(0), noise_of(1), noise_of(2));
+    printf("IMU thr gz=%d gy=%d reset=%d\r\n", gz_trigger, gy_trigger, reset_threshold);
+}
 
 typedef enum {
     IDLE, // ?????????
@@ -146,17 +281,23 @@ uint8_t map_velocity(uint32_t peak_mag_sq) {
  * @brief ?? GZ ???????????????
  */
 const char* GuitarIMU_getStrum(uint8_t* velocity_out) {
-    
+    PROF_IMU_SAMPLE();
     int16_t raw_ax = GuitarIMU_readAccX();
-    int16_t raw_gx = GuitarIMU_readGyroX();
-    int16_t raw_gy = GuitarIMU_readGyroY();
-    int16_t raw_gz = GuitarIMU_readGyroZ(); // ??? GZ ??????
-    //    printf("%d,%d,%d;\n",raw_gx, raw_gy, raw_gz);
-    // 1. ??????????? (Squared Magnitude)
-    uint32_t mag_sq = calculate_gyro_mag_squared(raw_gx, raw_gy, raw_gz);
-    // 2. ??????? GZ ?????????
-    int16_t gz_diff = raw_gz - GZ_BIAS;
-    int16_t gx_diff = raw_gx - GX_BIAS;
+    int16_t raw[3];
+    raw[0] = GuitarIMU_readGyroX();
+    raw[1] = GuitarIMU_readGyroY();
+    raw[2] = GuitarIMU_readGyroZ(); // ??? GZ ??????
+    //    printf("%d,%d,%d;\n",raw[0], raw[1], raw[2]);
+    // 1. everything below works on bias-removed rates
+    int16_t diff[3];
+    for (uint8_t a = 0; a < 3; a++) {
+        diff[a] = clamp16((int32_t) raw[a] - (bias_q8[a] >> 8));
+    }
+    int16_t gx_diff = diff[0];
+    int16_t gy_diff = diff[1];
+    int16_t gz_diff = diff[2];
+    // 2. ??????????? (Squared Magnitude)
+    uint32_t mag_sq = calculate_gyro_mag_squared(gx_diff, gy_diff, gz_diff);
     
     const char* detected_strum = NULL; // ?????????
     
@@ -202,30 +343,33 @@ const char* GuitarIMU_getStrum(uint8_t* velocity_out) {
 switch (current_state) {
         case IDLE:
             // ????: 1. ????? AND 2. ???????
-            if (mag_sq > SQUARED_MAGNITUDE_THRESHOLD && abs(raw_gx) < GX_MAX && raw_ax>AX_MIN ) {
+            if (mag_sq > SQUARED_MAGNITUDE_THRESHOLD && abs(gx_diff) < GX_MAX && raw_ax>AX_MIN ) {
                 // ???? -> DOWNSTROKE (???) - ????
-                if (raw_gz < NEGATIVE_THRESHOLD_RAW && raw_gy > POSITIVE_THRESHOLD_GY ) {
+                if (gz_diff < -gz_trigger && gy_diff > gy_trigger ) {
                     pending_strum_direction = "STRUM_DOWN";
                     current_state = SWING_DOWN;
                     current_mag_sq_peak = mag_sq;
 //                    *velocity_out = map_velocity(raw_gz);
                     // ???? -> UPSTROKE (???) - ????
-                } else if (raw_gz > POSITIVE_THRESHOLD_RAW && raw_gy < NEGATIVE_THRESHOLD_RAW ) {
+                } else if (gz_diff > gz_trigger && gy_diff < -gy_trigger ) {
                     pending_strum_direction = "STRUM_UP";
                     current_state = SWING_UP;
                     current_mag_sq_peak = mag_sq;
 //                    *velocity_out = map_velocity(raw_gz);
                 } 
-            } else if (mag_sq > SQUARED_MAGNITUDE_THRESHOLD && raw_gx > GX_MAX + 3500 && raw_gz < 5000 ) {
+            } else if (mag_sq > SQUARED_MAGNITUDE_THRESHOLD && gx_diff > PALM_MUTE_GX_MIN && gz_diff < PALM_MUTE_GZ_MAX ) {
                     pending_strum_direction = "PALM_MUTE";
                     current_state = PALM_MUTE;
 //                    *velocity_out = map_velocity(raw_gz);
+                } else if (mag_sq <= SQUARED_MAGNITUDE_THRESHOLD) {
+                    // not swinging: let the bias follow drift
+                    track_bias(raw, diff);
                 }
             break;
         case SWING_DOWN:
         case SWING_UP:
             // ?? GZ ?????? BIAS ???????????
-            if (abs(gz_diff) < RESET_THRESHOLD) {
+            if (abs(gz_diff) < reset_threshold) {
                 current_state = IDLE;
                 // trigger strum & calculate velocity
                 detected_strum = pending_strum_direction; 
@@ -236,7 +380,7 @@ switch (current_state) {
             }
             break;
         case PALM_MUTE:  
-          if (abs(gx_diff) < RESET_THRESHOLD) {
+          if (abs(gx_diff) < reset_threshold) {
                 current_state = IDLE;
                 // trigger strum & calculate velocity
                 detected_strum = pending_strum_direction; 
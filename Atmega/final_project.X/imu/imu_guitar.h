@@ -42,4 +42,19 @@ void GuitarIMU_readAll(int16_t* accX, int16_t* accY, int16_t* accZ,
  */
 const char* GuitarIMU_getStrum(uint8_t* velocity_out);
 
+/**
+ * @brief Startup gyro calibration: measures bias and noise floor on all three
+ *        axes. Called from GuitarIMU_init(); the glove must be held still.
+ * @note  If the hand moves during calibration the axis keeps its default bias
+ *        and the online tracker converges once the hand is still.
+ */
+void GuitarIMU_calibrate(void);
+
+/** Current tracked gyro bias / noise floor (raw LSB). */
+void GuitarIMU_getBias(int16_t* gx, int16_t* gy, int16_t* gz);
+void GuitarIMU_getNoise(int16_t* gx, int16_t* gy, int16_t* gz);
+
+/** Print bias, noise floor and the derived thresholds on the debug UART. */
+void GuitarIMU_printBias(void);
+
 #endif // IMU_GUITAR_H
\ No newline at end of file
@@ -4,36 +4,88 @@
 #include "./Keypad_detection/keypad.h"
 #include "./Atmega2esp32/uart_protocol.h"
 #include "./imu/imu_guitar.h"    // IMU API ???
+#include "./Profiler/prof.h"
 #include "./avr-printf-main/uart.h"          // ???
 
 #define IMU_ADDR 0x6B      // IMU I2C Address
 
+// Debug UART (USART0) commands, one char, non-blocking:
+//   b : print gyro bias / noise floor / thresholds
+//   c : re-run gyro calibration (hold the glove still)
+//   p : dump the main-loop profile (PROF_ENABLE builds only)
+//   z : clear the profile
+static void debug_uart_poll(void)
+{
+    if (!(UCSR0A & (1 << RXC0))) {
+        return;
+    }
+    char c = UDR0;
+    if (c == 'b') {
+        GuitarIMU_printBias();
+    } else if (c == 'c') {
+        GuitarIMU_calibrate();
+    }
+#ifdef PROF_ENABLE
+    else if (c == 'p') {
+        prof_dump();
+    } else if (c == 'z') {
+        prof_reset();
+    }
+#endif
+}
+
 int main(void)
 {
     uart_init();
     keypad_init();
     GuitarIMU_init(IMU_ADDR);  // ??? GuitarIMU API
     uart_protocol_init();
+    UCSR0B |= (1 << RXEN0);    // debug UART also listens for debug_uart_poll()
+    PROF_INIT();
     
     while (1)
     {
+        PROF_BEGIN(t_loop);
+        debug_uart_poll();
+
         /** get chord and additional func---- **/
+        PROF_BEGIN(t_keypad);
         char key = keypad_scan();
         keypad_scan_group_buttons();
         if (key) {
             keypad_process(key);
         }
+        PROF_END(PROF_KEYPAD, t_keypad);
+        int8_t song = keypad_take_song();
+        if (song >= 0) {
+            send_song_select((uint8_t)song);
+            printf("Song=%d\r\n", song);
+        }
+        uint8_t tempo = keypad_take_tempo();
+        if (tempo) {
+            send_tempo(tempo);
+            printf("Tempo=%u\r\n", tempo);
+        }
+        uint8_t loop_action = keypad_take_loop();
+        if (loop_action) {
+            const char* action = (loop_action == 2) ? "CLEAR" : "TAP";
+            send_loop(action);
+            printf("Loop=%s\r\n", action);
+        }
         const char* chord = keypad_get_chord();
 //        uint8_t TBD = keypad_get_autoplay_state(); //TBD
 
         /** IMU gesture **/
         uint8_t strum_velocity = 0;
+        PROF_BEGIN(t_imu);
         const char* gesture = GuitarIMU_getStrum(&strum_velocity);
+        PROF_END(PROF_IMU, t_imu);
         
         
         if (gesture) {
             send_chord_gesture(chord, gesture, strum_velocity);
             printf("Chord=%s,  Gesture=%s, Velocity=%d\r\n",chord, gesture, strum_velocity); 
         }
+        PROF_END(PROF_LOOP, t_loop);
     }
 }